@@ -0,0 +1,234 @@
+#include "AgentStore.h"
+#include "Grid.h"
+#include "Player.h"
+#include "MovePlan.h"
+#include "ResourceCache.h"
+#include "Trace.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    sf::Vector2i delta(int d)
+    {
+        switch ((Direction)d) {
+            case Direction::Up:    return {0, -1};
+            case Direction::Down:  return {0, 1};
+            case Direction::Left:  return {-1, 0};
+            default:               return {1, 0};
+        }
+    }
+
+    std::uint8_t bitFor(sf::Vector2i dir)
+    {
+        if (dir.y < 0) return 1u << (int)Direction::Up;
+        if (dir.y > 0) return 1u << (int)Direction::Down;
+        if (dir.x < 0) return 1u << (int)Direction::Left;
+        return 1u << (int)Direction::Right;
+    }
+}
+
+AgentStore::AgentStore()
+{
+    loadTextures();
+}
+
+void AgentStore::loadTextures()
+{
+    // the Player's own textures from the ResourceCache (same left/right swap), indexed by Direction
+    auto tex = ResourceCache::textures({
+        {"assets/Player_Up.png", {}},
+        {"assets/Player_Down.png", {}},
+        {"assets/Player_Right.png", {}},
+        {"assets/Player_Left.png", {}},
+    });
+
+    sf::Image images[4];
+    unsigned width = 0, height = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (tex[i]->getSize().x && tex[i]->getSize().y) images[i] = tex[i]->copyToImage();
+        width += images[i].getSize().x;
+        height = std::max(height, images[i].getSize().y);
+    }
+
+    sf::Image sheet({std::max(width, 1u), std::max(height, 1u)}, sf::Color::Transparent);
+    unsigned x = 0;
+    for (int i = 0; i < 4; ++i) {
+        sf::Vector2u s = images[i].getSize();
+        if (s.x && s.y && !sheet.copy(images[i], {x, 0})) std::cerr << "Error: building the ghost atlas\n";
+        frames[i] = sf::FloatRect({(float)x, 0.f}, {(float)s.x, (float)s.y});
+        x += s.x;
+    }
+    if (!atlas.loadFromImage(sheet)) std::cerr << "Error: ghost atlas texture\n";
+}
+
+void AgentStore::clear()
+{
+    posX.clear(); posY.clear();
+    facing.clear(); alive.clear(); finishes.clear();
+    cursor.clear(); planEnd.clear(); tint.clear();
+    blockCount.clear(); blockX.clear(); blockY.clear();
+    plans.clear();
+    live = finished = busy = 0;
+}
+
+void AgentStore::reserve(int agents, std::size_t planBytes)
+{
+    posX.reserve(agents); posY.reserve(agents);
+    facing.reserve(agents); alive.reserve(agents); finishes.reserve(agents);
+    cursor.reserve(agents); planEnd.reserve(agents); tint.reserve(agents);
+    blockCount.reserve(agents); blockX.reserve(agents * MaxBlocks); blockY.reserve(agents * MaxBlocks);
+    plans.reserve(planBytes);
+}
+
+void AgentStore::add(sf::Vector2i start, const std::uint8_t* plan, std::size_t length, sf::Color color, bool done)
+{
+    posX.push_back((std::int16_t)start.x);
+    posY.push_back((std::int16_t)start.y);
+    facing.push_back((std::uint8_t)Direction::Up);
+    alive.push_back(1);
+    finishes.push_back(done ? 1 : 0);
+    cursor.push_back((std::uint32_t)plans.size());
+    plans.insert(plans.end(), plan, plan + length);
+    planEnd.push_back((std::uint32_t)plans.size());
+    tint.push_back(color);
+    blockCount.push_back(0);
+    blockX.resize(blockX.size() + MaxBlocks);
+    blockY.resize(blockY.size() + MaxBlocks);
+
+    ++live;
+    int i = size() - 1;
+    readBlocks(i);
+    if (hasMoves(i)) ++busy;
+    if (done && planDone(i)) ++finished;
+}
+
+void AgentStore::beginTurn()
+{
+    busy = 0;
+    for (int i = 0; i < size(); ++i) {
+        if (!alive[i]) continue;
+        std::uint32_t c = cursor[i], end = planEnd[i];
+        while (c != end && plans[c] != TurnBreak) c += plans[c] == BlockOp ? 3 : 1;   // what an early turn end cut off
+        if (c < end) ++c;
+        cursor[i] = std::min(c, end);
+        readBlocks(i);
+        if (hasMoves(i)) ++busy;
+    }
+}
+
+void AgentStore::readBlocks(int i)
+{
+    int n = 0;
+    std::uint32_t c = cursor[i];
+    while (c + 2 < planEnd[i] && plans[c] == BlockOp) {
+        if (n < MaxBlocks) {
+            blockX[i * MaxBlocks + n] = plans[c + 1];
+            blockY[i * MaxBlocks + n] = plans[c + 2];
+            ++n;
+        }
+        c += 3;
+    }
+    cursor[i] = c;
+    blockCount[i] = (std::uint8_t)n;
+}
+
+bool AgentStore::ownBlock(int i, int x, int y) const
+{
+    for (int k = 0; k < blockCount[i]; ++k)
+        if (blockX[i * MaxBlocks + k] == x && blockY[i * MaxBlocks + k] == y) return true;
+    return false;
+}
+
+bool AgentStore::shielded(int i, sf::Vector2i p, unsigned from, const Grid& grid) const
+{
+    // every hazard passing through p must have one of the ghost's blocks between it and its
+    // cannon / laser (walking back against its direction of travel; shots pass over other
+    // hazards' cells, so only a hazard firing this way ends the walk)
+    const LevelData& level = *grid.getLevel();
+    auto firesFrom = [&](sf::Vector2i q, int d) {
+        for (const Hazard& hz : level.hazards)
+            if (hz.pos == q && bitFor(hz.info().dir) == (1u << d)) return true;
+        return false;
+    };
+    for (int d = 0; d < 4; ++d) {
+        if (!(from & (1u << d))) continue;
+        sf::Vector2i back = -delta(d);
+        bool covered = false;
+        for (sf::Vector2i q = p + back; level.inBounds(q) && !firesFrom(q, d); q += back)
+            if (ownBlock(i, q.x, q.y)) { covered = true; break; }
+        if (!covered) return false;
+    }
+    return true;
+}
+
+void AgentStore::step(const Grid& grid)
+{
+    TRACE_SCOPE("AgentStore::step");
+    sf::IntRect board = grid.getBounds();
+    int w = board.size.x;
+
+    // mark the deadly cells once, with the direction the danger travels in (for block shielding)
+    danger.assign((std::size_t)w * board.size.y, 0);
+    auto at = [&](sf::Vector2i p) -> std::uint8_t& { return danger[(std::size_t)p.y * w + (p.x - board.position.x)]; };
+
+    const LevelData& level = *grid.getLevel();
+    const std::vector<int>& lengths = grid.getBeamLengths();
+    for (size_t h = 0; h < level.hazards.size(); ++h) {
+        const Hazard& hz = level.hazards[h];
+        if (!hz.info().laser) continue;
+        sf::Vector2i dir = hz.info().dir;
+        sf::Vector2i c = hz.pos;
+        for (int k = 0; k < lengths[h]; ++k) {
+            c += dir;
+            at(c) |= bitFor(dir);
+        }
+    }
+    for (const Projectile& p : grid.getProjectiles())
+        if (p.alive && board.contains(p.pos)) at(p.pos) |= bitFor(p.dir);
+
+    busy = 0;
+    for (int i = 0; i < size(); ++i) {
+        if (!alive[i] || !hasMoves(i)) continue;
+
+        Direction d = (Direction)plans[cursor[i]++];
+        sf::Vector2i next = Player::stepFrom({posX[i], posY[i]}, d, board);
+        if (!grid.isBlocked(next) && !ownBlock(i, next.x, next.y)) {   // a blocked move is used up in place, like the player's
+            posX[i] = (std::int16_t)next.x;
+            posY[i] = (std::int16_t)next.y;
+            facing[i] = (std::uint8_t)d;
+        }
+
+        sf::Vector2i p{posX[i], posY[i]};
+        unsigned hit = at(p);
+        if (hit && !shielded(i, p, hit, grid)) {
+            alive[i] = 0;
+            --live;
+            continue;
+        }
+        if (planDone(i)) finished += finishes[i];
+        else if (hasMoves(i)) ++busy;
+    }
+}
+
+void AgentStore::buildVertices(sf::VertexArray& out) const
+{
+    TRACE_SCOPE("AgentStore::buildVertices");
+    out.setPrimitiveType(sf::PrimitiveType::Triangles);
+    out.resize((std::size_t)live * 6);
+
+    std::size_t n = 0;
+    for (int i = 0; i < size() && n < out.getVertexCount(); ++i) {
+        if (!alive[i]) continue;
+        float x = (float)posX[i] * CellSize, y = (float)posY[i] * CellSize;
+        const sf::FloatRect& f = frames[facing[i]];
+        sf::Vector2f t0 = f.position, t1 = f.position + f.size;
+        sf::Color c = tint[i];
+
+        sf::Vertex a{{x, y}, c, t0};
+        sf::Vertex b{{x + CellSize, y}, c, {t1.x, t0.y}};
+        sf::Vertex cc{{x + CellSize, y + CellSize}, c, t1};
+        sf::Vertex d{{x, y + CellSize}, c, {t0.x, t1.y}};
+        out[n++] = a; out[n++] = b; out[n++] = cc;
+        out[n++] = a; out[n++] = cc; out[n++] = d;
+    }
+}
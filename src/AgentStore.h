@@ -0,0 +1,84 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Config.h"
+
+class Grid;
+
+// AgentStore: the race-mode ghosts, kept as parallel arrays (struct of arrays) instead of one
+// Player object each. Every ghost replays a fixed plan, a byte stream per ghost:
+//   0..3              a move (Direction)
+//   BlockOp, x, y     a block for this turn (only at the start of a turn)
+//   TurnBreak         end of the turn
+// All ghosts are stepped in one pass per execution tick against the grid's shared hazard state
+// and drawn as a single vertex array over one texture. A ghost's blocks are its own: they stop its
+// moves and shield it from beams / cannonballs coming from the far side, but the shared board
+// never sees them.
+class AgentStore {
+public:
+    static constexpr std::uint8_t TurnBreak = 0xFF;
+    static constexpr std::uint8_t BlockOp = 0xFE;
+    static constexpr int MaxBlocks = 4;   // per ghost per turn (more are ignored)
+
+    AgentStore();
+
+    void clear();
+    void reserve(int agents, std::size_t planBytes);
+
+    // `plan` is copied. `finishes` = the plan clears the level if the ghost survives it.
+    void add(sf::Vector2i start, const std::uint8_t* plan, std::size_t length, sf::Color tint, bool finishes);
+
+    // a new planning turn: every ghost drops what's left of its current turn and moves on to the next
+    void beginTurn();
+
+    // one execution tick: every live ghost with moves left this turn takes one step, and dies
+    // if it ends up in a beam or on a cannonball its own blocks don't shield it from
+    void step(const Grid& grid);
+
+    // some live ghost still has moves queued for this turn
+    bool moving() const { return busy > 0; }
+
+    // the live ghosts as textured triangles (6 vertices each) over texture(); `out` keeps its
+    // capacity, so this stops allocating once it has seen the full field. The render thread
+    // draws them with one call.
+    void buildVertices(sf::VertexArray& out) const;
+    const sf::Texture& texture() const { return atlas; }
+
+    int size() const { return (int)alive.size(); }
+    int aliveCount() const { return live; }
+    int finishedCount() const { return finished; }
+
+private:
+    void loadTextures();
+    void readBlocks(int i);   // take the BlockOps at the cursor as ghost i's blocks for this turn
+    bool ownBlock(int i, int x, int y) const;
+    bool shielded(int i, sf::Vector2i p, unsigned from, const Grid& grid) const;
+    bool hasMoves(int i) const { return cursor[i] != planEnd[i] && plans[cursor[i]] != TurnBreak; }
+    bool planDone(int i) const { return cursor[i] == planEnd[i] || (cursor[i] + 1 == planEnd[i] && plans[cursor[i]] == TurnBreak); }
+
+    // per ghost
+    std::vector<std::int16_t> posX, posY;
+    std::vector<std::uint8_t> facing;     // Direction, picks the atlas frame
+    std::vector<std::uint8_t> alive;
+    std::vector<std::uint8_t> finishes;
+    std::vector<std::uint32_t> cursor;    // next byte in `plans`
+    std::vector<std::uint32_t> planEnd;
+    std::vector<sf::Color> tint;
+    std::vector<std::uint8_t> blockCount;
+    std::vector<std::int16_t> blockX, blockY;   // MaxBlocks per ghost
+
+    std::vector<std::uint8_t> plans;      // every ghost's plan, back to back
+    int live = 0;
+    int finished = 0;
+    int busy = 0;
+
+    // per board cell, the directions hazards are travelling through it this tick (bit per
+    // Direction; board-sized, rebuilt every step), so each ghost is a single lookup
+    std::vector<std::uint8_t> danger;
+
+    // the four player frames side by side, so every ghost shares one texture
+    sf::Texture atlas;
+    std::array<sf::FloatRect, 4> frames;
+};
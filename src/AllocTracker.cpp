@@ -0,0 +1,71 @@
+#include "AllocTracker.h"
+
+#ifdef TRACK_ALLOCS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<std::uint64_t> allocCount[AllocTracker::MaxSubsystems];
+    std::atomic<std::uint64_t> allocBytes[AllocTracker::MaxSubsystems];
+    thread_local int currentSubsystem = 0;
+
+    void* countedAlloc(std::size_t size)
+    {
+        int s = currentSubsystem;
+        allocCount[s].fetch_add(1, std::memory_order_relaxed);
+        allocBytes[s].fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+}
+
+namespace AllocTracker {
+
+int enter(int subsystem)
+{
+    int prev = currentSubsystem;
+    if (subsystem >= 0 && subsystem < MaxSubsystems) currentSubsystem = subsystem;
+    return prev;
+}
+
+void leave(int previous)
+{
+    currentSubsystem = previous;
+}
+
+void snapshot(Snapshot& out)
+{
+    for (int i = 0; i < MaxSubsystems; ++i) {
+        out.perSubsystem[i].allocs = allocCount[i].load(std::memory_order_relaxed);
+        out.perSubsystem[i].bytes = allocBytes[i].load(std::memory_order_relaxed);
+    }
+}
+
+}
+
+// ---------------- Global operator replacements ----------------
+
+void* operator new(std::size_t size)
+{
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif
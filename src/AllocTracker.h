@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation accounting.
+//
+// Build with -DTRACK_ALLOCS to replace the global operator new/delete with
+// counting versions. Allocations are attributed to the "subsystem" that is
+// current on the allocating thread (set with enter/leave, which FrameProfiler
+// does for every ProfileStage). Without the define all of this is a no-op.
+//
+// Add -DTRACK_ALLOCS_STRICT as well to abort() on the first allocation in a
+// steady-state gameplay frame (see Game::checkSteadyStateAllocs).
+
+namespace AllocTracker {
+    constexpr int MaxSubsystems = 8; // 0 = untagged, 1.. = ProfileStage + 1
+    constexpr int Background = MaxSubsystems - 1; // worker threads (not charged to any frame)
+
+    struct Counters {
+        std::uint64_t allocs = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    // cumulative counters since process start (all threads)
+    struct Snapshot {
+        Counters perSubsystem[MaxSubsystems];
+    };
+
+#ifdef TRACK_ALLOCS
+    constexpr bool Enabled = true;
+
+    int enter(int subsystem);   // make subsystem current on this thread, returns the previous one
+    void leave(int previous);   // restore what enter() returned
+    void snapshot(Snapshot& out);
+#else
+    constexpr bool Enabled = false;
+
+    inline int enter(int) { return 0; }
+    inline void leave(int) {}
+    inline void snapshot(Snapshot&) {}
+#endif
+}
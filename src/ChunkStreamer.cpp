@@ -0,0 +1,202 @@
+#include "ChunkStreamer.h"
+#include "Trace.h"
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+    const int MaxAttempts = 6;   // the last attempt carves a guaranteed corridor
+
+    std::uint32_t mix(std::uint32_t h)
+    {
+        // murmur3 finalizer: cheap, well spread
+        h ^= h >> 16; h *= 0x85EBCA6Bu;
+        h ^= h >> 13; h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // while generating, hazards keep their direction char so they can be told apart
+    bool isWall(char c) { return c == 'T' || c == '~' || c == '>' || c == '<' || c == 'v' || c == '^'; }
+}
+
+// ---------------- Jobs ----------------
+
+ChunkStreamer::~ChunkStreamer()
+{
+    // jobs write into this object, so they have to be gone before it is
+    if (jobs) {
+        jobs->cancel();
+        JobSystem::instance().wait(*jobs);
+    }
+}
+
+void ChunkStreamer::start(std::uint32_t s, int r, int firstColumn)
+{
+    // queued columns of the old run are skipped; at most the ones already running are waited for
+    if (jobs) {
+        jobs->cancel();
+        JobSystem::instance().wait(*jobs);
+    }
+    jobs = JobSystem::instance().makeGroup();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    seed = s;
+    rows = r;
+    horizon = firstColumn;
+    ready.clear();
+}
+
+void ChunkStreamer::requestUpTo(int column)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    for (; horizon < column; ++horizon) {
+        int c = horizon;
+        std::uint32_t sd = seed;
+        int r = rows;
+        JobSystem::instance().submit([this, c, sd, r]{
+            auto col = generate(sd, r, c);
+            std::lock_guard<std::mutex> lock(mtx);
+            ready[c] = std::move(col);
+        }, jobs);
+    }
+}
+
+std::shared_ptr<const ChunkColumn> ChunkStreamer::tryTake(int column)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = ready.find(column);
+    if (it == ready.end()) return nullptr;
+
+    auto col = std::move(it->second);
+    ready.erase(ready.begin(), std::next(it));
+    return col;
+}
+
+// ---------------- Generation ----------------
+
+int ChunkStreamer::entryRow(std::uint32_t seed, int rows, int column)
+{
+    if (column <= 0) return rows - 1;   // runs start bottom-left like the campaign
+    return (int)(mix(seed ^ ((std::uint32_t)column * 0x9E3779B9u)) % (std::uint32_t)rows);
+}
+
+std::shared_ptr<const ChunkColumn> ChunkStreamer::generate(std::uint32_t seed, int rows, int column)
+{
+    TRACE_SCOPE("ChunkStreamer::generate");
+    const int W = ChunkSize;
+    const int x0 = column * ChunkSize;
+    const int in = entryRow(seed, rows, column);
+    const int out = entryRow(seed, rows, column + 1);
+
+    std::vector<char> cells((size_t)rows * W);
+    std::vector<char> reached((size_t)rows * W);
+    std::vector<int> queue;
+    queue.reserve(cells.size());
+    auto at = [&](int x, int y) -> char& { return cells[(size_t)y * W + x]; };
+
+    for (int attempt = 0; attempt < MaxAttempts; ++attempt)
+    {
+        std::mt19937 rng(mix(seed ^ ((std::uint32_t)column * 0x85EBCA6Bu) ^ ((std::uint32_t)attempt * 0xC2B2AE35u)));
+        auto roll = [&rng](int n) { return (int)(rng() % (std::uint32_t)n); };
+
+        std::fill(cells.begin(), cells.end(), '.');
+
+        // terrain: scattered trees + a few water ponds
+        for (char& c : cells)
+            if (roll(100) < 10) c = 'T';
+        for (int pond = roll(3); pond > 0; --pond) {
+            int cx = roll(W), cy = roll(rows), r = 1 + roll(2);
+            for (int y = std::max(0, cy - r); y <= std::min(rows - 1, cy + r); ++y)
+                for (int x = std::max(0, cx - r); x <= std::min(W - 1, cx + r); ++x)
+                    if (std::abs(x - cx) + std::abs(y - cy) <= r) at(x, y) = '~';
+        }
+
+        // hazards get more frequent further out (the first column stays calm)
+        int hazards = column == 0 ? 0 : std::min(1 + column / 3, 4);
+        for (int h = 0; h < hazards; ++h) {
+            int kind = roll(4);
+            int x = roll(W), y = roll(rows);
+            char c = '>';
+            if (kind == 0) c = '>';
+            else if (kind == 1) c = '<';
+            else if (kind == 2) { c = 'v'; y = 0; }
+            else { c = '^'; y = rows - 1; }
+            if (at(x, y) == '.') at(x, y) = c;
+        }
+
+        // chests
+        for (int n = 2 + roll(3); n > 0; --n) {
+            int x = roll(W), y = roll(rows);
+            if (at(x, y) == '.') at(x, y) = 'I';
+        }
+
+        // the last attempt carves a corridor in -> middle -> out so validation can't fail
+        if (attempt == MaxAttempts - 1) {
+            int mid = W / 2;
+            for (int x = 0; x <= mid; ++x) at(x, in) = '.';
+            for (int y = std::min(in, out); y <= std::max(in, out); ++y) at(mid, y) = '.';
+            for (int x = mid; x < W; ++x) at(x, out) = '.';
+        }
+
+        // validate: the exit must be reachable from the entry
+        if (isWall(at(0, in)) || isWall(at(W - 1, out))) continue;
+
+        std::fill(reached.begin(), reached.end(), 0);
+        queue.clear();
+        queue.push_back(in * W);
+        reached[(size_t)in * W] = 1;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int x = queue[head] % W, y = queue[head] / W;
+            const int dx[4] = {1, -1, 0, 0};
+            const int dy[4] = {0, 0, 1, -1};
+            for (int d = 0; d < 4; ++d) {
+                int nx = x + dx[d], ny = y + dy[d];
+                if (nx < 0 || ny < 0 || nx >= W || ny >= rows) continue;
+                int idx = ny * W + nx;
+                if (reached[idx] || isWall(cells[idx])) continue;
+                reached[idx] = 1;
+                queue.push_back(idx);
+            }
+        }
+        if (!reached[(size_t)out * W + W - 1]) continue;
+
+        // valid: turn the scratch grid into chunks (chests nobody can reach are dropped)
+        auto col = std::make_shared<ChunkColumn>();
+        col->column = column;
+        col->height = rows;
+        col->chunks.resize((rows + ChunkSize - 1) / ChunkSize);
+        for (auto& ch : col->chunks) ch.tiles.fill('.');
+
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < W; ++x)
+            {
+                char c = at(x, y);
+                Chunk& ch = col->chunks[y >> ChunkShift];
+                char& tile = ch.tiles[((y & ChunkMask) << ChunkShift) | x];
+                sf::Vector2i world{x0 + x, y};
+
+                if (c == 'I') {
+                    if (!reached[(size_t)y * W + x]) continue;
+                    ch.items.push_back((int)col->items.size());
+                    col->items.push_back({world, false});
+                    tile = 'I';
+                }
+                else if (c == '>' || c == '<' || c == 'v' || c == '^') {
+                    HazardType type = c == '>' ? HazardType::CannonRight
+                                    : c == '<' ? HazardType::CannonLeft
+                                    : c == 'v' ? HazardType::LaserDown
+                                    : HazardType::LaserUp;
+                    ch.hazards.push_back((int)col->hazards.size());
+                    col->hazards.push_back({world, type, {}});
+                    tile = 'H';
+                }
+                else tile = c;
+            }
+
+        return col;
+    }
+
+    // unreachable: the carved attempt always validates
+    return nullptr;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include "Grid.h"
+#include "JobSystem.h"
+#include "Config.h"
+
+// endless boards are this many rows tall and grow to the right one column (ChunkSize cells) at a time
+const int EndlessRows = GridSize;
+
+// ChunkStreamer: builds endless-mode columns as JobSystem jobs ahead of the player.
+// A column is a pure function of (seed, column index) and its entry / exit rows are derived
+// from the seed alone, so columns can be generated in any order and they still line up.
+class ChunkStreamer {
+public:
+    ChunkStreamer() = default;
+    ~ChunkStreamer();
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // start a new run; cancels and drops anything left from the previous one
+    void start(std::uint32_t seed, int rows, int firstColumn);
+
+    // make sure every column below `column` is queued (never waits for generation)
+    void requestUpTo(int column);
+
+    // finished column, or nullptr when it isn't ready yet; columns up to it are forgotten
+    std::shared_ptr<const ChunkColumn> tryTake(int column);
+
+    // generate + validate one column on the calling thread
+    static std::shared_ptr<const ChunkColumn> generate(std::uint32_t seed, int rows, int column);
+
+    // row the walkable path enters `column` on (= the row it leaves column - 1 on)
+    static int entryRow(std::uint32_t seed, int rows, int column);
+
+private:
+    std::mutex mtx;
+    std::shared_ptr<TaskGroup> jobs;   // this run's generation jobs (cancelled by start())
+
+    std::uint32_t seed = 0;
+    int rows = EndlessRows;
+    int horizon = 0;           // columns below this have been submitted
+    std::map<int, std::shared_ptr<const ChunkColumn>> ready;
+};
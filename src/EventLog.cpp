@@ -0,0 +1,123 @@
+#include "EventLog.h"
+#include "AllocTracker.h"
+#include <chrono>
+#include <iostream>
+
+namespace {
+    const auto WriterInterval = std::chrono::milliseconds(250);
+
+    std::uint64_t nowNs()
+    {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+EventLog::~EventLog()
+{
+    close();
+}
+
+bool EventLog::open(const std::string& path)
+{
+    close();
+
+    file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "[log] can't open " << path << "\n";
+        return false;
+    }
+    std::fputs("# ms level turn event x y value\n", file);
+
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+    openedAtNs = nowNs();
+    stopping = false;
+    writer = std::thread(&EventLog::writerLoop, this);
+    active.store(true, std::memory_order_release);
+    return true;
+}
+
+void EventLog::close()
+{
+    if (!writer.joinable()) return;
+    active.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+void EventLog::push(GameEvent e)
+{
+    if (!active.load(std::memory_order_relaxed)) return;
+
+    std::uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == Capacity) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    e.ms = (std::uint32_t)((nowNs() - openedAtNs) / 1000000);
+    ring[h & (Capacity - 1)] = e;
+    head.store(h + 1, std::memory_order_release);   // publishes the slot to the writer
+}
+
+void EventLog::writerLoop()
+{
+    AllocTracker::enter(AllocTracker::Background);
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!stopping) {
+        cv.wait_for(lock, WriterInterval, [this]{ return stopping; });
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+    lock.unlock();
+    drain();   // whatever was pushed before close()
+}
+
+void EventLog::drain()
+{
+    std::uint32_t t = tail.load(std::memory_order_relaxed);
+    std::uint32_t h = head.load(std::memory_order_acquire);
+    if (t == h && dropped.load(std::memory_order_relaxed) == 0) return;
+
+    for (; t != h; ++t) {
+        const GameEvent& e = ring[t & (Capacity - 1)];
+        std::fprintf(file, "%u %d %d %s %d %d %d\n",
+                     (unsigned)e.ms, (int)e.level, (int)e.turn, name(e.type), (int)e.x, (int)e.y, (int)e.value);
+    }
+    tail.store(t, std::memory_order_release);   // hands the slots back to the producer
+
+    std::uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost) std::fprintf(file, "# dropped %u events (writer fell behind)\n", (unsigned)lost);
+    std::fflush(file);
+}
+
+const char* EventLog::name(EventType t)
+{
+    switch (t) {
+        case EventType::LevelStart:      return "level_start";
+        case EventType::TurnStart:       return "turn_start";
+        case EventType::TurnEnd:         return "turn_end";
+        case EventType::Move:            return "move";
+        case EventType::MoveBlocked:     return "move_blocked";
+        case EventType::BlockPlaced:     return "block_placed";
+        case EventType::BlockUndone:     return "block_undone";
+        case EventType::MoveUndone:      return "move_undone";
+        case EventType::TurnUndone:      return "turn_undone";
+        case EventType::ChestPicked:     return "chest";
+        case EventType::BeamDeath:       return "death_beam";
+        case EventType::ProjectileDeath: return "death_projectile";
+        case EventType::LevelComplete:   return "level_complete";
+        case EventType::LevelFail:       return "level_fail";
+    }
+    return "?";
+}
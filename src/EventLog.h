@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class EventType : std::uint8_t {
+    LevelStart,       // value = turn limit (-1 infinite)
+    TurnStart,        // value = turns remaining
+    TurnEnd,          // value = turns remaining
+    Move,             // x,y = cell moved to
+    MoveBlocked,      // x,y = cell that stopped the move
+    BlockPlaced,      // x,y = block cell
+    BlockUndone,      // K on a block
+    MoveUndone,       // K on a move, value = moves left in the plan
+    TurnUndone,       // Shift+K
+    ChestPicked,      // x,y = chest cell
+    BeamDeath,
+    ProjectileDeath,
+    LevelComplete,
+    LevelFail
+};
+
+// one fixed-size record; everything is filled by the game thread, formatting happens on the writer
+struct GameEvent {
+    std::uint32_t ms = 0;        // since the log was opened (stamped by push)
+    EventType type = EventType::Move;
+    std::int16_t level = 0;      // campaign level index, -1 = endless
+    std::int16_t turn = 0;       // turn number within the level, from 1
+    std::int32_t x = 0, y = 0;   // player / board cell where it applies
+    std::int32_t value = 0;
+};
+
+// EventLog: gameplay events -> line-delimited text file.
+// The game thread push()es into a single-producer / single-consumer lock-free ring
+// (no locks, no allocation, no syscalls); a writer thread drains it every few hundred ms
+// and does the formatting and file I/O. If the writer falls a full ring behind, new events
+// are dropped and counted rather than ever making the game wait.
+class EventLog {
+public:
+    static constexpr std::uint32_t Capacity = 8192;   // must be a power of two
+
+    EventLog() = default;
+    ~EventLog();
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    bool open(const std::string& path);   // truncates the file and starts the writer
+    void close();                         // drains what's left, stops the writer
+
+    // game thread only (single producer)
+    void push(GameEvent e);
+
+private:
+    void writerLoop();
+    void drain();
+    static const char* name(EventType t);
+
+    std::array<GameEvent, Capacity> ring;
+    alignas(64) std::atomic<std::uint32_t> head{0};   // next slot to write (producer)
+    alignas(64) std::atomic<std::uint32_t> tail{0};   // next slot to read (writer)
+    alignas(64) std::atomic<std::uint32_t> dropped{0};
+
+    std::FILE* file = nullptr;
+    std::thread writer;
+    std::mutex mtx;                 // only for the writer's sleep / shutdown
+    std::condition_variable cv;
+    bool stopping = false;
+    std::atomic<bool> active{false};
+    std::uint64_t openedAtNs = 0;
+};
@@ -1,150 +1,18 @@
 #include "Game.h"
+#include "Trace.h"
+#include "JobSystem.h"
+#include "ResourceCache.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <random>
 #include "Config.h"
-
-// --- Level literals (20x20) ---
-static const std::vector<std::string> L1 = {
-"....................",
-"....................",
-"....................",
-".........Lv.........",
-"....................",
-"....................",
-"....................",
-"....................",
-"....................",
-"....................",
-".........I..........",
-"....................",
-"....P...............",
-"....................",
-"....................",
-"....................",
-"....................",
-"....................",
-"..........I.........",
-"...................."
-};
-
-static const std::vector<std::string> L2 = {
-"....................",
-"....................",
-"....C>..I..C<.......",
-"....................",
-"....................",
-"....................",
-"....................",
-".....I..............",
-"....................",
-"....................",
-"....................",
-"....................",
-"....P...............",
-"....................",
-".........Lv.........",
-"....................",
-"....................",
-"....................",
-"..........I.........",
-"...................."
-};
-
-static const std::vector<std::string> L3 = {
-"..............T.....",
-"....................",
-"....C>......I.......",
-"....................",
-"..I....I....C<......",
-"....................",
-"....................",
-".........Lv.........",
-"....................",
-"....TTT.............",
-"....T~T.............",
-"P...T~T......I......",
-"....T~T.............",
-"....TTT.............",
-"....................",
-"...........Lv.......",
-"....................",
-"......C>............",
-".................TT.",
-"....T.......I......."
-};
-
-static const std::vector<std::string> L4 = {
-".................Lv.",
-"...C>.......C<......",
-"...TTT......TTT.....",
-"...T~T......T~T..I..",
-"...T~T......T~T.....",
-"...TTT......TTT.....",
-"....................",
-"......I.............",
-"....C>......C<......",
-"....................",
-"....................",
-"..Lv................",
-"......I.......I.....",
-"....................",
-"....................",
-"........I...........",
-"....................",
-"....................",
-"P...................",
-"...................."
-};
-
-static const std::vector<std::string> L5 = {
-"....................",
-"....................",
-"C>....I.......I...C<",
-"....................",
-"....TTT.............",
-"....T~T.............",
-"....T~T.....I.......",
-"....TTT.............",
-"....................",
-"....................",
-"..LvC>.....Lv.T.....",
-"....................",
-"....I.........I.....",
-"....................",
-"....................",
-"....................",
-".........I..........",
-".................TTT",
-"P................T~T",
-".................TTT"
-};
-
-static const std::vector<std::string> L6 = {
-".........C>.........",
-"....................",
-"...I.........I......",
-"....................",
-"C>.......I....Lv....",
-"....................",
-"....................",
-".....TTT.........TT.",
-".....T~T.....I......",
-".....T~T............",
-".....TTT............",
-"....................",
-"..................C<",
-"....................",
-"....................",
-"............TTTTT...",
-"....I.......T~~~T...",
-"............TTTTT...",
-"P...................",
-"...............TT..."
-};
+#include "Levels.h"
 
 // ---------------- Helpers ----------------
 
@@ -168,84 +36,298 @@ std::string Game::formatFloatTrim(float v, int precision)
     return std::string(buf);
 }
 
+std::unique_ptr<sf::Text> Game::makeCenteredText(const std::string& s, unsigned int size, sf::Color color, float y)
+{
+    auto t = std::make_unique<sf::Text>(*font, s, size);
+    t->setFillColor(color);
+    t->setStyle(sf::Text::Style::Bold);
+    centerText(*t, y);
+    return t;
+}
+
+void Game::centerText(sf::Text& t, float y)
+{
+    sf::FloatRect tb = t.getLocalBounds();
+    t.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
+    t.setPosition({ WindowWidth/2.f, y });
+}
+
+void Game::updateHudStrings(const RenderFrame& f)
+{
+    // only touch the texts when the shown value changes; strings come from prebuilt tables
+    int tenths = (int)std::lround(f.remaining * 10.f);
+    if (tenths != shownTimerTenths) {
+        shownTimerTenths = tenths;
+        if (tenths >= 0 && tenths < (int)timerStrings.size()) timerText->setString(timerStrings[tenths]);
+        else timerText->setString(formatFloatTrim(f.remaining, 1));
+    }
+
+    int blocksLeft = f.blocksLeft;
+    if (blocksLeft != shownBlocksLeft) {
+        shownBlocksLeft = blocksLeft;
+        if (blocksLeft >= 0 && blocksLeft < HudTableSize) blocksLeftText->setString(blocksLeftStrings[blocksLeft]);
+        else blocksLeftText->setString("Blocks Left : " + std::to_string(blocksLeft));
+    }
+
+    int turns = f.turns;
+    if (turns != shownTurns) {
+        shownTurns = turns;
+        if (turns < 0) turnsText->setString("Turns : Infinite");
+        else if (turns < HudTableSize) turnsText->setString(turnsStrings[turns]);
+        else turnsText->setString("Turns : " + std::to_string(turns));
+    }
+
+    if (f.race) updateRaceText(f);
+    if (f.reviewTick >= 0) updateReviewText(f);
+}
+
+void Game::updateRaceText(const RenderFrame& f)
+{
+    if (f.ghostsAlive == shownGhostsAlive && f.ghostsFinished == shownGhostsFinished && f.ghostCount == shownGhostCount)
+        return;
+    shownGhostsAlive = f.ghostsAlive;
+    shownGhostsFinished = f.ghostsFinished;
+    shownGhostCount = f.ghostCount;
+    if (f.ghostCount == 0) raceText->setString("Ghosts : planning...");
+    else raceText->setString("Ghosts : " + std::to_string(f.ghostsAlive) + " | Done : " + std::to_string(f.ghostsFinished));
+}
+
+void Game::updateReviewText(const RenderFrame& f)
+{
+    if (f.reviewTick == shownReviewTick && f.reviewTicks == shownReviewTicks && f.reviewSpeed == shownReviewSpeed)
+        return;
+    shownReviewTick = f.reviewTick;
+    shownReviewTicks = f.reviewTicks;
+    shownReviewSpeed = f.reviewSpeed;
+    std::string speed = f.reviewSpeed == 0.f ? "paused" : formatFloatTrim(f.reviewSpeed, 2) + "x";
+    reviewText->setString("Replay " + std::to_string(f.reviewTick) + " / " + std::to_string(f.reviewTicks)
+                          + " (" + speed + ")  <- -> step | Up/Down speed | R back");
+}
+
+void Game::applyScreenText(const ScreenText& t)
+{
+    // the simulation's strings, applied (and re-centred) only when one of them changed
+    if (t.revision == shownTextRevision) return;
+    shownTextRevision = t.revision;
+
+    levelTitleText->setString(t.levelTitle);
+    mainInfoText->setString(t.difficulty);
+    centerText(*mainInfoText, 510.f);
+    completeStatsText->setString(t.completeStats);
+    centerText(*completeStatsText, 180.f);
+    gameCompleteStatsText->setString(t.gameCompleteStats);
+    centerText(*gameCompleteStatsText, 180.f);
+    failMsgText->setString(t.failMsg);
+    centerText(*failMsgText, 190.f);
+    settingsSpeedBtn->setLabel(t.execSpeed);
+
+    if (t.toastSerial != shownToastSerial) {
+        shownToastSerial = t.toastSerial;
+        toastText->setString(t.toast);
+        toastClock.restart();
+    }
+}
+
+bool Game::checkSteadyStateAllocs(bool hadEvents, const RenderFrame& f)
+{
+    if (!AllocTracker::Enabled) return false;
+
+    // steady state = playing, no input this frame (window events, or inputs the simulation
+    // applied since the last frame), no phase change, overlay hidden (it formats text)
+    hadEvents = hadEvents || f.inputSerial != lastInputSerial;
+    lastInputSerial = f.inputSerial;
+    bool steady = f.uiState == UIState::Playing && !hadEvents && f.phase == lastCheckedPhase && !profiler.isVisible();
+    lastCheckedPhase = f.phase;
+    if (!steady) { steadyFrames = 0; return false; }
+    if (++steadyFrames < SteadyWarmupFrames) return false;
+
+    const FrameSample& fs = profiler.latest();
+    if (fs.allocs == 0) return false;
+
+    std::cerr << "[alloc] steady-state gameplay frame made " << fs.allocs << " allocations ("
+              << fs.allocBytes << " bytes):";
+    for (int st = 0; st < (int)ProfileStage::Count; ++st)
+        if (fs.stageAllocs[st]) std::cerr << ' ' << FrameProfiler::stageName((ProfileStage)st) << '=' << fs.stageAllocs[st];
+    std::cerr << '\n';
+#ifdef TRACK_ALLOCS_STRICT
+    std::abort();
+#endif
+    return true;
+}
+
 // ---------------- Game implementation ----------------
 
-Game::Game()
-: window(sf::VideoMode({WindowWidth, WindowHeight}), "10 Seconds Ahead"),
-  view()
+Game::Game(ExecSpeed speed, bool headless)
+: headless(headless),
+  view(),
+  saveWriter(headless ? "" : "savegame.dat")
 {
+    // headless (frame check): the same frames drawn into an offscreen texture, no window
+    if (headless) {
+        if (!offscreen.resize({WindowWidth, WindowHeight})) std::cerr << "Error: can't create the offscreen target\n";
+        canvas = &offscreen;
+    }
+    else window.create(sf::VideoMode({WindowWidth, WindowHeight}), "10 Seconds Ahead");
+
     // letterbox view init
     view.setCenter({WindowWidth / 2.f, WindowHeight / 2.f});
     view.setSize({(float)WindowWidth, (float)WindowHeight});
-    window.setView(view);
+    canvas->setView(view);
 
     // load grid textures
     grid.load();
 
     // load font and HUD text early
-    if (!font.openFromFile("assets/arial.ttf")) {
-        std::cerr << "Missing font: assets/arial.ttf\n";
-    }
-
-    // Now create buttons (font is available for sf::Text inside ElevatedButton)
-    mainPlayBtn     = std::make_unique<ElevatedButton>(font, "Play");
-    mainSettingsBtn = std::make_unique<ElevatedButton>(font, "Settings");
-    mainQuitBtn     = std::make_unique<ElevatedButton>(font, "Quit");
+    font = ResourceCache::font("assets/arial.ttf");
 
-    settingsEasyBtn   = std::make_unique<ElevatedButton>(font, "Easy  (Blocks=3)");
-    settingsNormalBtn = std::make_unique<ElevatedButton>(font, "Normal(Blocks=2)");
-    settingsHardBtn   = std::make_unique<ElevatedButton>(font, "Hard  (Blocks=1)");
+    settings.execSpeed = speed;
+    text.execSpeed = "Speed : " + settings.speedName();
 
-    pauseResumeBtn   = std::make_unique<ElevatedButton>(font, "Resume", sf::Vector2f{240.f,44.f});
-    pauseRestartBtn  = std::make_unique<ElevatedButton>(font, "Restart Level", sf::Vector2f{240.f,44.f});
-    pauseSettingsBtn = std::make_unique<ElevatedButton>(font, "Settings", sf::Vector2f{240.f,44.f});
-    pauseMenuBtn     = std::make_unique<ElevatedButton>(font, "Main Menu", sf::Vector2f{240.f,44.f});
-
-    failRetryBtn = std::make_unique<ElevatedButton>(font, "Retry Level", sf::Vector2f{240.f,44.f});
-    failMenuBtn  = std::make_unique<ElevatedButton>(font, "Main Menu", sf::Vector2f{240.f,44.f});
-
-    completeNextBtn  = std::make_unique<ElevatedButton>(font, "Next Level", sf::Vector2f{240.f,44.f});
-    completeRetryBtn = std::make_unique<ElevatedButton>(font, "Retry", sf::Vector2f{240.f,44.f});
-    completeMenuBtn  = std::make_unique<ElevatedButton>(font, "Main Menu", sf::Vector2f{240.f,44.f});
+    // Now create buttons (font is available for sf::Text inside ElevatedButton)
+    mainPlayBtn     = std::make_unique<ElevatedButton>(*font, "Play");
+    mainLevelsBtn   = std::make_unique<ElevatedButton>(*font, "Levels");
+    mainEndlessBtn  = std::make_unique<ElevatedButton>(*font, "Endless");
+    mainRaceBtn     = std::make_unique<ElevatedButton>(*font, "Race");
+    mainSettingsBtn = std::make_unique<ElevatedButton>(*font, "Settings");
+    mainQuitBtn     = std::make_unique<ElevatedButton>(*font, "Quit");
+
+    settingsEasyBtn   = std::make_unique<ElevatedButton>(*font, "Easy  (Blocks=3)");
+    settingsNormalBtn = std::make_unique<ElevatedButton>(*font, "Normal(Blocks=2)");
+    settingsHardBtn   = std::make_unique<ElevatedButton>(*font, "Hard  (Blocks=1)");
+    settingsSpeedBtn  = std::make_unique<ElevatedButton>(*font, text.execSpeed);
+
+    pauseResumeBtn   = std::make_unique<ElevatedButton>(*font, "Resume", sf::Vector2f{240.f,44.f});
+    pauseRestartBtn  = std::make_unique<ElevatedButton>(*font, "Restart Level", sf::Vector2f{240.f,44.f});
+    pauseSettingsBtn = std::make_unique<ElevatedButton>(*font, "Settings", sf::Vector2f{240.f,44.f});
+    pauseMenuBtn     = std::make_unique<ElevatedButton>(*font, "Main Menu", sf::Vector2f{240.f,44.f});
+
+    failRetryBtn = std::make_unique<ElevatedButton>(*font, "Retry Level", sf::Vector2f{240.f,44.f});
+    failMenuBtn  = std::make_unique<ElevatedButton>(*font, "Main Menu", sf::Vector2f{240.f,44.f});
+
+    completeNextBtn  = std::make_unique<ElevatedButton>(*font, "Next Level", sf::Vector2f{240.f,44.f});
+    completeRetryBtn = std::make_unique<ElevatedButton>(*font, "Retry", sf::Vector2f{240.f,44.f});
+    completeMenuBtn  = std::make_unique<ElevatedButton>(*font, "Main Menu", sf::Vector2f{240.f,44.f});
+
+    for (auto& b : levelSlotBtns) b = std::make_unique<ElevatedButton>(*font, "Level", sf::Vector2f{(float)ThumbSize, 36.f});
+    levelPrevBtn = std::make_unique<ElevatedButton>(*font, "< Prev", sf::Vector2f{160.f,44.f});
+    levelNextBtn = std::make_unique<ElevatedButton>(*font, "Next >", sf::Vector2f{160.f,44.f});
+    levelBackBtn = std::make_unique<ElevatedButton>(*font, "Back", sf::Vector2f{160.f,44.f});
 
     // SFML3 Text constructor: Text(const Font& font, String string="", unsigned int characterSize=30)
-    timerText = std::make_unique<sf::Text>(font, "10.0", 24u);
+    timerText = std::make_unique<sf::Text>(*font, "10.0", 24u);
     timerText->setFillColor(sf::Color::White);
     timerText->setStyle(sf::Text::Style::Bold);
     timerText->setPosition({10.f, 10.f});
 
-    blocksLeftText = std::make_unique<sf::Text>(font, "Blocks Left: 3", 20u);
+    blocksLeftText = std::make_unique<sf::Text>(*font, "Blocks Left: 3", 20u);
     blocksLeftText->setFillColor(sf::Color::White);
     blocksLeftText->setStyle(sf::Text::Style::Bold);
     blocksLeftText->setPosition({10.f, 40.f});
 
-    turnsText = std::make_unique<sf::Text>(font, "Turns: ∞", 20u);
+    turnsText = std::make_unique<sf::Text>(*font, "Turns: ∞", 20u);
     turnsText->setFillColor(sf::Color::White);
     turnsText->setStyle(sf::Text::Style::Bold);
     turnsText->setPosition({(float)WindowWidth - 220.f, 10.f});
 
-    tooltipText = std::make_unique<sf::Text>(font, "WASD Move | B Block | K Undo | ESC Pause", 18u);
+    tooltipText = std::make_unique<sf::Text>(*font, "WASD Move | B Block | K Undo | H Hint | R Replay | X Speed | ESC Pause", 18u);
     tooltipText->setFillColor(sf::Color::White);
     tooltipText->setStyle(sf::Text::Style::Bold);
     tooltipText->setPosition({10.f, (float)WindowHeight - 32.f});
 
-    levelTitleText = std::make_unique<sf::Text>(font, "Level 1", 20u);
+    levelTitleText = std::make_unique<sf::Text>(*font, "Level 1", 20u);
     levelTitleText->setFillColor(sf::Color::White);
     levelTitleText->setStyle(sf::Text::Style::Bold);
     levelTitleText->setPosition({(float)WindowWidth - 200.f, 40.f});
 
-    toastText = std::make_unique<sf::Text>(font, "", 22u);
+    raceText = std::make_unique<sf::Text>(*font, "", 18u);
+    raceText->setFillColor(sf::Color(160, 210, 255));
+    raceText->setStyle(sf::Text::Style::Bold);
+    raceText->setPosition({(float)WindowWidth - 200.f, 68.f});
+
+    toastText = std::make_unique<sf::Text>(*font, "", 22u);
     toastText->setFillColor(sf::Color(255, 200, 80));
     toastText->setStyle(sf::Text::Style::Bold);
     toastText->setPosition({(float)WindowWidth/2.f - 140.f, (float)WindowHeight - 80.f});
 
-    // prepare built-in levels
-    levels.push_back(L1);
-    levels.push_back(L2);
-    levels.push_back(L3);
-    levels.push_back(L4);
-    levels.push_back(L5);
-    levels.push_back(L6);
+    reviewText = std::make_unique<sf::Text>(*font, "", 18u);
+    reviewText->setFillColor(sf::Color(255, 230, 150));
+    reviewText->setStyle(sf::Text::Style::Bold);
+    reviewText->setPosition({10.f, 68.f});
+
+    // Menu / screen texts are built once; constructing sf::Text every frame allocates
+    mainTitleText = makeCenteredText("10 Seconds Ahead", 48u, sf::Color::White, 80.f);
+    mainInfoText = makeCenteredText("Difficulty : " + settings.difficultyName(), 18u, sf::Color::White, 530.f);
+    settingsTitleText = makeCenteredText("Settings", 40u, sf::Color::White, 80.f);
+    settingsBackHintText = makeCenteredText("Press ESC to go back", 16u, sf::Color::White, (float)WindowHeight - 80.f);
+    pauseTitleText = makeCenteredText("Paused", 40u, sf::Color::White, 120.f);
+    failTitleText = makeCenteredText("Level Failed !", 44u, sf::Color(220,60,60), 130.f);
+    failMsgText = makeCenteredText("You exhausted all turns", 20u, sf::Color::White, 190.f);
+    completeTitleText = makeCenteredText("Level Complete !", 44u, sf::Color(120,220,120), 120.f);
+    completeStatsText = makeCenteredText("Great job! Choose Next or Retry", 20u, sf::Color::White, 180.f);
+    gameCompleteTitleText = makeCenteredText("Game Completed !", 44u, sf::Color(120,220,120), 120.f);
+    gameCompleteStatsText = makeCenteredText("You cleared all levels, Nice work !", 20u, sf::Color::White, 180.f);
+    levelSelectTitleText = makeCenteredText("Select Level", 40u, sf::Color::White, 50.f);
+    levelSelectPageText = makeCenteredText("", 18u, sf::Color::White, 90.f);
+
+    // HUD strings that change while playing come from tables, so steady-state frames don't allocate
+    for (int t = 0; t <= (int)std::lround(planningTime * 10.f); ++t)
+        timerStrings.push_back(formatFloatTrim(t / 10.f, 1));
+    for (int n = 0; n < HudTableSize; ++n) {
+        blocksLeftStrings.push_back("Blocks Left : " + std::to_string(n));
+        turnsStrings.push_back("Turns : " + std::to_string(n));
+    }
+
+    // one history entry per planned move or block, so this never grows during planning
+    actionHistory.reserve(MovePlan::Capacity + 16);
+
+    hintMoves.reserve(MovePlan::Capacity);
+    hintShape.setSize({CellSize - 12.f, CellSize - 12.f});
+    hintShape.setFillColor(sf::Color(80, 220, 255, 170));
+
+    ghostShape.setSize({(float)CellSize, (float)CellSize});
+    ghostShape.setOutlineColor(sf::Color::Black);
+    ghostShape.setOutlineThickness(1);
+
+    deathShape.setSize({CellSize - 4.f, CellSize - 4.f});
+    deathShape.setFillColor(sf::Color(220, 40, 40, 90));
+    deathShape.setOutlineColor(sf::Color(220, 40, 40));
+    deathShape.setOutlineThickness(2.f);
+
+    thumbFrame.setSize({(float)ThumbSize, (float)ThumbSize});
+    thumbFrame.setFillColor(sf::Color(50,50,60));
+    thumbFrame.setOutlineColor(sf::Color::White);
+    thumbFrame.setOutlineThickness(2.f);
+
+    // built-in levels, overridden / extended by levels/levelN.txt (watched for edits)
+    levels = loadCampaignLevels();
+    levelWatcher.start(LevelDir, (int)levels.size());
+    changedLevelFiles.reserve(8);
+
+    // parse the built-in levels in parallel up front (startLevel still parses lazily as a fallback)
+    parsedLevels.resize(levels.size());
+    {
+        JobSystem& jobs = JobSystem::instance();
+        auto group = jobs.makeGroup();
+        for (size_t i = 0; i < levels.size(); ++i)
+            jobs.submit([this, i]{ parsedLevels[i] = Grid::parseLevel(levels[i]); }, group);
+        jobs.wait(*group);
+    }
+    refreshLevelCatalog();
+
+    // metrics series (registered once so recording never allocates) + optional budget overrides
+    {
+        const char* uiNames[] = { "MainMenu", "Settings", "Playing", "Pause", "LevelFail", "LevelComplete", "GameComplete", "LevelSelect" };
+        for (int i = 0; i < (int)uiSeries.size(); ++i) uiSeries[i] = metrics.addSeries("state", uiNames[i]);
+        phaseSeries[(int)GamePhase::Planning] = metrics.addSeries("phase", "Planning");
+        phaseSeries[(int)GamePhase::Executing] = metrics.addSeries("phase", "Executing");
+        inputSeries[(int)InputKind::Planning] = metrics.addInputSeries("Planning");
+        inputSeries[(int)InputKind::Playing] = metrics.addInputSeries("Playing");
+        inputSeries[(int)InputKind::Menu] = metrics.addInputSeries("Menu");
+        metrics.budgets.loadFile("metrics_budget.txt");
+    }
+
+    // gameplay event log (the empty run_log.txt in the repo root is where it goes)
+    if (!headless) eventLog.open("run_log.txt");
 
     // start at main menu
     uiState = UIState::MainMenu;
@@ -257,57 +339,61 @@ Game::Game()
     phase = GamePhase::Planning;
     phaseClock.restart();
 
-    // wire callbacks (capture this)
-    mainPlayBtn->setCallback([this](){
-        startLevel(0);
-        uiState = UIState::Playing;
-    });
-    mainSettingsBtn->setCallback([this](){
-        uiState = UIState::Settings;
-    });
+    // wire callbacks: a click is carried out by the simulation thread (Quit just closes the window)
+    auto send = [this](UiCommand c) {
+        return [this, c]() {
+            InputEvent e;
+            e.kind = InputEvent::Kind::Command;
+            e.command = c;
+            forwardInput(e);
+        };
+    };
+    mainPlayBtn->setCallback(send(UiCommand::PlayCampaign));
+    mainLevelsBtn->setCallback(send(UiCommand::OpenLevelSelect));
+    mainEndlessBtn->setCallback(send(UiCommand::PlayEndless));
+    mainRaceBtn->setCallback(send(UiCommand::PlayRace));
+    mainSettingsBtn->setCallback(send(UiCommand::OpenSettings));
     mainQuitBtn->setCallback([this](){
         window.close();
     });
 
-    settingsEasyBtn->setCallback([this](){
-        settings.difficulty = Difficulty::Easy;
-        applyDifficulty();
-        uiState = UIState::MainMenu;
-    });
-    settingsNormalBtn->setCallback([this](){
-        settings.difficulty = Difficulty::Normal;
-        applyDifficulty();
-        uiState = UIState::MainMenu;
-    });
-    settingsHardBtn->setCallback([this](){
-        settings.difficulty = Difficulty::Hard;
-        applyDifficulty();
-        uiState = UIState::MainMenu;
-    });
-
-    pauseResumeBtn->setCallback([this](){ uiState = UIState::Playing; });
-    pauseRestartBtn->setCallback([this](){ startLevel(currentLevel); uiState = UIState::Playing; });
-    pauseSettingsBtn->setCallback([this](){ uiState = UIState::Settings; });
-    pauseMenuBtn->setCallback([this](){ uiState = UIState::MainMenu; });
-
-    failRetryBtn->setCallback([this](){ startLevel(currentLevel); uiState = UIState::Playing; });
-    failMenuBtn->setCallback([this](){ uiState = UIState::MainMenu; });
-
-    completeNextBtn->setCallback([this](){
-        // advance to next level (wrap if necessary)
-        int next = currentLevel + 1;
-        if (next >= (int)levels.size()) next = 0;
-        startLevel(next);
-        uiState = UIState::Playing;
-    });
-    completeRetryBtn->setCallback([this](){ startLevel(currentLevel); uiState = UIState::Playing; });
-    completeMenuBtn->setCallback([this](){ uiState = UIState::MainMenu; });
+    settingsEasyBtn->setCallback(send(UiCommand::SetEasy));
+    settingsNormalBtn->setCallback(send(UiCommand::SetNormal));
+    settingsHardBtn->setCallback(send(UiCommand::SetHard));
+    settingsSpeedBtn->setCallback(send(UiCommand::CycleSpeed));
+
+    pauseResumeBtn->setCallback(send(UiCommand::Resume));
+    pauseRestartBtn->setCallback(send(UiCommand::RestartLevel));
+    pauseSettingsBtn->setCallback(send(UiCommand::OpenSettings));
+    pauseMenuBtn->setCallback(send(UiCommand::MainMenu));
+
+    failRetryBtn->setCallback(send(UiCommand::RestartLevel));
+    failMenuBtn->setCallback(send(UiCommand::MainMenu));
+
+    completeNextBtn->setCallback(send(UiCommand::NextLevel));
+    completeRetryBtn->setCallback(send(UiCommand::RetryLevel));
+    completeMenuBtn->setCallback(send(UiCommand::MainMenu));
+
+    for (int i = 0; i < LevelsPerPage; ++i)
+        levelSlotBtns[i]->setCallback([this, i]() {
+            InputEvent e;
+            e.kind = InputEvent::Kind::Command;
+            e.command = UiCommand::PlayLevel;
+            e.level = levelSelectPage * LevelsPerPage + i;
+            forwardInput(e);
+        });
+    levelPrevBtn->setCallback([this](){ changeLevelPage(-1); });
+    levelNextBtn->setCallback([this](){ changeLevelPage(1); });
+    levelBackBtn->setCallback(send(UiCommand::MainMenu));
 
     // Set button positions (these will match old layout)
     float bw = 220.f, bh = 48.f;
-    mainPlayBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 220.f});
-    mainSettingsBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 290.f});
-    mainQuitBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 360.f});
+    mainPlayBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 170.f});
+    mainLevelsBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 228.f});
+    mainEndlessBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 286.f});
+    mainRaceBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 344.f});
+    mainSettingsBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 402.f});
+    mainQuitBtn->setPosition({(WindowWidth/2.f) - bw/2.f, 460.f});
 
     float sbw = 220.f, sbh = 48.f;
     float scx = (WindowWidth/2.f) - sbw/2.f;
@@ -315,6 +401,7 @@ Game::Game()
     settingsEasyBtn->setPosition({scx, 220.f});
     settingsNormalBtn->setPosition({scx, 290.f});
     settingsHardBtn->setPosition({scx, 360.f});
+    settingsSpeedBtn->setPosition({scx, 450.f});
 
     float pbw = 240.f;
     pauseResumeBtn->setPosition({(WindowWidth/2.f) - pbw/2.f, 200.f});
@@ -328,111 +415,242 @@ Game::Game()
     completeNextBtn->setPosition({(WindowWidth/2.f) - pbw/2.f, 240.f});
     completeRetryBtn->setPosition({(WindowWidth/2.f) - pbw/2.f, 300.f});
     completeMenuBtn->setPosition({(WindowWidth/2.f) - pbw/2.f, 360.f});
+
+    // level select: thumbnails in a 4 x 2 grid, each with its button underneath
+    float colW = 185.f;
+    float gridX = (WindowWidth - colW * LevelSelectCols) / 2.f + (colW - ThumbSize) / 2.f;
+    for (int i = 0; i < LevelsPerPage; ++i) {
+        int c = i % LevelSelectCols, r = i / LevelSelectCols;
+        levelSlotBtns[i]->setPosition({gridX + c * colW, 116.f + r * 232.f + ThumbSize + 6.f});
+    }
+    levelPrevBtn->setPosition({60.f, 570.f});
+    levelBackBtn->setPosition({(WindowWidth/2.f) - 80.f, 570.f});
+    levelNextBtn->setPosition({(float)WindowWidth - 220.f, 570.f});
+
+    // pick an interrupted campaign level back up where it was left
+    if (!headless) resumeSave();
 }
 
 void Game::run()
 {
+    TRACE_SCOPE("Game::run");
+    simRunning.store(true);
+    simThread = std::thread(&Game::simulationLoop, this);
+
     while (window.isOpen())
     {
+        TRACE_SCOPE("frame");
+        profiler.beginFrame();
+
+        profiler.beginStage(ProfileStage::Events);
+        bool hadEvents = false;
         while (auto ev = window.pollEvent())
         {
+            hadEvents = true;
             const sf::Event& e = *ev;
             if (e.is<sf::Event::Closed>()) {
                 window.close();
-                return;
+                break;
             }
             else if (auto* rs = e.getIf<sf::Event::Resized>()) {
                 updateLetterboxView(rs->size.x, rs->size.y);
             }
-
-            handleEvent(e);
+            else if (auto* key = e.getIf<sf::Event::KeyPressed>()) {
+                handleWindowKey(*key);
+            }
         }
-
-        update();
-        render();
+        if (!window.isOpen()) break;
+        presentFrame(hadEvents);
     }
+
+    // the simulation stops before anything it owns is touched from here
+    simRunning.store(false);
+    { std::lock_guard<std::mutex> lock(simWakeMtx); }
+    simWake.notify_one();
+    if (simThread.joinable()) simThread.join();
+    if (uiState == UIState::Playing || uiState == UIState::Pause) autosave();
+    saveWriter.flush();
+    writeMetrics();
 }
 
-// ---------------- Event handling (delegates to UI/playing) ----------------
+// the window thread's part of a frame once events are in: newest simulation frame, texts, draw,
+// metrics. True if it was a steady-state gameplay frame that allocated (TRACK_ALLOCS builds).
+bool Game::presentFrame(bool hadEvents)
+{
+    // latest state from the simulation thread (the previous one again if it hasn't ticked)
+    frames.fetch();
+    awaitInputFrame();
+    profiler.endStage(ProfileStage::Events);
+    const RenderFrame& f = frames.front();
+    profiler.addStageTime(ProfileStage::Update, simUpdateUs.exchange(0) / 1000.f);
+    profiler.addStageTime(ProfileStage::Hazards, simHazardUs.exchange(0) / 1000.f);
+
+    applyScreenText(f.text);
+    if (f.uiState == UIState::Playing) updateHudStrings(f);
+    if (f.uiState == UIState::LevelSelect) updateLevelSelect(f);
+    levelThumbs.poll();
+    if (!toastText->getString().isEmpty() && toastClock.getElapsedTime().asSeconds() > 0.9f)
+        toastText->setString("");
+    updateButtons(f.uiState);
+    render(f);
+    recordInputLatency(f);
+
+    profiler.endFrame();
+    recordFrameMetrics(f);
+    return checkSteadyStateAllocs(hadEvents, f);
+}
 
-void Game::handleEvent(const sf::Event& e)
+void Game::recordFrameMetrics(const RenderFrame& f)
 {
-    // universal key handling
-    if (e.is<sf::Event::KeyPressed>()) {
-        auto key = e.getIf<sf::Event::KeyPressed>()->code;
-        if (key == sf::Keyboard::Key::Escape) {
-            if (uiState == UIState::Playing) {
-                uiState = UIState::Pause;
-            } else if (uiState == UIState::Pause) {
-                uiState = UIState::Playing;
-            }
-        }
+    const FrameSample& fs = profiler.latest();
+    metrics.recordFrame(uiSeries[(int)f.uiState], fs.frameMs);
+    if (f.uiState == UIState::Playing) metrics.recordFrame(phaseSeries[(int)f.phase], fs.frameMs);
+    recordTickMetrics();
+}
+
+void Game::recordTickMetrics()
+{
+    TickSample t;
+    while (tickSamples.pop(t)) {
+        float ms = t.us / 1000.f;
+        metrics.recordTick(uiSeries[t.uiState], ms);
+        if (t.phase >= 0) metrics.recordTick(phaseSeries[t.phase], ms);
     }
+}
 
-    // dispatch by UI state
-    if (uiState == UIState::Playing) {
-        handleInputPlaying(e);
-    } else if (uiState == UIState::MainMenu) {
-        // we now use per-frame mouse polling; no event-based handling here
-    } else if (uiState == UIState::Settings) {
-        if (e.is<sf::Event::KeyPressed>()) {
-            if (e.getIf<sf::Event::KeyPressed>()->code == sf::Keyboard::Key::Escape) {
-                uiState = UIState::MainMenu;
-            }
-        }
-    } else if (uiState == UIState::Pause) {
-        // pause handled via buttons (per-frame)
-    } else if (uiState == UIState::LevelFail || uiState == UIState::LevelComplete || uiState == UIState::GameComplete) {
-        // handled via buttons per-frame
+void Game::writeMetrics()
+{
+    recordTickMetrics();
+    if (!metrics.writeOpenMetrics("metrics.txt")) {
+        std::cerr << "[metrics] can't write metrics.txt\n";
+        return;
     }
+    if (metrics.overBudget()) std::cerr << "[metrics] session exceeded its frame-time budget (see metrics.txt)\n";
 }
 
-// ---------------- Update loop ----------------
+// ---------------- Window thread: keys and buttons ----------------
 
-void Game::update()
+void Game::handleWindowKey(const sf::Event::KeyPressed& key)
 {
-    // frame dt
-    sf::Time dt = frameDeltaClock.restart();
+    // diagnostics stay on the window thread (they only touch the profiler / metrics)
+    if (key.code == sf::Keyboard::Key::F3) {
+        profiler.toggle();
+    }
+    else if (key.code == sf::Keyboard::Key::F4) {
+        std::string path = "frame_profile_" + std::to_string(profileDumpCount++) + ".csv";
+        if (profiler.dumpCsv(path)) toastText->setString("Saved " + path);
+        else toastText->setString("Profile dump failed");
+        toastClock.restart();
+    }
+    else if (key.code == sf::Keyboard::Key::F5) {
+        // on-demand snapshot (also written on exit)
+        writeMetrics();
+        toastText->setString(metrics.overBudget() ? "Saved metrics.txt (over budget)" : "Saved metrics.txt");
+        toastClock.restart();
+    }
+    else if (frames.front().uiState == UIState::LevelSelect
+             && (key.code == sf::Keyboard::Key::Left || key.code == sf::Keyboard::Key::Right)) {
+        // paging is window-side state
+        changeLevelPage(key.code == sf::Keyboard::Key::Left ? -1 : 1);
+    }
+    else {
+        InputEvent e;
+        e.key = key.code;
+        e.shift = key.shift;
+        forwardInput(e);
+    }
+}
 
-    // toast lifetime
-    if (toastText->getString() != "") {
-        if (toastClock.getElapsedTime().asSeconds() > 0.9f) {
-            toastText->setString("");
-        }
+// every key / button the simulation should see goes through here: it is stamped for the
+// latency metrics and wakes the simulation, which applies it without waiting for its tick
+void Game::forwardInput(const InputEvent& e)
+{
+    if (!input.push(e)) return;   // queue full: dropped (and not tracked)
+    unsigned serial = ++forwardedInputs;
+
+    const RenderFrame& shown = frames.front();
+    InputKind kind = shown.uiState != UIState::Playing ? InputKind::Menu
+                   : shown.phase == GamePhase::Planning && e.kind == InputEvent::Kind::Key ? InputKind::Planning
+                   : InputKind::Playing;
+    if (pendingHead - pendingTail < (unsigned)PendingInputCap)
+        pendingInputs[pendingHead++ % PendingInputCap] = {serial, inputClock.getElapsedTime().asMicroseconds(), kind};
+    if (kind == InputKind::Planning) {
+        awaitingInput = true;
+        awaitedInput = serial;
     }
 
-    // idle hazard ticks (both in menu and in-game so visuals animate)
-    static sf::Clock hazardClock;
-    if (hazardClock.getElapsedTime().asMilliseconds() > 220) {
-        hazardClock.restart();
-        grid.stepProjectiles();
-        grid.stepBeams();
+    // taking the lock orders this against the simulation checking the queue and going to sleep
+    { std::lock_guard<std::mutex> lock(simWakeMtx); }
+    simWake.notify_one();
+}
+
+// planning fast path: a move / block key pressed this frame is applied by the simulation within
+// a fraction of a millisecond, so wait (briefly) for that frame instead of drawing the old one
+// and showing the key a whole frame later
+void Game::awaitInputFrame()
+{
+    if (!awaitingInput) return;
+    awaitingInput = false;
+
+    sf::Clock waited;
+    while ((int)(frames.front().inputSerial - awaitedInput) < 0
+           && waited.getElapsedTime().asMicroseconds() < FastPathWaitMicros) {
+        if (!frames.fetch()) std::this_thread::yield();
     }
-    grid.computeBeams();
+}
 
-    // Per-frame mouse state used by buttons
-    sf::Vector2i mousePixel = sf::Mouse::getPosition(window); // PASS window
-    sf::Vector2f mouseWorld = window.mapPixelToCoords(mousePixel);
-    bool mouseDown = sf::Mouse::isButtonPressed(sf::Mouse::Button::Left);
+// inputs applied in the frame just presented: press -> display latency into the metrics
+void Game::recordInputLatency(const RenderFrame& f)
+{
+    std::int64_t now = inputClock.getElapsedTime().asMicroseconds();
+    while (pendingTail != pendingHead) {
+        const PendingInput& p = pendingInputs[pendingTail % PendingInputCap];
+        if ((int)(f.inputSerial - p.serial) < 0) break;
+        metrics.recordInput(inputSeries[(int)p.kind], (now - p.pressedUs) / 1000.f);
+        ++pendingTail;
+    }
+}
+
+void Game::updateButtons(UIState screen)
+{
+    // frame dt
+    sf::Time dt = frameDeltaClock.restart();
+
+    // Per-frame mouse state used by buttons (headless: no pointer)
+    sf::Vector2f mouseWorld{-1.f, -1.f};
+    bool mouseDown = false;
+    if (!headless) {
+        sf::Vector2i mousePixel = sf::Mouse::getPosition(window); // PASS window
+        mouseWorld = window.mapPixelToCoords(mousePixel);
+        mouseDown = sf::Mouse::isButtonPressed(sf::Mouse::Button::Left);
+    }
 
     // Update buttons visible in current UI state: handle mouse, update animations
-    if (uiState == UIState::MainMenu) {
+    if (screen == UIState::MainMenu) {
         mainPlayBtn->handleMouse(mouseWorld, mouseDown);
+        mainLevelsBtn->handleMouse(mouseWorld, mouseDown);
+        mainEndlessBtn->handleMouse(mouseWorld, mouseDown);
+        mainRaceBtn->handleMouse(mouseWorld, mouseDown);
         mainSettingsBtn->handleMouse(mouseWorld, mouseDown);
         mainQuitBtn->handleMouse(mouseWorld, mouseDown);
 
         mainPlayBtn->update(dt);
+        mainLevelsBtn->update(dt);
+        mainEndlessBtn->update(dt);
+        mainRaceBtn->update(dt);
         mainSettingsBtn->update(dt);
         mainQuitBtn->update(dt);
-    } else if (uiState == UIState::Settings) {
+    } else if (screen == UIState::Settings) {
         settingsEasyBtn->handleMouse(mouseWorld, mouseDown);
         settingsNormalBtn->handleMouse(mouseWorld, mouseDown);
         settingsHardBtn->handleMouse(mouseWorld, mouseDown);
+        settingsSpeedBtn->handleMouse(mouseWorld, mouseDown);
 
         settingsEasyBtn->update(dt);
         settingsNormalBtn->update(dt);
         settingsHardBtn->update(dt);
-    } else if (uiState == UIState::Pause) {
+        settingsSpeedBtn->update(dt);
+    } else if (screen == UIState::Pause) {
         pauseResumeBtn->handleMouse(mouseWorld, mouseDown);
         pauseRestartBtn->handleMouse(mouseWorld, mouseDown);
         pauseSettingsBtn->handleMouse(mouseWorld, mouseDown);
@@ -442,13 +660,13 @@ void Game::update()
         pauseRestartBtn->update(dt);
         pauseSettingsBtn->update(dt);
         pauseMenuBtn->update(dt);
-    } else if (uiState == UIState::LevelFail) {
+    } else if (screen == UIState::LevelFail) {
         failRetryBtn->handleMouse(mouseWorld, mouseDown);
         failMenuBtn->handleMouse(mouseWorld, mouseDown);
 
         failRetryBtn->update(dt);
         failMenuBtn->update(dt);
-    } else if (uiState == UIState::LevelComplete) {
+    } else if (screen == UIState::LevelComplete) {
         // restored: handle Next + Retry + Menu
         completeNextBtn->handleMouse(mouseWorld, mouseDown);
         completeRetryBtn->handleMouse(mouseWorld, mouseDown);
@@ -457,313 +675,913 @@ void Game::update()
         completeNextBtn->update(dt);
         completeRetryBtn->update(dt);
         completeMenuBtn->update(dt);
-    } else if (uiState == UIState::GameComplete) {
+    } else if (screen == UIState::GameComplete) {
         // Final-game complete: Replay (start level 0), Retry (same level), Main Menu
         // We'll reuse completeRetryBtn (acts as Retry) and completeMenuBtn.
         completeRetryBtn->handleMouse(mouseWorld, mouseDown); // Retry same level
         completeMenuBtn->handleMouse(mouseWorld, mouseDown);  // Back to menu
-        // For "Replay" (start from 0), reuse completeNextBtn but callback should start level 0.
+        // For "Replay" (start from 0), reuse completeNextBtn: NextLevel wraps to level 0.
         completeNextBtn->handleMouse(mouseWorld, mouseDown);
 
         completeNextBtn->update(dt);
         completeRetryBtn->update(dt);
         completeMenuBtn->update(dt);
+    } else if (screen == UIState::LevelSelect) {
+        // only the slots that have a level on this page
+        int onPage = std::min(LevelsPerPage, levelSelectCount - levelSelectPage * LevelsPerPage);
+        for (int i = 0; i < onPage; ++i) {
+            levelSlotBtns[i]->handleMouse(mouseWorld, mouseDown);
+            levelSlotBtns[i]->update(dt);
+        }
+        levelPrevBtn->handleMouse(mouseWorld, mouseDown);
+        levelNextBtn->handleMouse(mouseWorld, mouseDown);
+        levelBackBtn->handleMouse(mouseWorld, mouseDown);
+
+        levelPrevBtn->update(dt);
+        levelNextBtn->update(dt);
+        levelBackBtn->update(dt);
     }
+}
+
+void Game::changeLevelPage(int delta)
+{
+    int pages = std::max(1, (levelSelectCount + LevelsPerPage - 1) / LevelsPerPage);
+    levelSelectPage = std::clamp(levelSelectPage + delta, 0, pages - 1);
+}
+
+// ---------------- Simulation thread ----------------
+
+namespace {
+    // times a piece of a simulation tick into one of the window thread's profiler stages (and
+    // charges its allocations to that stage, like ProfileScope does on the window thread)
+    class SimStage {
+    public:
+        SimStage(std::atomic<std::uint32_t>& total, ProfileStage s, std::uint32_t* elapsedUs = nullptr)
+        : total(total), elapsedUs(elapsedUs), prev(AllocTracker::enter((int)s + 1)) {}
+        ~SimStage()
+        {
+            AllocTracker::leave(prev);
+            auto us = (std::uint32_t)clock.getElapsedTime().asMicroseconds();
+            total.fetch_add(us, std::memory_order_relaxed);
+            if (elapsedUs) *elapsedUs = us;
+        }
+    private:
+        std::atomic<std::uint32_t>& total;
+        std::uint32_t* elapsedUs;
+        int prev;
+        sf::Clock clock;
+    };
+}
+
+void Game::simulationLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    auto next = Clock::now();
+    publishFrame();
+
+    while (simRunning.load(std::memory_order_acquire)) {
+        TickSample tick;
+        {
+            TRACE_SCOPE("Game::simTick");
+            SimStage st(simUpdateUs, ProfileStage::Update, &tick.us);
+            drainInput();
+            update();
+            publishFrame();
+        }
+        // one histogram sample per full tick (input-only ticks below only show in the profiler)
+        tick.uiState = (std::uint8_t)uiState;
+        tick.phase = uiState == UIState::Playing ? (std::int8_t)phase : -1;
+        tickSamples.push(tick);
+
+        // fixed rate; after a long tick (level load, ...) carry on from now instead of catching up
+        next += std::chrono::microseconds(SimTickMicros);
+        auto now = Clock::now();
+        if (next < now) {
+            next = now;
+            continue;
+        }
+
+        // sleep until the next tick, but input arriving meanwhile is applied and published right
+        // away as an input-only tick (no hazard step, file poll or hint pickup): a planned move
+        // doesn't wait for the tick, and the rest of the tick still runs on schedule
+        std::unique_lock<std::mutex> lock(simWakeMtx);
+        while (simWake.wait_until(lock, next, [this]{ return !input.empty() || !simRunning.load(); })) {
+            if (!simRunning.load()) break;
+            lock.unlock();
+            {
+                TRACE_SCOPE("Game::inputTick");
+                SimStage st(simUpdateUs, ProfileStage::Update);
+                drainInput();
+                publishFrame();
+            }
+            lock.lock();
+        }
+    }
+}
+
+// ---------------- Headless frame check ----------------
+
+int Game::runFrameCheck(const FrameCheckOptions& opts)
+{
+    if (!headless) return 2;
+    if (!AllocTracker::Enabled) {
+        std::cerr << "[frame-check] this build doesn't count allocations (build with -DTRACK_ALLOCS)\n";
+        return 2;
+    }
+    planningTime = opts.planningSeconds;
+
+    // the scripted player: a few planning keys early in every turn (moves, a block, an undo, a
+    // hint), then hands off until the next one; other screens are left after a moment
+    using Key = sf::Keyboard::Key;
+    static const Key PlanKeys[] = { Key::D, Key::S, Key::B, Key::A, Key::W, Key::H, Key::D, Key::K, Key::S, Key::D };
+    const int PlanKeyCount = (int)(sizeof(PlanKeys) / sizeof(PlanKeys[0]));
+    const int KeyGap = 25;        // ticks between key presses
+    const int KeysPerTurn = 6;
+    const int ScreenWait = 100;   // ticks on a menu / end screen before moving on
+
+    auto send = [this](InputEvent e) { forwardInput(e); };
+    auto press = [&](Key k) { InputEvent e; e.key = k; send(e); };
+    auto command = [&](UiCommand c) { InputEvent e; e.kind = InputEvent::Kind::Command; e.command = c; send(e); };
+
+    using Clock = std::chrono::steady_clock;
+    const int ticks = (int)(opts.seconds * 1000000.0 / SimTickMicros);
+    UIState shownState = frames.front().uiState;
+    GamePhase shownPhase = frames.front().phase;
+    int sinceChange = 0;
+    int turn = 0;
+    int checked = 0, allocating = 0;
+    auto next = Clock::now();
+
+    for (int t = 0; t < ticks; ++t) {
+        const RenderFrame& shown = frames.front();
+        if (shown.uiState != shownState || shown.phase != shownPhase) {
+            shownState = shown.uiState;
+            shownPhase = shown.phase;
+            sinceChange = 0;
+            if (shownState == UIState::Playing && shownPhase == GamePhase::Planning) ++turn;
+        }
+        else ++sinceChange;
+
+        if (shownState == UIState::Playing) {
+            if (shownPhase == GamePhase::Planning && sinceChange > 0 && sinceChange % KeyGap == 0
+                && sinceChange / KeyGap <= KeysPerTurn)
+                press(PlanKeys[(turn + sinceChange / KeyGap) % PlanKeyCount]);
+        }
+        else if (sinceChange == ScreenWait) {
+            switch (shownState) {
+                case UIState::MainMenu:      command(UiCommand::PlayCampaign); break;
+                case UIState::LevelFail:     command(UiCommand::RestartLevel); break;
+                case UIState::LevelComplete: command(UiCommand::NextLevel); break;
+                case UIState::Pause:         command(UiCommand::Resume); break;
+                default:                     command(UiCommand::MainMenu); break;
+            }
+        }
+
+        // one simulation tick, then the window's frame for it
+        TRACE_SCOPE("frame");
+        profiler.beginFrame();
+        {
+            SimStage st(simUpdateUs, ProfileStage::Update);
+            drainInput();
+            update();
+            publishFrame();
+        }
+        profiler.beginStage(ProfileStage::Events);
+        if (presentFrame(false)) ++allocating;
+        if (steadyFrames >= SteadyWarmupFrames) ++checked;
+
+        next += std::chrono::microseconds(SimTickMicros);
+        auto now = Clock::now();
+        if (next < now) next = now;   // a slow frame: carry on from now
+        else std::this_thread::sleep_until(next);
+    }
+
+    std::cout << "[frame-check] " << ticks << " frames, " << turn << " turns, " << checked
+              << " steady gameplay frames checked, " << allocating << " allocated\n";
+    if (checked == 0) {
+        std::cerr << "[frame-check] no steady gameplay frames were reached\n";
+        return 2;
+    }
+    if (allocating == 0) return 0;
+    std::cerr << "[frame-check] FAILED: steady-state frames allocate (stages above)\n";
+    return 1;
+}
+
+void Game::drainInput()
+{
+    InputEvent e;
+    while (input.pop(e)) {
+        applyInput(e);
+        ++inputSerial;
+    }
+}
+
+void Game::applyInput(const InputEvent& e)
+{
+    TRACE_SCOPE("Game::applyInput");
+    if (e.kind == InputEvent::Kind::Command) {
+        applyCommand(e.command, e.level);
+        return;
+    }
+
+    // universal key handling
+    if (e.key == sf::Keyboard::Key::Escape) {
+        if (uiState == UIState::Playing) uiState = UIState::Pause;
+        else if (uiState == UIState::Pause) uiState = UIState::Playing;
+        else if (uiState == UIState::Settings || uiState == UIState::LevelSelect) uiState = UIState::MainMenu;
+        return;
+    }
+
+    // execution speed can change at any time, even mid-turn (the outcome doesn't depend on it)
+    if (e.key == sf::Keyboard::Key::X && uiState == UIState::Playing) {
+        cycleExecSpeed();
+        showToast(text.execSpeed);
+        return;
+    }
+
+    // dispatch by UI state (the other screens only have buttons)
+    if (uiState == UIState::Playing) handleInputPlaying(e.key, e.shift);
+}
+
+void Game::applyCommand(UiCommand c, int level)
+{
+    switch (c) {
+        case UiCommand::PlayCampaign:
+            race = false;
+            startLevel(0);
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::PlayEndless:
+            race = false;
+            startEndless();
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::PlayRace:
+            race = true;
+            startLevel(0);
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::OpenSettings:
+            uiState = UIState::Settings;
+            break;
+        case UiCommand::OpenLevelSelect:
+            uiState = UIState::LevelSelect;
+            break;
+        case UiCommand::PlayLevel:
+            if (level < 0 || level >= (int)levels.size()) break;   // clicked on a page that just shrank
+            race = false;
+            startLevel(level);
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::SetEasy:
+        case UiCommand::SetNormal:
+        case UiCommand::SetHard:
+            settings.difficulty = c == UiCommand::SetEasy ? Difficulty::Easy
+                                : c == UiCommand::SetHard ? Difficulty::Hard : Difficulty::Normal;
+            applyDifficulty();
+            uiState = UIState::MainMenu;
+            break;
+        case UiCommand::Resume:
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::RestartLevel:
+            restartLevel();
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::MainMenu:
+            uiState = UIState::MainMenu;
+            break;
+        case UiCommand::NextLevel: {
+            // advance to next level (wrap if necessary)
+            int next = currentLevel + 1;
+            if (next >= (int)levels.size()) next = 0;
+            startLevel(next);
+            uiState = UIState::Playing;
+            break;
+        }
+        case UiCommand::RetryLevel:
+            startLevel(currentLevel);
+            uiState = UIState::Playing;
+            break;
+        case UiCommand::CycleSpeed:
+            cycleExecSpeed();
+            break;
+    }
+}
+
+void Game::cycleExecSpeed()
+{
+    settings.execSpeed = (ExecSpeed)(((int)settings.execSpeed + 1) % 4);
+    text.execSpeed = "Speed : " + settings.speedName();
+    ++text.revision;
+}
+
+void Game::showToast(const std::string& s)
+{
+    text.toast = s;
+    ++text.toastSerial;
+    ++text.revision;
+}
+
+void Game::update()
+{
+    TRACE_SCOPE("Game::update");
+    pollLevelFiles();
+
+    // idle hazard ticks (both in menu and in-game so visuals animate). An executing turn steps
+    // its hazards on the execution clock instead (and they hold still while it's paused).
+    bool executing = phase == GamePhase::Executing && (uiState == UIState::Playing || uiState == UIState::Pause);
+    if (!executing && hazardClock.getElapsedTime().asMilliseconds() > HazardIntervalMs) {
+        hazardClock.restart();
+        hazardTick();
+    }
+    // (no per-tick beam pass: every grid mutation already updates the beam spans it touches)
 
     if (uiState == UIState::Playing) {
         updatePlaying();
     }
+
+    // a save per turn start / execution start, once the new state is in place
+    if (saveDue && uiState == UIState::Playing) {
+        saveDue = false;
+        autosave();
+    }
+}
+
+void Game::hazardTick()
+{
+    SimStage st(simHazardUs, ProfileStage::Hazards);
+    history.beforeHazards(grid);   // (no-ops unless a turn is executing)
+    grid.stepHazards();
+    history.afterHazards(grid);
+}
+
+void Game::publishFrame()
+{
+    TRACE_SCOPE("Game::publishFrame");
+    RenderFrame& f = frames.back();
+    f.uiState = uiState;
+    f.phase = phase;
+    f.race = race;
+    f.inputSerial = inputSerial;
+
+    // reviewing: the replayed tick instead of the live board (hazards keep running underneath)
+    if (reviewing) {
+        grid.fillFrame(f.board, history.grid());
+        f.player = player.getSprite(history.player());
+        f.playerCell = history.player().gridPos;
+        f.reviewTick = history.position();
+        f.reviewTicks = history.tickCount();
+        f.reviewSpeed = ReviewSpeeds[reviewSpeed];
+    } else {
+        grid.fillFrame(f.board);
+        f.player = player.getSprite();
+        f.playerCell = player.gridPos;
+        f.reviewTick = -1;
+    }
+
+    // ghost preview and hint route (planning only)
+    f.planned.clear();
+    f.plannedBlocked = false;
+    f.hint.clear();
+    if (uiState != UIState::MainMenu && uiState != UIState::Settings && phase == GamePhase::Planning && !reviewing) {
+        const GhostPath& path = plannedPath();
+        for (int i = 0; i < path.cellCount(); ++i) f.planned.push_back(path.cell(i));
+        f.plannedBlocked = path.isBlocked();
+
+        if (hintActive) {
+            sf::Vector2i p = hintStart;
+            sf::IntRect bounds = grid.getBounds();
+            for (Direction d : hintMoves) {
+                p = Player::stepFrom(p, d, bounds);
+                f.hint.push_back(p);
+            }
+        }
+    }
+
+    f.showDeath = showDeath && phase == GamePhase::Planning && !reviewing;
+    f.deathCell = deathCell;
+
+    f.ghostCount = race ? agents.size() : 0;
+    f.ghostsAlive = agents.aliveCount();
+    f.ghostsFinished = agents.finishedCount();
+    if (race && !reviewing) agents.buildVertices(f.ghosts);
+    else f.ghosts.clear();
+    f.ghostTexture = &agents.texture();
+
+    float remaining = planningTime - phaseElapsed();
+    f.remaining = remaining < 0.f ? 0.f : remaining;
+    f.blocksLeft = blocksLeft;
+    f.turns = levelState.initialTurns < 0 ? -1 : levelState.turnsRemaining;
+
+    if (f.text.revision != text.revision) f.text = text;
+    f.levels = levelCatalog;
+
+    frames.publish();
 }
 
 // ---------------- Playing update + turn logic ----------------
 
 void Game::updatePlaying()
 {
-    // update HUD strings
-    float remaining = planningTime - phaseClock.getElapsedTime().asSeconds();
+    TRACE_SCOPE("Game::updatePlaying");
+    float remaining = planningTime - phaseElapsed();
     if (remaining < 0.f) remaining = 0.f;
-    timerText->setString(formatFloatTrim(remaining, 1));
-    blocksLeftText->setString("Blocks Left : " + std::to_string(blocksLeft));
-
-    if (levelState.initialTurns < 0) {
-        turnsText->setString("Turns : Infinite");
-    } else {
-        turnsText->setString("Turns : " + std::to_string(levelState.turnsRemaining));
-    }
 
     // phase transitions
     if (phase == GamePhase::Planning) {
+        // replay: the planning clock stands still, the replay follows its own
+        if (reviewing) {
+            float ms = reviewClock.restart().asSeconds() * 1000.f * ReviewSpeeds[reviewSpeed];
+            if (ms != 0.f && !history.play(ms)) reviewSpeed = ReviewPaused;   // ran into an end
+            phaseClock.restart();
+            return;
+        }
+
+        // pick up the newest hint route (never waits on the search thread)
+        if (hintActive) hints.poll(hintMoves, hintStart);
+
+        // solver ghosts join once the workers are done (only ever between turns)
+        if (race && !racePlans) {
+            racePlans = racePlanner.poll();
+            if (racePlans) addSolverGhosts();
+        }
+
         if (remaining <= 0.f) {
             // start execution
+            stopHint();
+            if (race) {
+                for (sf::Vector2i b : placedBlocks) {
+                    raceRecording.push_back(AgentStore::BlockOp);
+                    raceRecording.push_back((std::uint8_t)b.x);
+                    raceRecording.push_back((std::uint8_t)b.y);
+                }
+                for (Direction d : player.moves) raceRecording.push_back((std::uint8_t)d);
+                raceRecording.push_back(AgentStore::TurnBreak);
+            }
             phase = GamePhase::Executing;
             phaseClock.restart();
+            phaseTimeOffset = 0.f;
+            saveDue = true;
+            startExecutionClock();
         }
     } else { // Executing
-        static sf::Clock moveClock;
-        if (moveClock.getElapsedTime().asMilliseconds() > 250) {
-            moveClock.restart();
-
-            if (!player.moves.empty()) {
-                sf::Vector2i nextPos = player.peekNextMove();
-
-                if (!grid.isBlocked(nextPos)) {
-                    player.executeNextMove();
-                    bool picked = grid.checkItemAt(player.gridPos);
-
-                    // After move, check hazards (beams/projectiles)
-                    bool hitByBeam = grid.cellHasBeam(player.gridPos);
-                    bool hitByProjectile = grid.cellHasProjectile(player.gridPos);
-
-                    if (hitByBeam || hitByProjectile) {
-                        // Player dies: apply penalties and reset level state appropriately
-                        if (levelState.initialTurns >= 0) {
-                            levelState.turnsRemaining -= 1;
-                        }
-
-                        if (settings.difficulty != Difficulty::Easy && levelState.initialTurns >= 0) {
-                            levelState.turnsRemaining -= 1;
-                        }
-
-                        // Show toast
-                        if (settings.difficulty == Difficulty::Easy) {
-                            toastText->setString("You died !");
-                        } else {
-                            toastText->setString("You died ! Turns -2");
-                        }
-                        toastClock.restart();
-
-                        // Reset level to initial
-                        player.resetPosition();
-                        while (!player.moves.empty()) player.moves.pop();
-                        grid.clearBlocks();
-                        grid.clearProjectiles();
-                        grid.resetItemsToOriginal();
-
-                        placedBlocks.clear();
-                        actionHistory.clear();
-                        blocksLeft = settings.blocksPerTurn();
-
-                        // Check fail condition
-                        if (levelState.initialTurns >= 0 && levelState.turnsRemaining <= 0) {
-                            failLevel();
-                            return;
-                        }
-
-                        phase = GamePhase::Planning;
-                        phaseClock.restart();
-                        return;
-                    }
-
-                    // If picked an item and that was the last -> level complete immediately
-                    if (picked && grid.allItemsCollected()) {
-                        completeLevel();
-                        return;
-                    }
+        runExecution();
+    }
+}
 
-                } else {
-                    // move was blocked; consume this planned move without moving
-                    player.moves.pop();
-                }
-            } else {
-                // execution finished normally (no more planned moves)
+void Game::startExecutionClock()
+{
+    // the first move goes right away, the next hazard step keeps the idle cadence
+    execMs = 0.f;
+    nextMoveMs = 0.f;
+    nextHazardMs = std::max(0.f, HazardIntervalMs - hazardClock.getElapsedTime().asMilliseconds());
+    execClock.restart();
+    showDeath = false;
+    history.begin(grid, player);
+}
+
+// Execution runs on its own clock: moves every MoveIntervalMs and hazard steps every
+// HazardIntervalMs from the start of the phase, taken in the order they come up (a hazard step
+// first on a tie). The speed setting only changes how fast that clock follows real time, and
+// instant runs it to the end of the turn right away, so every speed plays out the same turn.
+void Game::runExecution()
+{
+    TRACE_SCOPE("Game::runExecution");
+    bool instant = settings.execSpeed == ExecSpeed::Instant;
+    float realMs = std::min(execClock.restart().asSeconds() * 1000.f, MaxExecCatchUpMs);   // (a pause doesn't count)
+    execMs += realMs * settings.speedFactor();
+
+    while (phase == GamePhase::Executing && uiState == UIState::Playing) {
+        float at = std::min(nextHazardMs, nextMoveMs);
+        if (!instant && at > execMs) break;
+        history.beginTick(at);
+        if (nextHazardMs <= nextMoveMs) {
+            nextHazardMs += HazardIntervalMs;
+            hazardTick();
+        } else {
+            nextMoveMs += MoveIntervalMs;
+            executeMove();
+        }
+    }
+}
+
+void Game::executeMove()
+{
+    if (race) agents.step(grid);
+
+    if (!player.moves.empty()) {
+        sf::Vector2i nextPos = player.peekNextMove();
+
+        if (!grid.isBlocked(nextPos)) {
+            Direction d = player.moves.front();
+            Direction facing = player.facing;
+            sf::Vector2i from = player.gridPos;
+            player.executeNextMove();
+            history.recordMove(d, true, player.gridPos != from, facing);
+            logEvent(EventType::Move, player.gridPos);
+            bool picked = grid.checkItemAt(player.gridPos);
+            if (picked) {
+                logEvent(EventType::ChestPicked, player.gridPos);
+                history.recordPickup(grid.getLevel()->itemIndex(player.gridPos));
+            }
+
+            // After move, check hazards (beams/projectiles)
+            bool hitByBeam = grid.cellHasBeam(player.gridPos);
+            bool hitByProjectile = grid.cellHasProjectile(player.gridPos);
+            if (hitByBeam) logEvent(EventType::BeamDeath, player.gridPos);
+            else if (hitByProjectile) logEvent(EventType::ProjectileDeath, player.gridPos);
+            if (hitByBeam || hitByProjectile) {
+                deathCell = player.gridPos;   // marked until the next execution (instant speed shows nothing else)
+                showDeath = true;
+            }
+
+            if ((hitByBeam || hitByProjectile) && endless) {
+                // endless runs have no retries: a death ends the run
+                failLevel();
+                return;
+            }
+
+            if (hitByBeam || hitByProjectile) {
+                // Player dies: apply penalties and reset level state appropriately
                 if (levelState.initialTurns >= 0) {
                     levelState.turnsRemaining -= 1;
                 }
 
-                // If all items collected by the end -> complete
-                if (grid.allItemsCollected()) {
-                    completeLevel();
-                    return;
+                if (settings.difficulty != Difficulty::Easy && levelState.initialTurns >= 0) {
+                    levelState.turnsRemaining -= 1;
+                }
+
+                // Show toast
+                if (settings.difficulty == Difficulty::Easy) {
+                    showToast("You died !");
+                } else {
+                    showToast("You died ! Turns -2");
                 }
 
-                // If turns exhausted -> fail
+                // Reset level to initial (O(1) snapshot restore, no re-parse / beam recompute)
+                player.resetPosition();
+                player.moves.clear();
+                grid.restore(levelStartSnapshot);
+
+                // Check fail condition
                 if (levelState.initialTurns >= 0 && levelState.turnsRemaining <= 0) {
                     failLevel();
                     return;
                 }
 
-                // else reset planning state for next turn
-                grid.clearBlocks();
-                grid.clearProjectiles();
-                placedBlocks.clear();
-                actionHistory.clear();
-                blocksLeft = settings.blocksPerTurn();
-                phase = GamePhase::Planning;
-                phaseClock.restart();
+                startPlanningTurn();
+                return;
+            }
+
+            // If picked an item and that was the last -> level complete immediately
+            if (picked && !endless && grid.allItemsCollected()) {
+                completeLevel();
                 return;
             }
+
+        } else {
+            // move was blocked; consume this planned move without moving
+            logEvent(EventType::MoveBlocked, nextPos);
+            history.recordMove(player.moves.front(), false, false, player.facing);
+            player.moves.popFront();
+        }
+    } else {
+        // the turn lasts until the ghosts have played theirs out too
+        if (race && agents.moving()) return;
+
+        // execution finished normally (no more planned moves)
+        if (levelState.initialTurns >= 0) {
+            levelState.turnsRemaining -= 1;
+        }
+        logEvent(EventType::TurnEnd, player.gridPos, levelState.turnsRemaining);
+
+        // If all items collected by the end -> complete (endless boards never run out)
+        if (!endless && grid.allItemsCollected()) {
+            completeLevel();
+            return;
         }
+
+        // If turns exhausted -> fail
+        if (levelState.initialTurns >= 0 && levelState.turnsRemaining <= 0) {
+            failLevel();
+            return;
+        }
+
+        // else reset planning state for next turn
+        grid.clearBlocks();
+        grid.clearProjectiles();
+        startPlanningTurn();
+        return;
     }
 }
 
 // ---------------- Input handling during playing (planning phase only) ----------------
 
-void Game::handleInputPlaying(const sf::Event& e)
+void Game::handleInputPlaying(sf::Keyboard::Key key, bool shift)
 {
+    TRACE_SCOPE("Game::handleInputPlaying");
     // Only handle inputs in Planning phase
     if (phase != GamePhase::Planning) return;
 
-    if (e.is<sf::Event::KeyPressed>()) {
-        auto key = e.getIf<sf::Event::KeyPressed>()->code;
-        using Key = sf::Keyboard::Key;
+    using Key = sf::Keyboard::Key;
 
-        if (key == Key::W) {
-            player.enqueueMove(Direction::Up);
-            actionHistory.push_back({false, Direction::Up, {}});
-        }
-        else if (key == Key::S) {
-            player.enqueueMove(Direction::Down);
-            actionHistory.push_back({false, Direction::Down, {}});
-        }
-        else if (key == Key::A) {
-            player.enqueueMove(Direction::Left);
-            actionHistory.push_back({false, Direction::Left, {}});
-        }
-        else if (key == Key::D) {
-            player.enqueueMove(Direction::Right);
-            actionHistory.push_back({false, Direction::Right, {}});
-        }
-        else if (key == Key::K) {
-            if (actionHistory.empty()) return;
-            ActionRecord last = actionHistory.back();
-            actionHistory.pop_back();
-            if (last.isBlock) {
-                grid.removeBlock(last.blockPos);
-                if (!placedBlocks.empty() && placedBlocks.back() == last.blockPos) placedBlocks.pop_back();
-                else {
-                    for (auto it = placedBlocks.begin(); it != placedBlocks.end(); ++it)
-                        if (*it == last.blockPos) { placedBlocks.erase(it); break; }
-                }
-                blocksLeft++;
-            } else {
-                player.undoLastMove();
+    if (reviewing) {
+        handleInputReview(key, shift);
+        return;
+    }
+    if (key == Key::R) {
+        startReview();
+        return;
+    }
+
+    if (key == Key::W) planMove(Direction::Up);
+    else if (key == Key::S) planMove(Direction::Down);
+    else if (key == Key::A) planMove(Direction::Left);
+    else if (key == Key::D) planMove(Direction::Right);
+    else if (key == Key::H) {
+        if (hintActive) stopHint();
+        else { hintActive = true; requestHint(); }
+        return;
+    }
+    else if (key == Key::K && shift) {
+        undoWholeTurn();
+    }
+    else if (key == Key::K) {
+        if (actionHistory.empty()) return;
+        ActionRecord last = actionHistory.back();
+        actionHistory.pop_back();
+        if (last.isBlock) {
+            logEvent(EventType::BlockUndone, last.blockPos);
+            grid.removeBlock(last.blockPos);
+            if (!placedBlocks.empty() && placedBlocks.back() == last.blockPos) placedBlocks.pop_back();
+            else {
+                for (auto it = placedBlocks.begin(); it != placedBlocks.end(); ++it)
+                    if (*it == last.blockPos) { placedBlocks.erase(it); break; }
             }
+            blocksLeft++;
+        } else {
+            undoPlannedMove();
+            logEvent(EventType::MoveUndone, player.gridPos, player.moves.size());
         }
-        else if (key == Key::B) {
-            if (blocksLeft <= 0) return;
-            // compute ghost pos
-            sf::Vector2i ghostPos = player.gridPos;
-            auto temp = player.moves;
-            while (!temp.empty()) {
-                Direction d = temp.front(); temp.pop();
-                if (d == Direction::Up && ghostPos.y > 0) ghostPos.y--;
-                else if (d == Direction::Down && ghostPos.y < GridSize - 1) ghostPos.y++;
-                else if (d == Direction::Left && ghostPos.x > 0) ghostPos.x--;
-                else if (d == Direction::Right && ghostPos.x < GridSize - 1) ghostPos.x++;
-
-                if (grid.isBlocked(ghostPos)) break;
-            }
-
-            if (!grid.isBlocked(ghostPos) && !grid.hasBlockAt(ghostPos)) {
-                grid.placeBlock(ghostPos);
-                placedBlocks.push_back(ghostPos);
-                actionHistory.push_back({true, Direction::Up, ghostPos});
-
-                if (actionHistory.size() >= 2) {
-                    ActionRecord prev = actionHistory[actionHistory.size()-2];
-                    if (!prev.isBlock) {
-                        actionHistory.erase(actionHistory.end()-2);
-                        player.undoLastMove();
-                    }
+    }
+    else if (key == Key::B) {
+        if (blocksLeft <= 0) return;
+        // block goes where the ghost path ends (same cached path the preview draws)
+        const GhostPath& path = plannedPath();
+        if (path.isBlocked()) return;
+        sf::Vector2i ghostPos = path.endCell();
+
+        // with an empty plan (or one that loops back) the path ends under the player
+        if (ghostPos == player.gridPos) return;
+
+        if (!grid.isBlocked(ghostPos) && !grid.hasBlockAt(ghostPos)) {
+            grid.placeBlock(ghostPos);
+            logEvent(EventType::BlockPlaced, ghostPos);
+            placedBlocks.push_back(ghostPos);
+            actionHistory.push_back({true, Direction::Up, ghostPos});
+
+            if (actionHistory.size() >= 2) {
+                ActionRecord prev = actionHistory[actionHistory.size()-2];
+                if (!prev.isBlock) {
+                    actionHistory.erase(actionHistory.end()-2);
+                    undoPlannedMove();
                 }
-                blocksLeft--;
             }
+            blocksLeft--;
         }
     }
+
+    // the plan changed (or might have): restart the hint search from the new plan end
+    if (hintActive) requestHint();
+}
+
+void Game::planMove(Direction d)
+{
+    bool cached = ghostPath.isValidFor(grid, player.gridPos, player.moves);
+    if (!player.enqueueMove(d)) {
+        showToast("Plan is full");
+        return;
+    }
+    if (cached) ghostPath.append(grid, player.moves);
+    actionHistory.push_back({false, d, {}});
+
+    // following the hint: drop its first step so the highlight stays right until the new search reports
+    if (hintActive && !hintMoves.empty() && hintMoves.front() == d) {
+        hintStart = Player::stepFrom(hintStart, d, grid.getBounds());
+        hintMoves.erase(hintMoves.begin());
+    }
+}
+
+void Game::startPlanningTurn()
+{
+    history.end();   // the turn that just ran is what R replays
+    reviewing = false;
+    if (endless) streamEndless();
+
+    placedBlocks.clear();
+    actionHistory.clear();
+    blocksLeft = settings.blocksPerTurn();
+    phase = GamePhase::Planning;
+    phaseClock.restart();
+    phaseTimeOffset = 0.f;
+    saveDue = true;
+
+    if (race) agents.beginTurn();
+
+    // turn-start state, restored by Shift+K
+    turnStartSnapshot = grid.snapshot();
+
+    ++turnNumber;
+    logEvent(EventType::TurnStart, player.gridPos, levelState.turnsRemaining);
+}
+
+// ---------------- Replay of the last execution phase ----------------
+
+void Game::startReview()
+{
+    // only the board the turn ran on can be drawn (endless mode may have scrolled since)
+    if (history.tickCount() == 0 || history.grid().getLevel() != grid.getLevel()) {
+        showToast("Nothing to replay");
+        return;
+    }
+    stopHint();
+    reviewing = true;
+    reviewSpeed = ReviewPaused;
+    history.seek(history.tickCount());   // starts where the turn ended
+    reviewClock.restart();
+    phaseTimeOffset = phaseElapsed();
+    phaseClock.restart();
+}
+
+void Game::stopReview()
+{
+    reviewing = false;
+    phaseTimeOffset = phaseElapsed();   // (the clock was held at zero while reviewing)
+    phaseClock.restart();
+}
+
+void Game::handleInputReview(sf::Keyboard::Key key, bool shift)
+{
+    using Key = sf::Keyboard::Key;
+    int stride = shift ? 10 : 1;
+
+    if (key == Key::R) stopReview();
+    else if (key == Key::Left || key == Key::Right) {
+        reviewSpeed = ReviewPaused;
+        history.seek(history.position() + (key == Key::Left ? -stride : stride));
+    }
+    else if (key == Key::Home) { reviewSpeed = ReviewPaused; history.seek(0); }
+    else if (key == Key::End)  { reviewSpeed = ReviewPaused; history.seek(history.tickCount()); }
+    else if (key == Key::Up && reviewSpeed < ReviewSpeedCount - 1) ++reviewSpeed;
+    else if (key == Key::Down && reviewSpeed > 0) --reviewSpeed;
+    reviewClock.restart();
+}
+
+void Game::undoWholeTurn()
+{
+    // drop every planned move and block at once; only the block list is restored from the
+    // turn-start snapshot so hazards keep animating from where they are now
+    grid.restoreBlocks(turnStartSnapshot);
+    logEvent(EventType::TurnUndone, player.gridPos, player.moves.size());
+    player.moves.clear();
+    placedBlocks.clear();
+    actionHistory.clear();
+    blocksLeft = settings.blocksPerTurn();
+}
+
+void Game::undoPlannedMove()
+{
+    bool cached = ghostPath.isValidFor(grid, player.gridPos, player.moves);
+    player.undoLastMove();
+    if (cached) ghostPath.popBack(player.moves);
+}
+
+const GhostPath& Game::plannedPath()
+{
+    // incremental updates keep this valid while planning; a full rebuild only happens
+    // after the start cell or the grid's walkability changed (new turn, block placed/removed)
+    if (!ghostPath.isValidFor(grid, player.gridPos, player.moves))
+        ghostPath.rebuild(grid, player.gridPos, player.moves);
+    return ghostPath;
 }
 
 // ---------------- Rendering ----------------
 
-void Game::render()
+void Game::render(const RenderFrame& f)
 {
-    window.clear(sf::Color(167,216,255));
+    TRACE_SCOPE("Game::render");
+    canvas->clear(sf::Color(167,216,255));
+    UIState uiState = f.uiState;
 
+    // menu screens count as HUD time; renderPlaying() times its own HUD block
     if (uiState == UIState::MainMenu) {
+        ProfileScope ps(profiler, ProfileStage::Hud);
         drawMainMenu();
         // draw buttons
-        mainPlayBtn->draw(window);
-        mainSettingsBtn->draw(window);
-        mainQuitBtn->draw(window);
+        mainPlayBtn->draw(*canvas);
+        mainLevelsBtn->draw(*canvas);
+        mainEndlessBtn->draw(*canvas);
+        mainRaceBtn->draw(*canvas);
+        mainSettingsBtn->draw(*canvas);
+        mainQuitBtn->draw(*canvas);
+    } else if (uiState == UIState::LevelSelect) {
+        ProfileScope ps(profiler, ProfileStage::Hud);
+        drawLevelSelect(f);
     } else if (uiState == UIState::Settings) {
+        ProfileScope ps(profiler, ProfileStage::Hud);
         drawSettingsMenu();
-        settingsEasyBtn->draw(window);
-        settingsNormalBtn->draw(window);
-        settingsHardBtn->draw(window);
+        settingsEasyBtn->draw(*canvas);
+        settingsNormalBtn->draw(*canvas);
+        settingsHardBtn->draw(*canvas);
+        settingsSpeedBtn->draw(*canvas);
     } else if (uiState == UIState::Playing || uiState == UIState::Pause) {
-        renderPlaying();
+        renderPlaying(f);
         if (uiState == UIState::Pause) {
+            ProfileScope ps(profiler, ProfileStage::Hud);
             drawPauseMenu();
-            pauseResumeBtn->draw(window);
-            pauseRestartBtn->draw(window);
-            pauseSettingsBtn->draw(window);
-            pauseMenuBtn->draw(window);
+            pauseResumeBtn->draw(*canvas);
+            pauseRestartBtn->draw(*canvas);
+            pauseSettingsBtn->draw(*canvas);
+            pauseMenuBtn->draw(*canvas);
         }
     } else if (uiState == UIState::LevelFail) {
-        renderPlaying();
+        renderPlaying(f);
+        ProfileScope ps(profiler, ProfileStage::Hud);
         drawLevelFail();
-        failRetryBtn->draw(window);
-        failMenuBtn->draw(window);
+        failRetryBtn->draw(*canvas);
+        failMenuBtn->draw(*canvas);
     } else if (uiState == UIState::LevelComplete) {
-        renderPlaying();
+        renderPlaying(f);
+        ProfileScope ps(profiler, ProfileStage::Hud);
         drawLevelComplete();
         // draw Next, Retry, Main Menu
-        completeNextBtn->draw(window);
-        completeRetryBtn->draw(window);
-        completeMenuBtn->draw(window);
+        completeNextBtn->draw(*canvas);
+        completeRetryBtn->draw(*canvas);
+        completeMenuBtn->draw(*canvas);
     } else if (uiState == UIState::GameComplete) {
+        ProfileScope ps(profiler, ProfileStage::Hud);
         // draw final game-complete screen
-        sf::Text title(font, "Game Completed !", 44u);
-        title.setFillColor(sf::Color(120,220,120));
-        title.setStyle(sf::Text::Style::Bold);
-        {
-            sf::FloatRect tb = title.getLocalBounds();
-            title.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
-            title.setPosition({ WindowWidth/2.f, 120.f });
-        }
-        window.draw(title);
-
-        sf::Text stats(font, "You cleared all levels, Nice work !", 20u);
-        stats.setFillColor(sf::Color::White);
-        stats.setStyle(sf::Text::Style::Bold);
-        {
-            sf::FloatRect sb = stats.getLocalBounds();
-            stats.setOrigin({ sb.position.x + sb.size.x/2.f, sb.position.y + sb.size.y/2.f });
-            stats.setPosition({ WindowWidth/2.f, 180.f });
-        }
-        window.draw(stats);
+        canvas->draw(*gameCompleteTitleText);
+        canvas->draw(*gameCompleteStatsText);
 
         // Replay (start level 0), Retry (same level), Main Menu
         // completeNextBtn will be used as "Replay" here (its callback starts next by default;
         // we override behavior for GameComplete below)
-        completeNextBtn->draw(window);   // acts as Replay
-        completeRetryBtn->draw(window);  // acts as Retry (same level)
-        completeMenuBtn->draw(window);
+        completeNextBtn->draw(*canvas);   // acts as Replay
+        completeRetryBtn->draw(*canvas);  // acts as Retry (same level)
+        completeMenuBtn->draw(*canvas);
     }
 
-    window.display();
+    // overlay goes last so it sits on top of every screen
+    profiler.draw(*canvas, *font);
+
+    ProfileScope ps(profiler, ProfileStage::Display);
+    if (headless) offscreen.display();
+    else window.display();
 }
 
-void Game::renderPlaying()
+void Game::renderPlaying(const RenderFrame& f)
 {
+    TRACE_SCOPE("Game::renderPlaying");
+    // board, ghost and player are drawn in world coordinates through the camera
+    canvas->setView(boardView(f));
+
     // draw grid & hazards
-    grid.draw(window);
+    {
+        ProfileScope ps(profiler, ProfileStage::GridDraw);
+        grid.draw(*canvas, f.board);
+        if (f.race && f.ghosts.getVertexCount())
+            canvas->draw(f.ghosts, sf::RenderStates(f.ghostTexture));
+    }
 
-    // draw planned moves ghost if in planning
-    if (phase == GamePhase::Planning) drawPlannedMoves();
+    // draw planned moves ghost (and the hint route after it) if in planning
+    if (f.phase == GamePhase::Planning) {
+        drawPlannedMoves(f);
+        drawHint(f);
+    }
+    if (f.showDeath) {
+        deathShape.setPosition({f.deathCell.x * CellSize + 2.f, f.deathCell.y * CellSize + 2.f});
+        canvas->draw(deathShape);
+    }
 
     // draw player
-    window.draw(player.getSprite());
-
-    // HUD
-    window.draw(*timerText);
-    window.draw(*blocksLeftText);
-    window.draw(*turnsText);
-    window.draw(*levelTitleText);
-    window.draw(*tooltipText);
+    if (f.player) canvas->draw(*f.player);
+
+    // HUD (back to the fixed window view)
+    canvas->setView(view);
+    ProfileScope ps(profiler, ProfileStage::Hud);
+    canvas->draw(*timerText);
+    canvas->draw(*blocksLeftText);
+    canvas->draw(*turnsText);
+    canvas->draw(*levelTitleText);
+    if (f.race) canvas->draw(*raceText);
+    if (f.reviewTick >= 0) canvas->draw(*reviewText);
+    canvas->draw(*tooltipText);
 
     // toast
-    if (toastText->getString() != "") {
-        window.draw(*toastText);
+    if (!toastText->getString().isEmpty()) {
+        canvas->draw(*toastText);
     }
 }
 
@@ -772,170 +1590,170 @@ void Game::renderPlaying()
 void Game::drawMainMenu()
 {
     // Title (centered + bold)
-    sf::Text title(font, "10 Seconds Ahead", 48u);
-    title.setFillColor(sf::Color::White);
-    title.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect tb = title.getLocalBounds();
-        title.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
-        title.setPosition({ WindowWidth/2.f, 80.f });
-    }
-    window.draw(title);
+    canvas->draw(*mainTitleText);
 
     // draw buttons (they already handle shadow and animation)
-    mainPlayBtn->draw(window);
-    mainSettingsBtn->draw(window);
-    mainQuitBtn->draw(window);
+    mainPlayBtn->draw(*canvas);
+    mainLevelsBtn->draw(*canvas);
+    mainEndlessBtn->draw(*canvas);
+    mainRaceBtn->draw(*canvas);
+    mainSettingsBtn->draw(*canvas);
+    mainQuitBtn->draw(*canvas);
 
     // Info text below buttons (centered + bold-ish)
-    sf::Text info(font, ("Difficulty : " + settings.difficultyName()), 18u);
-    info.setFillColor(sf::Color::White);
-    info.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect ib = info.getLocalBounds();
-        info.setOrigin({ ib.position.x + ib.size.x/2.f, ib.position.y + ib.size.y/2.f });
-        info.setPosition({ WindowWidth/2.f, 460.f });
-    }
-    window.draw(info);
+    canvas->draw(*mainInfoText);
 }
 
 
 void Game::drawSettingsMenu()
 {
     // Title (centered + bold)
-    sf::Text title(font, "Settings", 40u);
-    title.setFillColor(sf::Color::White);
-    title.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect tb = title.getLocalBounds();
-        title.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
-        title.setPosition({ WindowWidth/2.f, 80.f });
-    }
-    window.draw(title);
+    canvas->draw(*settingsTitleText);
 
     // Draw option buttons (they already have positions)
-    settingsEasyBtn->draw(window);
-    settingsNormalBtn->draw(window);
-    settingsHardBtn->draw(window);
+    settingsEasyBtn->draw(*canvas);
+    settingsNormalBtn->draw(*canvas);
+    settingsHardBtn->draw(*canvas);
+    settingsSpeedBtn->draw(*canvas);
 
     // Back hint (centered)
-    sf::Text backHint(font, "Press ESC to go back", 16u);
-    backHint.setFillColor(sf::Color::White);
-    backHint.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect bb = backHint.getLocalBounds();
-        backHint.setOrigin({ bb.position.x + bb.size.x/2.f, bb.position.y + bb.size.y/2.f });
-        backHint.setPosition({ WindowWidth/2.f, (float)WindowHeight - 80.f });
-    }
-    window.draw(backHint);
+    canvas->draw(*settingsBackHintText);
 }
 
 
 void Game::drawPauseMenu()
 {
-    sf::Text title(font, "Paused", 40u);
-    title.setFillColor(sf::Color::White);
-    title.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect tb = title.getLocalBounds();
-        title.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
-        title.setPosition({ WindowWidth/2.f, 120.f });
-    }
-    window.draw(title);
+    canvas->draw(*pauseTitleText);
 
     // draw pause buttons (already positioned)
-    pauseResumeBtn->draw(window);
-    pauseRestartBtn->draw(window);
-    pauseSettingsBtn->draw(window);
-    pauseMenuBtn->draw(window);
+    pauseResumeBtn->draw(*canvas);
+    pauseRestartBtn->draw(*canvas);
+    pauseSettingsBtn->draw(*canvas);
+    pauseMenuBtn->draw(*canvas);
 }
 
 void Game::drawLevelFail()
 {
-    sf::Text title(font, "Level Failed !", 44u);
-    title.setFillColor(sf::Color(220,60,60));
-    title.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect tb = title.getLocalBounds();
-        title.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
-        title.setPosition({ WindowWidth/2.f, 130.f });
-    }
-    window.draw(title);
-
-    sf::Text msg(font, "You exhausted all turns", 20u);
-    msg.setFillColor(sf::Color::White);
-    msg.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect mb = msg.getLocalBounds();
-        msg.setOrigin({ mb.position.x + mb.size.x/2.f, mb.position.y + mb.size.y/2.f });
-        msg.setPosition({ WindowWidth/2.f, 190.f });
-    }
-    window.draw(msg);
+    canvas->draw(*failTitleText);
+    canvas->draw(*failMsgText);
 
     // draw button widgets
-    failRetryBtn->draw(window);
-    failMenuBtn->draw(window);
+    failRetryBtn->draw(*canvas);
+    failMenuBtn->draw(*canvas);
 }
 
 
 void Game::drawLevelComplete()
 {
-    sf::Text title(font, "Level Complete !", 44u);
-    title.setFillColor(sf::Color(120,220,120));
-    title.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect tb = title.getLocalBounds();
-        title.setOrigin({ tb.position.x + tb.size.x/2.f, tb.position.y + tb.size.y/2.f });
-        title.setPosition({ WindowWidth/2.f, 120.f });
-    }
-    window.draw(title);
+    canvas->draw(*completeTitleText);
+    canvas->draw(*completeStatsText);
 
-    sf::Text stats(font, "Great job! Choose Next or Retry", 20u);
-    stats.setFillColor(sf::Color::White);
-    stats.setStyle(sf::Text::Style::Bold);
-    {
-        sf::FloatRect sb = stats.getLocalBounds();
-        stats.setOrigin({ sb.position.x + sb.size.x/2.f, sb.position.y + sb.size.y/2.f });
-        stats.setPosition({ WindowWidth/2.f, 180.f });
+    // Buttons are drawn in render() but positions were set in ctor.
+}
+
+// page text / slot labels, only when the page or the level count changed
+void Game::updateLevelSelect(const RenderFrame& f)
+{
+    levelSelectCount = f.levels ? (int)f.levels->size() : 0;
+    changeLevelPage(0);   // clamp to the pages there are
+    if (levelSelectPage == shownLevelPage && levelSelectCount == shownLevelCount) return;
+    shownLevelPage = levelSelectPage;
+    shownLevelCount = levelSelectCount;
+
+    int pages = std::max(1, (levelSelectCount + LevelsPerPage - 1) / LevelsPerPage);
+    levelSelectPageText->setString("Page " + std::to_string(levelSelectPage + 1) + " / " + std::to_string(pages)
+                                   + "   (Left / Right)");
+    centerText(*levelSelectPageText, 90.f);
+    for (int i = 0; i < LevelsPerPage; ++i)
+        levelSlotBtns[i]->setLabel("Level " + std::to_string(levelSelectPage * LevelsPerPage + i + 1));
+}
+
+void Game::drawLevelSelect(const RenderFrame& f)
+{
+    TRACE_SCOPE("Game::drawLevelSelect");
+    canvas->draw(*levelSelectTitleText);
+    canvas->draw(*levelSelectPageText);
+
+    // thumbnails come from the cache; a level still rendering shows an empty frame
+    int first = levelSelectPage * LevelsPerPage;
+    for (int i = 0; i < LevelsPerPage && first + i < levelSelectCount; ++i) {
+        sf::Vector2f slot = levelSlotBtns[i]->getPosition() - sf::Vector2f(0.f, ThumbSize + 6.f);
+        thumbFrame.setPosition(slot);
+        canvas->draw(thumbFrame);
+        if (const sf::Texture* tex = levelThumbs.get((*f.levels)[first + i])) {
+            sf::Sprite thumb(*tex);
+            thumb.setPosition(slot);
+            canvas->draw(thumb);
+        }
+        levelSlotBtns[i]->draw(*canvas);
     }
-    window.draw(stats);
 
-    // Buttons are drawn in render() but positions were set in ctor.
+    levelPrevBtn->draw(*canvas);
+    levelNextBtn->draw(*canvas);
+    levelBackBtn->draw(*canvas);
 }
 
 
 // ---------------- Ghost preview ----------------
 
-void Game::drawPlannedMoves()
+void Game::drawPlannedMoves(const RenderFrame& f)
 {
-    auto q = player.moves;            // copy queue
-    sf::Vector2i p = player.gridPos;  // simulate position
-
-    sf::RectangleShape ghost({(float)CellSize, (float)CellSize});
+    TRACE_SCOPE("Game::drawPlannedMoves");
+    // ghost shape is a member (a RectangleShape owns a vertex vector, so building one per frame allocates)
+    sf::RectangleShape& ghost = ghostShape;
     ghost.setFillColor(sf::Color(255,255,0,120));
-    ghost.setOutlineColor(sf::Color::Black);
-    ghost.setOutlineThickness(1);
 
-    float originX = (WindowWidth  - GridSize * CellSize) / 2.f;
-    float originY = (WindowHeight - GridSize * CellSize) / 2.f;
+    for (size_t i = 0; i < f.planned.size(); ++i) {
+        sf::Vector2i p = f.planned[i];
+
+        // the blocked cell (if any) is always the last one
+        if (f.plannedBlocked && i + 1 == f.planned.size())
+            ghost.setFillColor(sf::Color(255,0,0,150));
 
-    while (!q.empty()) {
-        Direction d = q.front(); q.pop();
+        ghost.setPosition({(float)p.x * CellSize, (float)p.y * CellSize});
+        canvas->draw(ghost);
+    }
+}
 
-        if (d == Direction::Up && p.y > 0) p.y--;
-        else if (d == Direction::Down && p.y < GridSize - 1) p.y++;
-        else if (d == Direction::Left && p.x > 0) p.x--;
-        else if (d == Direction::Right && p.x < GridSize - 1) p.x++;
+// ---------------- Hint ----------------
 
-        if (grid.isBlocked(p)) {
-            ghost.setFillColor(sf::Color(255,0,0,150));
-            ghost.setPosition({originX + p.x * CellSize, originY + p.y * CellSize});
-            window.draw(ghost);
-            break;
-        }
+void Game::requestHint()
+{
+    // search from where the plan currently ends (before the blocked cell, if any)
+    const GhostPath& path = plannedPath();
+    int reached = path.cellCount() - (path.isBlocked() ? 1 : 0);
+    sf::Vector2i start = reached > 0 ? path.cell(reached - 1) : player.gridPos;
+
+    HintRequest req;
+    req.level = grid.getLevel();
+    req.items = grid.getItems();
+    req.blocks = grid.getBlocks();
+    req.blocksLeft = blocksLeft;
+    req.start = start;
+    req.maxMoves = MovePlan::Capacity - (int)player.moves.size();
+
+    // leave a little of the planning time to actually enter the moves
+    float remaining = planningTime - phaseElapsed();
+    req.budgetSeconds = std::clamp(remaining - 1.f, 0.05f, 1.5f);
+
+    // keep showing the old route if the new search starts where it did
+    if (start != hintStart) hintMoves.clear();
+    hints.request(std::move(req));
+}
 
-        ghost.setPosition({originX + p.x * CellSize, originY + p.y * CellSize});
-        window.draw(ghost);
+void Game::stopHint()
+{
+    if (!hintActive) return;
+    hints.cancel();
+    hintActive = false;
+    hintMoves.clear();
+}
+
+void Game::drawHint(const RenderFrame& f)
+{
+    for (sf::Vector2i p : f.hint) {
+        hintShape.setPosition({p.x * CellSize + 6.f, p.y * CellSize + 6.f});
+        canvas->draw(hintShape);
     }
 }
 
@@ -943,8 +1761,11 @@ void Game::drawPlannedMoves()
 
 void Game::applyDifficulty()
 {
+    text.difficulty = "Difficulty : " + settings.difficultyName();
+    ++text.revision;
+
     blocksLeft = settings.blocksPerTurn();
-    if (settings.turnLimit() < 0) {
+    if (settings.turnLimit() < 0 || endless) {
         levelState.initialTurns = -1;
         levelState.turnsRemaining = -1;
     } else {
@@ -955,22 +1776,40 @@ void Game::applyDifficulty()
 
 void Game::startLevel(int index)
 {
+    TRACE_SCOPE("Game::startLevel");
+    showDeath = false;
     if (index < 0) index = 0;
     if (index >= (int)levels.size()) index = 0;
 
     currentLevel = index;
-    grid.loadLevel(levels[index]);
-    player.resetPosition();
+    endless = false;
+    stopHint();
+
+    // a retry of the loaded level just restores its start snapshot; the next level normally
+    // arrives fully prepared from the preloader, anything else (including a preload that isn't
+    // finished yet) is parsed (once) and built here
+    if (parsedLevels[index] && grid.getLevel() == parsedLevels[index]) {
+        grid.restore(levelStartSnapshot);
+    } else if (auto prepared = preloader.take(index)) {
+        parsedLevels[index] = prepared->level;
+        grid.loadLevel(std::move(*prepared));
+        levelStartSnapshot = grid.snapshot();
+    } else {
+        if (!parsedLevels[index]) parsedLevels[index] = Grid::parseLevel(levels[index]);
+        grid.loadLevel(parsedLevels[index]);
+        levelStartSnapshot = grid.snapshot();
+    }
 
-    // reset runtime pieces
-    grid.clearBlocks();
-    grid.clearProjectiles();
-    grid.resetItemsToOriginal();
-    placedBlocks.clear();
-    actionHistory.clear();
+    // get the following level ready on a worker while this one is played
+    int next = index + 1;
+    if (next < (int)levels.size())
+        preloader.start(grid, next, parsedLevels[next],
+                        parsedLevels[next] ? std::vector<std::string>{} : levels[next]);
+    player.setBoard(grid.getBounds());
+    player.resetPosition();
+    player.moves.clear();
 
     // set difficulty-based numbers
-    blocksLeft = settings.blocksPerTurn();
     if (settings.turnLimit() < 0) {
         levelState.initialTurns = -1;
         levelState.turnsRemaining = -1;
@@ -979,64 +1818,375 @@ void Game::startLevel(int index)
         levelState.turnsRemaining = settings.turnLimit();
     }
 
-    phase = GamePhase::Planning;
-    phaseClock.restart();
+    turnNumber = 0;
+    logEvent(EventType::LevelStart, player.gridPos, levelState.initialTurns);
+    startPlanningTurn();
+    if (race) startRace();
 
     // update UI
-    levelTitleText->setString("Level " + std::to_string(currentLevel + 1));
-    toastText->setString("");
+    text.levelTitle = "Level " + std::to_string(currentLevel + 1);
+    showToast("");
+}
+
+void Game::startEndless()
+{
+    TRACE_SCOPE("Game::startEndless");
+    showDeath = false;
+    endless = true;
+    endlessSeed = std::random_device{}();
+    stopHint();
+
+    // the first two columns are built right here, everything after that on the streamer's workers
+    streamer.start(endlessSeed, EndlessRows, 2);
+    endlessColumns.clear();
+    endlessColumns.push_back(ChunkStreamer::generate(endlessSeed, EndlessRows, 0));
+    endlessColumns.push_back(ChunkStreamer::generate(endlessSeed, EndlessRows, 1));
+    streamer.requestUpTo(2 + EndlessLookahead);
+
+    grid.loadLevel(Grid::composeColumns(endlessColumns));
+    player.setBoard(grid.getBounds());
+    player.resetPosition();
+    player.moves.clear();
+
+    // no turn limit; a death ends the run instead
+    levelState.initialTurns = -1;
+    levelState.turnsRemaining = -1;
+
+    turnNumber = 0;
+    logEvent(EventType::LevelStart, player.gridPos, -1);
+    startPlanningTurn();
+    showToast("");
+}
+
+void Game::streamEndless()
+{
+    TRACE_SCOPE("Game::streamEndless");
+    int playerColumn = player.gridPos.x / ChunkSize;
+    streamer.requestUpTo(playerColumn + EndlessLookahead + 1);
+
+    // append finished columns in order; one that isn't ready yet just waits for a later turn
+    // (the board edge acts like a wall until then, so nothing ever blocks on a worker)
+    bool changed = false;
+    while (endlessColumns.back()->column < playerColumn + EndlessLookahead) {
+        auto next = streamer.tryTake(endlessColumns.back()->column + 1);
+        if (!next) break;
+        endlessColumns.push_back(std::move(next));
+        changed = true;
+    }
+
+    // evict columns far behind the player so memory stays flat however long the run is
+    int evict = 0;
+    while (evict < (int)endlessColumns.size() - 1 && endlessColumns[evict]->column < playerColumn - EndlessKeepBehind)
+        ++evict;
+    if (evict > 0) {
+        endlessColumns.erase(endlessColumns.begin(), endlessColumns.begin() + evict);
+        changed = true;
+    }
+
+    if (changed) {
+        grid.shiftLevel(Grid::composeColumns(endlessColumns));
+        player.setBoard(grid.getBounds());
+    }
+
+    text.levelTitle = "Distance " + std::to_string(player.gridPos.x);
+    ++text.revision;
+}
+
+void Game::restartLevel()
+{
+    if (endless) startEndless();
+    else startLevel(currentLevel);
 }
 
 void Game::completeLevel()
 {
-    // if this was the last built-in level, show full-game completion screen
+    history.end();
+    logEvent(EventType::LevelComplete, player.gridPos, levelState.turnsRemaining);
+    saveWriter.remove();
+    saveDue = false;
+
+    // race: every ghost that finished before you placed ahead of you
+    if (race) {
+        lastAttempt = raceRecording;
+        lastAttemptCleared = true;
+        std::string place = "Race : you placed " + std::to_string(agents.finishedCount() + 1)
+                          + " of " + std::to_string(agents.size() + 1);
+        text.completeStats = place;
+        text.gameCompleteStats = place;
+    } else {
+        text.completeStats = "Great job! Choose Next or Retry";
+        text.gameCompleteStats = "You cleared all levels, Nice work !";
+    }
+
+    // if this was the last built-in level, show full-game completion screen (its Replay button
+    // is the Next button: NextLevel wraps around to level 1)
     if (currentLevel >= (int)levels.size() - 1) {
         uiState = UIState::GameComplete;
-        toastText->setString("All levels cleared !");
-        toastClock.restart();
+        showToast("All levels cleared !");
+    } else {
+        uiState = UIState::LevelComplete;
+        showToast("Level Complete !");
+    }
+}
 
-        // ensure Replay button starts level 0
-        completeNextBtn->setCallback([this](){
-            startLevel(0);    // Replay from level 1 (index 0)
-            uiState = UIState::Playing;
-        });
+void Game::failLevel()
+{
+    history.end();
+    logEvent(EventType::LevelFail, player.gridPos, levelState.turnsRemaining);
+    saveWriter.remove();
+    saveDue = false;
+    if (race) {
+        lastAttempt = raceRecording;
+        lastAttemptCleared = false;
+    }
 
-        // Retry should play same (last) level again
-        completeRetryBtn->setCallback([this](){
-            startLevel(currentLevel);
-            uiState = UIState::Playing;
-        });
+    if (endless) text.failMsg = "Run over at distance " + std::to_string(player.gridPos.x);
+    else text.failMsg = "You exhausted all turns";
 
-        // Menu already set
-    } else {
-        uiState = UIState::LevelComplete;
-        toastText->setString("Level Complete !");
-        toastClock.restart();
+    uiState = UIState::LevelFail;
+    showToast("Level Failed");
+}
 
-        // restore next behavior (next level)
-        completeNextBtn->setCallback([this](){
-            startLevel(currentLevel + 1);
-            uiState = UIState::Playing;
-        });
+// ---------------- Race mode ----------------
 
-        completeRetryBtn->setCallback([this](){
-            startLevel(currentLevel);
-            uiState = UIState::Playing;
-        });
+void Game::startRace()
+{
+    TRACE_SCOPE("Game::startRace");
+    agents.clear();
+    raceRecording.clear();
+    raceRecording.reserve(1024);
+
+    // new level or difficulty: plan a fresh field (same seed per level, so retries meet the same ghosts)
+    if (grid.getLevel() != raceLevel || settings.difficulty != raceDifficulty) {
+        raceLevel = grid.getLevel();
+        raceDifficulty = settings.difficulty;
+        racePlans.reset();
+        lastAttempt.clear();
+        TurnRules rules{ settings.blocksPerTurn(), settings.turnLimit(), settings.difficulty != Difficulty::Easy };
+        racePlanner.start(raceLevel, rules, RaceGhosts, (std::uint32_t)currentLevel + 1);
+    }
 
-        // Menu already set
+    // your previous attempt on this level runs with them
+    if (!lastAttempt.empty()) {
+        sf::IntRect b = grid.getBounds();
+        agents.add({b.position.x, b.position.y + b.size.y - 1}, lastAttempt.data(), lastAttempt.size(),
+                   sf::Color(255, 215, 90, 200), lastAttemptCleared);
     }
+    if (racePlans) addSolverGhosts();
 }
 
-void Game::failLevel()
+void Game::addSolverGhosts()
 {
-    uiState = UIState::LevelFail;
-    toastText->setString("Level Failed");
-    toastClock.restart();
+    agents.reserve(agents.size() + racePlans->count(), lastAttempt.size() + racePlans->moves.size());
+    sf::IntRect b = grid.getBounds();
+    sf::Vector2i start{b.position.x, b.position.y + b.size.y - 1};
+    for (int g = 0; g < racePlans->count(); ++g) {
+        std::uint32_t from = racePlans->offsets[g], to = racePlans->offsets[g + 1];
+        agents.add(start, racePlans->moves.data() + from, to - from, sf::Color(160, 210, 255, 110),
+                   racePlans->completes[g] != 0);
+    }
+}
+
+// ---------------- Save / resume ----------------
+
+void Game::autosave()
+{
+    // endless boards are generated on the fly and race ghosts aren't saved, so only plain
+    // campaign levels are
+    if (endless || race || !grid.getLevel()) return;
+    TRACE_SCOPE("Game::autosave");
+
+    SaveState& s = saveScratch;
+    s.difficulty = (std::uint8_t)settings.difficulty;
+    s.phase = (std::uint8_t)phase;
+    s.level = currentLevel;
+    s.levelHash = SaveState::layoutHash(levels[currentLevel]);
+    s.initialTurns = levelState.initialTurns;
+    s.turnsRemaining = levelState.turnsRemaining;
+    s.turnNumber = turnNumber;
+    s.blocksLeft = blocksLeft;
+    s.phaseElapsed = phaseElapsed();
+    s.player = player.gridPos;
+    s.moves = player.moves;
+
+    const std::vector<Item>& items = grid.getItems();
+    s.collected.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) s.collected[i] = items[i].collected;
+    s.beamProgress = grid.getBeamProgress();
+    s.hazardStep = grid.getHazardStep();
+    s.blocks = grid.getBlocks();
+    s.placedBlocks = placedBlocks;
+    s.actions.clear();
+    for (const ActionRecord& a : actionHistory) s.actions.push_back({a.isBlock, a.moveDir, a.blockPos});
+    s.projectiles.clear();
+    for (const Projectile& p : grid.getProjectiles())
+        if (p.alive) s.projectiles.push_back(p);
+
+    encodeSave(s, saveBytes);
+    saveWriter.write(saveBytes);   // disk write + fsync happen on a worker
+}
+
+bool Game::resumeSave()
+{
+    SaveState& s = saveScratch;
+    if (!readSaveFile(saveWriter.file(), s)) return false;
+
+    if (s.level < 0 || s.level >= (int)levels.size() || s.levelHash != SaveState::layoutHash(levels[s.level])
+        || s.difficulty > (std::uint8_t)Difficulty::Hard || s.phase > (std::uint8_t)GamePhase::Executing) {
+        std::cerr << "[save] saved level no longer matches, starting fresh\n";
+        saveWriter.remove();
+        return false;
+    }
+
+    settings.difficulty = (Difficulty)s.difficulty;
+    applyDifficulty();
+    startLevel(s.level);
+
+    if (!grid.restoreRuntime(s.collected, s.beamProgress, s.blocks, s.projectiles, s.hazardStep)
+        || !grid.getBounds().contains(s.player) || grid.isBlocked(s.player)) {
+        std::cerr << "[save] save doesn't fit level " << (s.level + 1) << ", starting fresh\n";
+        saveWriter.remove();
+        startLevel(s.level);
+        return false;
+    }
+
+    player.placeAt(s.player);
+    player.moves = s.moves;
+    ghostPath.invalidate();   // the saved plan's revision says nothing about the cached one
+    levelState.initialTurns = s.initialTurns;
+    levelState.turnsRemaining = s.turnsRemaining;
+    turnNumber = s.turnNumber;
+    blocksLeft = s.blocksLeft;
+    placedBlocks = s.placedBlocks;
+    actionHistory.clear();
+    for (const SaveState::Action& a : s.actions) actionHistory.push_back({a.isBlock, a.dir, a.blockPos});
+
+    phase = (GamePhase)s.phase;
+    phaseClock.restart();
+    phaseTimeOffset = s.phaseElapsed;
+    if (phase == GamePhase::Executing) startExecutionClock();   // (saved as execution started)
+    saveDue = false;   // the file on disk already is this state
+
+    uiState = UIState::Playing;
+    showToast("Resumed level " + std::to_string(s.level + 1));
+    return true;
+}
+
+// ---------------- Level hot reload ----------------
+
+void Game::pollLevelFiles()
+{
+    changedLevelFiles.clear();
+    levelWatcher.poll(changedLevelFiles);
+    for (const std::string& name : changedLevelFiles) {
+        int index = levelIndexFromFileName(name);
+        if (index >= 0) reloadLevelFile(index);
+    }
+}
+
+void Game::reloadLevelFile(int index)
+{
+    TRACE_SCOPE("Game::reloadLevelFile");
+    std::vector<std::string> layout;
+    if (!readLevelFile(levelWatcher.directory() + "/" + levelFileName(index), layout)) return;   // mid-save / deleted
+
+    // only the next number in line can add a level
+    if (index > (int)levels.size()) return;
+    if (index == (int)levels.size()) {
+        levels.push_back(layout);
+        parsedLevels.push_back(nullptr);
+    }
+    if (levels[index] == layout) return;   // saved without changes
+
+    // the level being played is edited in place (the grid still holds its previous parse)
+    bool onBoard = !endless && index == currentLevel && parsedLevels[index] && grid.getLevel() == parsedLevels[index];
+
+    // re-parse just this level
+    levels[index] = std::move(layout);
+    parsedLevels[index] = Grid::parseLevel(levels[index]);
+    if (const char* problem = Grid::checkLevel(*parsedLevels[index]))
+        std::cerr << "[levels] level " << (index + 1) << ": " << problem << "\n";
+    refreshLevelCatalog();
+
+    if (onBoard) applyLevelEdit();
+
+    // a stale preload of the edited level is dropped and started over
+    if (index == currentLevel + 1 && !endless) {
+        preloader.cancel();
+        preloader.start(grid, index, parsedLevels[index], {});
+    }
+
+    showToast("Reloaded level " + std::to_string(index + 1));
+}
+
+void Game::refreshLevelCatalog()
+{
+    // a new vector each time: the window thread may still be reading the previous one
+    levelCatalog = std::make_shared<const std::vector<std::shared_ptr<const LevelData>>>(parsedLevels);
+}
+
+void Game::applyLevelEdit()
+{
+    if (reviewing) stopReview();   // the replay was recorded on the old layout
+    grid.reloadLevel(parsedLevels[currentLevel]);
+    levelStartSnapshot = Grid::startState(*grid.getLevel());   // deaths / retries use the edited layout
+    player.setBoard(grid.getBounds());
+
+    // the player stays put (plan included) unless their cell is gone or solid now
+    if (!grid.getBounds().contains(player.gridPos) || grid.isBlocked(player.gridPos)) {
+        player.resetPosition();
+        player.moves.clear();
+        actionHistory.erase(std::remove_if(actionHistory.begin(), actionHistory.end(),
+                                           [](const ActionRecord& a){ return !a.isBlock; }),
+                            actionHistory.end());
+    }
+
+    // blocks the grid dropped (now inside a wall) are refunded and leave the undo history
+    int before = (int)placedBlocks.size();
+    auto gone = [this](sf::Vector2i p){ return !grid.hasBlockAt(p); };
+    placedBlocks.erase(std::remove_if(placedBlocks.begin(), placedBlocks.end(), gone), placedBlocks.end());
+    actionHistory.erase(std::remove_if(actionHistory.begin(), actionHistory.end(),
+                                       [&](const ActionRecord& a){ return a.isBlock && gone(a.blockPos); }),
+                        actionHistory.end());
+    blocksLeft += before - (int)placedBlocks.size();
+
+    if (hintActive && phase == GamePhase::Planning) requestHint();
+}
+
+void Game::logEvent(EventType type, sf::Vector2i cell, int value)
+{
+    GameEvent e;
+    e.type = type;
+    e.level = (std::int16_t)(endless ? -1 : currentLevel);
+    e.turn = (std::int16_t)turnNumber;
+    e.x = cell.x;
+    e.y = cell.y;
+    e.value = value;
+    eventLog.push(e);
 }
 
 // ---------------- Letterbox / view ----------------
 
+sf::View Game::boardView(const RenderFrame& f) const
+{
+    // same letterbox viewport as the HUD view, centred on the board when it fits
+    // on screen and following the player (clamped to the edges) when it doesn't
+    sf::View cam = view;
+    if (!f.board.level) return cam;
+    sf::Vector2f size = view.getSize();
+    const LevelData& L = *f.board.level;
+    sf::Vector2f origin{(float)L.originX * CellSize, 0.f};
+    sf::Vector2f board{(float)L.width * CellSize, (float)L.height * CellSize};
+    sf::Vector2f focus{(f.playerCell.x + 0.5f) * CellSize, (f.playerCell.y + 0.5f) * CellSize};
+
+    auto axis = [](float start, float boardLen, float viewLen, float f) {
+        if (boardLen <= viewLen) return start + boardLen / 2.f;
+        return std::clamp(f, start + viewLen / 2.f, start + boardLen - viewLen / 2.f);
+    };
+    cam.setCenter({axis(origin.x, board.x, size.x, focus.x), axis(origin.y, board.y, size.y, focus.y)});
+    return cam;
+}
+
 void Game::updateLetterboxView(unsigned int newWidth, unsigned int newHeight)
 {
     float windowRatio = (float)newWidth / (float)newHeight;
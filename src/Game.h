@@ -1,16 +1,37 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include <string>
 #include "Grid.h"
 #include "Player.h"
+#include "GhostPath.h"
 #include "UI.h"
+#include "Profiler.h"
+#include "ChunkStreamer.h"
+#include "HintEngine.h"
+#include "LevelPreloader.h"
+#include "LevelWatcher.h"
+#include "EventLog.h"
+#include "Metrics.h"
+#include "SaveState.h"
+#include "AgentStore.h"
+#include "RacePlanner.h"
+#include "InputQueue.h"
+#include "TripleBuffer.h"
+#include "Thumbnail.h"
+#include "TickHistory.h"
 #include "Config.h"
 
 // UI states
-enum class UIState { MainMenu, Settings, Playing, Pause, LevelFail, LevelComplete, GameComplete };
+enum class UIState { MainMenu, Settings, Playing, Pause, LevelFail, LevelComplete, GameComplete, LevelSelect };
 
 // Game phases (within Playing)
 enum class GamePhase { Planning, Executing };
@@ -18,9 +39,13 @@ enum class GamePhase { Planning, Executing };
 // Difficulty
 enum class Difficulty { Easy, Normal, Hard };
 
+// How fast the execution phase plays out (the outcome is the same at every speed)
+enum class ExecSpeed { Normal, Double, Quad, Instant };
+
 // Simple settings helper
 struct Settings {
     Difficulty difficulty = Difficulty::Normal;
+    ExecSpeed execSpeed = ExecSpeed::Normal;
     int blocksPerTurn() const {
         switch (difficulty) {
             case Difficulty::Easy: return 3;
@@ -45,6 +70,24 @@ struct Settings {
         }
         return "Normal";
     }
+    float speedFactor() const {
+        switch (execSpeed) {
+            case ExecSpeed::Normal: return 1.f;
+            case ExecSpeed::Double: return 2.f;
+            case ExecSpeed::Quad: return 4.f;
+            case ExecSpeed::Instant: return 1.f;   // (not clocked)
+        }
+        return 1.f;
+    }
+    std::string speedName() const {
+        switch (execSpeed) {
+            case ExecSpeed::Normal: return "1x";
+            case ExecSpeed::Double: return "2x";
+            case ExecSpeed::Quad: return "4x";
+            case ExecSpeed::Instant: return "Instant";
+        }
+        return "1x";
+    }
 };
 
 // Level runtime bookkeeping for turn-limited modes
@@ -61,17 +104,93 @@ struct ActionRecord {
     sf::Vector2i blockPos{0,0};         // valid if isBlock == true
 };
 
+// Strings the simulation decides and the window thread shows. They are copied into a frame
+// only when `revision` moved, and the sf::Text objects are only touched then.
+struct ScreenText {
+    std::string levelTitle = "Level 1";
+    std::string difficulty;                 // main menu line
+    std::string completeStats = "Great job! Choose Next or Retry";
+    std::string gameCompleteStats = "You cleared all levels, Nice work !";
+    std::string failMsg = "You exhausted all turns";
+    std::string execSpeed = "Speed : 1x";   // settings button label
+    std::string toast;
+    unsigned revision = 0;
+    unsigned toastSerial = 0;               // bumped by every toast, even a repeated one
+};
+
+// Everything the window thread draws, published by the simulation thread after every tick
+struct RenderFrame {
+    UIState uiState = UIState::MainMenu;
+    GamePhase phase = GamePhase::Planning;
+    bool race = false;
+    unsigned inputSerial = 0;               // inputs applied so far
+
+    Grid::Frame board;
+    std::optional<sf::Sprite> player;
+    sf::Vector2i playerCell{0, 0};
+    std::vector<sf::Vector2i> planned;      // ghost preview cells (planning only)
+    bool plannedBlocked = false;            // the last one is where a move gets blocked
+    std::vector<sf::Vector2i> hint;         // hint route cells (empty = none)
+    bool showDeath = false;                 // where the player died last turn
+    sf::Vector2i deathCell{0, 0};
+    sf::VertexArray ghosts;                 // race agents
+    const sf::Texture* ghostTexture = nullptr;
+
+    // HUD values
+    float remaining = 0.f;
+    int blocksLeft = 0;
+    int turns = -1;                         // -1 = infinite
+    int ghostCount = 0;
+    int ghostsAlive = 0;
+    int ghostsFinished = 0;
+
+    // replay of the last execution phase (R while planning); reviewTick = -1 when not reviewing
+    int reviewTick = -1;
+    int reviewTicks = 0;
+    float reviewSpeed = 0.f;
+
+    ScreenText text;
+
+    // campaign levels as parsed right now (level select thumbnails), shared with the simulation
+    std::shared_ptr<const std::vector<std::shared_ptr<const LevelData>>> levels;
+};
+
+// Headless frame check (`10_Seconds_Ahead --frame-check [seconds]`, TRACK_ALLOCS builds): the
+// game without a window. Every frame runs on one thread: a simulation tick (a scripted player
+// pressing keys), then the window thread's texts / HUD / draw into an offscreen texture. Steady
+// gameplay frames (see checkSteadyStateAllocs) must not allocate.
+struct FrameCheckOptions {
+    double seconds = 30.0;
+    float planningSeconds = 3.f;   // short turns, so a run goes through several of them
+};
+
+// Game runs on two threads. The window thread (run()) polls window events, drives the menu
+// buttons and draws; it forwards keys and button clicks through `input`. The simulation
+// thread owns the rules and every piece of game state, ticks at its own fixed rate and
+// publishes a RenderFrame after each tick. A slow display / vsync wait no longer delays
+// hazard and move ticks, and a long tick no longer drops frames.
 class Game {
 public:
-    Game();
+    // headless: no window, frames are drawn offscreen and nothing is saved (frame check only)
+    explicit Game(ExecSpeed speed = ExecSpeed::Normal, bool headless = false);
     void run();
 
+    // headless games only; returns the process exit code: 0 = no allocations in steady
+    // frames, 1 = some, 2 = setup error
+    int runFrameCheck(const FrameCheckOptions& opts);
+
 private:
-    // event & update
-    void handleEvent(const sf::Event& e);
-    void update();
-    void render();
+    // ---- window thread ----
+    void handleWindowKey(const sf::Event::KeyPressed& key);
+    void forwardInput(const InputEvent& e);
+    void awaitInputFrame();
+    void recordInputLatency(const RenderFrame& f);
+    bool presentFrame(bool hadEvents);
+    void updateButtons(UIState screen);
+    void applyScreenText(const ScreenText& t);
+    void render(const RenderFrame& f);
     void updateLetterboxView(unsigned int newWidth, unsigned int newHeight);
+    sf::View boardView(const RenderFrame& f) const;   // camera for the board (world coords = cell * CellSize)
 
     // UI drawing helpers
     void drawMainMenu();
@@ -79,27 +198,103 @@ private:
     void drawPauseMenu();
     void drawLevelFail();
     void drawLevelComplete();
+    void updateLevelSelect(const RenderFrame& f);
+    void changeLevelPage(int delta);
+    void drawLevelSelect(const RenderFrame& f);
+    void renderPlaying(const RenderFrame& f);
+    void drawPlannedMoves(const RenderFrame& f);
+    void drawHint(const RenderFrame& f);
+
+    // ---- simulation thread ----
+    void simulationLoop();
+    void drainInput();
+    void applyInput(const InputEvent& e);
+    void applyCommand(UiCommand c, int level);
+    void update();
+    void publishFrame();
+    void showToast(const std::string& s);
 
     // playing loop helpers
-    void handleInputPlaying(const sf::Event& e);
+    void handleInputPlaying(sf::Keyboard::Key key, bool shift);
+    void planMove(Direction d);
+    void undoPlannedMove();
+    void startPlanningTurn();
+    void undoWholeTurn();
+    const GhostPath& plannedPath();
     void updatePlaying();
-    void renderPlaying();
-    void drawPlannedMoves();
+    void startExecutionClock();
+    void runExecution();
+    void executeMove();
+    void hazardTick();
+    void cycleExecSpeed();
+    void requestHint();
+    void stopHint();
+    void startReview();
+    void stopReview();
+    void handleInputReview(sf::Keyboard::Key key, bool shift);
 
     // level lifecycle
     void applyDifficulty();
     void startLevel(int index);
+    void startEndless();
+    void streamEndless();
+    void startRace();                 // ghosts for the level just started (race mode)
+    void addSolverGhosts();
+    void restartLevel();          // same level again (or a fresh endless run)
     void completeLevel();
     void failLevel();
+    void pollLevelFiles();            // hot reload of levels/levelN.txt
+    void reloadLevelFile(int index);
+    void refreshLevelCatalog();       // republish parsedLevels for the level select
+    void applyLevelEdit();            // swap the edited current level in, keeping what still fits
+    void logEvent(EventType type, sf::Vector2i cell, int value = 0);
+    void autosave();
+    bool resumeSave();
+    float phaseElapsed() const { return phaseClock.getElapsedTime().asSeconds() + phaseTimeOffset; }
 
     // helpers
     static std::string formatFloatTrim(float v, int precision = 1);
+    std::unique_ptr<sf::Text> makeCenteredText(const std::string& s, unsigned int size, sf::Color color, float y);
+    static void centerText(sf::Text& t, float y);
+    void updateHudStrings(const RenderFrame& f);
+    void updateRaceText(const RenderFrame& f);
+    void updateReviewText(const RenderFrame& f);
+    bool checkSteadyStateAllocs(bool hadEvents, const RenderFrame& f);
+    void recordFrameMetrics(const RenderFrame& f);
+    void recordTickMetrics();
+    void writeMetrics();
     static bool pointInRect(const sf::Vector2f& p, const sf::FloatRect& r);
 
+    // simulation thread <-> window thread
+    static constexpr int SimTickMicros = 4000;   // 250 ticks a second
+    InputQueue input;                    // window -> simulation
+    TripleBuffer<RenderFrame> frames;    // simulation -> window
+    std::thread simThread;
+    std::atomic<bool> simRunning{false};
+    std::mutex simWakeMtx;               // the simulation sleeps between ticks on simWake;
+    std::condition_variable simWake;     // forwarded input wakes it early
+    std::atomic<std::uint32_t> simUpdateUs{0};    // tick / hazard time since the window thread last looked
+    std::atomic<std::uint32_t> simHazardUs{0};
+    // each simulation tick's duration and the screen / phase it ran in, for the tick histograms
+    // (16 s of ticks; if the window thread stalls longer than that the newest are dropped)
+    struct TickSample {
+        std::uint32_t us = 0;
+        std::uint8_t uiState = 0;
+        std::int8_t phase = -1;          // -1 unless Playing
+    };
+    SpscRing<TickSample, 4096> tickSamples;   // simulation -> window
+    unsigned inputSerial = 0;            // (simulation)
+    unsigned lastInputSerial = 0;        // (window) as of the previous frame
+
+    // ---- window thread only below, up to `ScreenText text` ----
+
     // Window / view / timing
+    bool headless = false;
     sf::RenderWindow window;
+    sf::RenderTexture offscreen;            // headless: what gets drawn instead of the window
+    sf::RenderTarget* canvas = &window;     // every draw goes here
     sf::View view;
-    sf::Font font;
+    std::shared_ptr<const sf::Font> font;   // shared through the ResourceCache
 
     // HUD texts
     std::unique_ptr<sf::Text> timerText;
@@ -107,45 +302,110 @@ private:
     std::unique_ptr<sf::Text> turnsText;
     std::unique_ptr<sf::Text> tooltipText;
     std::unique_ptr<sf::Text> levelTitleText;
+    std::unique_ptr<sf::Text> raceText;
     std::unique_ptr<sf::Text> toastText;
+    std::unique_ptr<sf::Text> reviewText;
 
-    // core systems
-    Grid grid;
-    Player player;
-
-    // game flow
-    UIState uiState = UIState::MainMenu;
-    GamePhase phase = GamePhase::Planning;
-    float planningTime = 10.f;
-    sf::Clock phaseClock;
-
-    // levels
-    std::vector<std::vector<std::string>> levels;
-    int currentLevel = 0;
+    // HUD string tables + last shown values (avoid per-frame string building)
+    static constexpr int HudTableSize = 10;
+    std::vector<sf::String> timerStrings;       // index = tenths of a second
+    std::vector<sf::String> blocksLeftStrings;
+    std::vector<sf::String> turnsStrings;
+    int shownTimerTenths = -1;
+    int shownBlocksLeft = -1;
+    int shownTurns = -2;
+    int shownGhostsAlive = -1;
+    int shownGhostsFinished = -1;
+    int shownGhostCount = -1;
+    int shownReviewTick = -1;
+    int shownReviewTicks = -1;
+    float shownReviewSpeed = -1.f;
+    unsigned shownTextRevision = ~0u;
+    unsigned shownToastSerial = 0;
 
-    // blocks / actions
-    int blocksLeft = 3;
-    std::vector<sf::Vector2i> placedBlocks;      // order of placements
-    std::vector<ActionRecord> actionHistory;     // LIFO history for undo
+    // menu / screen texts (built once in the constructor)
+    std::unique_ptr<sf::Text> mainTitleText;
+    std::unique_ptr<sf::Text> mainInfoText;
+    std::unique_ptr<sf::Text> settingsTitleText;
+    std::unique_ptr<sf::Text> settingsBackHintText;
+    std::unique_ptr<sf::Text> pauseTitleText;
+    std::unique_ptr<sf::Text> failTitleText;
+    std::unique_ptr<sf::Text> failMsgText;
+    std::unique_ptr<sf::Text> completeTitleText;
+    std::unique_ptr<sf::Text> completeStatsText;
+    std::unique_ptr<sf::Text> gameCompleteTitleText;
+    std::unique_ptr<sf::Text> gameCompleteStatsText;
 
-    // settings & level state
-    Settings settings;
-    LevelState levelState;
+    // ghost preview / hint cells, last death
+    sf::RectangleShape ghostShape;
+    sf::RectangleShape hintShape;
+    sf::RectangleShape deathShape;
 
-    // toast timing
+    // toast lifetime
     sf::Clock toastClock;
 
     // frame delta for button animations
     sf::Clock frameDeltaClock;
 
-    // UI buttons (persistent members) — use unique_ptr to construct after font is ready
+    // frame profiler overlay (F3 toggle, F4 CSV dump)
+    FrameProfiler profiler;
+    int profileDumpCount = 0;
+
+    // frame / tick histograms per UI state and per phase -> metrics.txt (on exit and F5)
+    SessionMetrics metrics;
+    std::array<int, 8> uiSeries{};      // by UIState
+    std::array<int, 2> phaseSeries{};   // by GamePhase, only while Playing
+
+    // input -> display latency: each forwarded input's press time, in order, until a presented
+    // frame has applied it (its serial matches the simulation's inputSerial)
+    enum class InputKind { Planning, Playing, Menu };
+    struct PendingInput {
+        unsigned serial;
+        std::int64_t pressedUs;
+        InputKind kind;
+    };
+    static constexpr int PendingInputCap = 512;
+    static constexpr int FastPathWaitMicros = 3000;   // longest wait for a planning key's frame
+    std::array<PendingInput, PendingInputCap> pendingInputs{};
+    unsigned pendingHead = 0;
+    unsigned pendingTail = 0;
+    unsigned forwardedInputs = 0;
+    bool awaitingInput = false;
+    unsigned awaitedInput = 0;
+    sf::Clock inputClock;
+    std::array<int, 3> inputSeries{};   // by InputKind
+
+    // TRACK_ALLOCS builds: frames of quiet gameplay before allocations get reported
+    static constexpr int SteadyWarmupFrames = 120;
+    int steadyFrames = 0;
+    GamePhase lastCheckedPhase = GamePhase::Planning;
+
+    // level select: a page of thumbnails (rendered on workers, cached as textures)
+    static constexpr int LevelSelectCols = 4;
+    static constexpr int LevelSelectRows = 2;
+    static constexpr int LevelsPerPage = LevelSelectCols * LevelSelectRows;
+    static constexpr unsigned ThumbSize = 150;
+    ThumbnailCache levelThumbs{{ThumbSize, ThumbSize}};
+    sf::RectangleShape thumbFrame;              // placeholder / border behind each thumbnail
+    std::unique_ptr<sf::Text> levelSelectTitleText;
+    std::unique_ptr<sf::Text> levelSelectPageText;
+    int levelSelectPage = 0;
+    int levelSelectCount = 0;                   // levels in the last frame's catalog
+    int shownLevelPage = -1;
+    int shownLevelCount = -1;
+
+    // UI buttons (window thread; clicks are forwarded as UiCommands) — use unique_ptr to construct after font is ready
     std::unique_ptr<ElevatedButton> mainPlayBtn;
+    std::unique_ptr<ElevatedButton> mainLevelsBtn;
+    std::unique_ptr<ElevatedButton> mainEndlessBtn;
+    std::unique_ptr<ElevatedButton> mainRaceBtn;
     std::unique_ptr<ElevatedButton> mainSettingsBtn;
     std::unique_ptr<ElevatedButton> mainQuitBtn;
 
     std::unique_ptr<ElevatedButton> settingsEasyBtn;
     std::unique_ptr<ElevatedButton> settingsNormalBtn;
     std::unique_ptr<ElevatedButton> settingsHardBtn;
+    std::unique_ptr<ElevatedButton> settingsSpeedBtn;
 
     std::unique_ptr<ElevatedButton> pauseResumeBtn;
     std::unique_ptr<ElevatedButton> pauseRestartBtn;
@@ -159,6 +419,110 @@ private:
     std::unique_ptr<ElevatedButton> completeRetryBtn;
     std::unique_ptr<ElevatedButton> completeMenuBtn;
 
+    std::array<std::unique_ptr<ElevatedButton>, LevelsPerPage> levelSlotBtns;   // one under each thumbnail
+    std::unique_ptr<ElevatedButton> levelPrevBtn;
+    std::unique_ptr<ElevatedButton> levelNextBtn;
+    std::unique_ptr<ElevatedButton> levelBackBtn;
+
+    // ---- simulation thread only below (and the constructor, before the thread starts) ----
+
+    ScreenText text;
+
+    // cached planned path (ghost preview)
+    GhostPath ghostPath;
+
+    // hint (H): best route found so far by the background search, drawn from its start cell
+    HintEngine hints;
+    bool hintActive = false;
+    std::vector<Direction> hintMoves;
+    sf::Vector2i hintStart;
+
+    // replay (R while planning): the last execution phase, recorded tick by tick, scrubbed with
+    // the arrow keys while the planning timer stands still
+    static constexpr float ReviewSpeeds[] = {-8.f, -4.f, -2.f, -1.f, -0.5f, -0.25f, 0.f, 0.25f, 0.5f, 1.f, 2.f, 4.f, 8.f};
+    static constexpr int ReviewSpeedCount = (int)(sizeof(ReviewSpeeds) / sizeof(ReviewSpeeds[0]));
+    static constexpr int ReviewPaused = 6;   // ReviewSpeeds[ReviewPaused] == 0
+    TickHistory history;
+    bool reviewing = false;
+    int reviewSpeed = ReviewPaused;
+    sf::Clock reviewClock;
+
+    // core systems (the window thread only uses the grid's textures, through Grid::draw)
+    Grid grid;
+    Player player;
+
+    // game flow
+    UIState uiState = UIState::MainMenu;
+    GamePhase phase = GamePhase::Planning;
+    float planningTime = 10.f;
+    sf::Clock phaseClock;
+    float phaseTimeOffset = 0.f;   // phase time already spent before phaseClock started (resumed save)
+
+    // execution clock (see runExecution): execMs runs speedFactor() times faster than real time
+    static constexpr float MoveIntervalMs = 250.f;
+    static constexpr float HazardIntervalMs = 220.f;
+    static constexpr float MaxExecCatchUpMs = 100.f;   // real time per update at most (pauses, hitches)
+    sf::Clock hazardClock;      // idle hazard ticks (menus, planning)
+    sf::Clock execClock;
+    float execMs = 0.f;
+    float nextMoveMs = 0.f;
+    float nextHazardMs = 0.f;
+    bool showDeath = false;
+    sf::Vector2i deathCell{0, 0};
+
+    // levels
+    std::vector<std::vector<std::string>> levels;
+    std::vector<std::shared_ptr<const LevelData>> parsedLevels;   // pristine parse per level (lazy)
+    std::shared_ptr<const std::vector<std::shared_ptr<const LevelData>>> levelCatalog;   // published copy
+    int currentLevel = 0;
+    LevelPreloader preloader;   // next level, prepared during play (declared after grid: its job reads grid)
+    LevelWatcher levelWatcher;  // LevelDir, polled every frame
+    std::vector<std::string> changedLevelFiles;
+
+    // endless mode: board streamed in columns generated ahead of the player
+    static constexpr int EndlessLookahead = 3;   // columns kept loaded ahead of the player's column
+    static constexpr int EndlessKeepBehind = 1;  // columns kept behind it (older ones are evicted)
+    bool endless = false;
+    std::uint32_t endlessSeed = 0;
+    std::vector<std::shared_ptr<const ChunkColumn>> endlessColumns;   // resident, left to right
+    ChunkStreamer streamer;
+
+    // race mode: campaign levels raced against solver ghosts plus a replay of your previous attempt
+    static constexpr int RaceGhosts = 256;
+    bool race = false;
+    AgentStore agents;
+    RacePlanner racePlanner;
+    std::shared_ptr<const RacePlans> racePlans;   // solver runs for raceLevel, reused by retries
+    std::shared_ptr<const LevelData> raceLevel;
+    Difficulty raceDifficulty = Difficulty::Normal;
+    std::vector<std::uint8_t> raceRecording;      // this attempt's plans (AgentStore format)
+    std::vector<std::uint8_t> lastAttempt;        // the previous attempt on raceLevel
+    bool lastAttemptCleared = false;
+
+    // copy-on-write grid snapshots: level start (death / retry) and turn start (Shift+K)
+    Grid::Snapshot levelStartSnapshot;
+    Grid::Snapshot turnStartSnapshot;
+
+    // blocks / actions
+    int blocksLeft = 3;
+    std::vector<sf::Vector2i> placedBlocks;      // order of placements
+    std::vector<ActionRecord> actionHistory;     // LIFO history for undo
+
+    // settings & level state
+    Settings settings;
+    LevelState levelState;
+
+    // save / resume of campaign levels: autosaved at every turn start, when execution starts
+    // and on exit, restored on launch
+    SaveWriter saveWriter{"savegame.dat"};
+    SaveState saveScratch;                 // reused, so autosaves stop allocating once warm
+    std::vector<std::uint8_t> saveBytes;
+    bool saveDue = false;
+
+    // gameplay events -> run_log.txt (drained by the log's own writer thread)
+    EventLog eventLog;
+    int turnNumber = 0;   // turns started in the current level / run
+
     // (optional) you may add separate GameComplete buttons later if desired
 };
 
@@ -0,0 +1,53 @@
+#include "GhostPath.h"
+#include "Grid.h"
+#include "Player.h"
+
+bool GhostPath::isValidFor(const GridState& grid, sf::Vector2i s, const MovePlan& plan) const
+{
+    return initialized
+        && gridRevision == grid.getRevision()
+        && start == s
+        && planRevision == plan.revision();
+}
+
+void GhostPath::rebuild(const GridState& grid, sf::Vector2i s, const MovePlan& plan)
+{
+    count = 0;
+    movesCovered = 0;
+    blocked = false;
+    initialized = true;
+    start = s;
+    gridRevision = grid.getRevision();
+
+    for (Direction d : plan) step(grid, d);
+    planRevision = plan.revision();
+}
+
+void GhostPath::append(const GridState& grid, const MovePlan& plan)
+{
+    step(grid, plan.back());
+    planRevision = plan.revision();
+}
+
+void GhostPath::step(const GridState& grid, Direction d)
+{
+    ++movesCovered;
+    if (blocked) return;   // path already ended at an obstacle
+
+    sf::Vector2i p = Player::stepFrom(endCell(), d, grid.getBounds());
+    cells[count++] = p;
+    if (grid.isBlocked(p)) blocked = true;
+}
+
+void GhostPath::popBack(const MovePlan& plan)
+{
+    planRevision = plan.revision();
+    if (movesCovered == 0) return;
+    --movesCovered;
+
+    // moves past the blocked cell never added a cell
+    if (count > movesCovered) {
+        --count;
+        blocked = false;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include "MovePlan.h"
+
+class GridState;
+
+// GhostPath: cells the planned moves will visit, computed once per plan change.
+// Kept in sync incrementally (append / popBack) and rebuilt when the player's start
+// cell, the grid's walkability or the plan changes any other way (executed, cleared,
+// reassigned). Shared by the ghost preview and
+// block placement so both always agree on where the plan ends.
+class GhostPath {
+public:
+    // true if the cache still describes this start cell, plan revision and grid state
+    bool isValidFor(const GridState& grid, sf::Vector2i start, const MovePlan& plan) const;
+
+    void rebuild(const GridState& grid, sf::Vector2i start, const MovePlan& plan);
+    void append(const GridState& grid, const MovePlan& plan);   // plan.back() was just pushed
+    void popBack(const MovePlan& plan);                    // the plan's last move was just undone
+    void invalidate() { initialized = false; }
+
+    int cellCount() const { return count; }
+    sf::Vector2i cell(int i) const { return cells[i]; }
+
+    // path runs into an obstacle; the blocked cell is the last one
+    bool isBlocked() const { return blocked; }
+
+    // where the player ends up if nothing blocks the path
+    sf::Vector2i endCell() const { return count > 0 ? cells[count - 1] : start; }
+
+private:
+    void step(const GridState& grid, Direction d);
+
+    std::array<sf::Vector2i, MovePlan::Capacity> cells{};
+    int count = 0;            // cells filled (stops growing at the first blocked cell)
+    int movesCovered = 0;     // plan length this cache represents
+    std::uint32_t planRevision = 0;
+    bool blocked = false;
+    bool initialized = false;
+    sf::Vector2i start{0, 0};
+    unsigned gridRevision = 0;
+};
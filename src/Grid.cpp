@@ -1,449 +1,812 @@
 #include "Grid.h"
+#include "Trace.h"
+#include "ResourceCache.h"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+
+namespace {
+    // parallel to HazardType
+    const HazardInfo HazardTable[(size_t)HazardType::Count] = {
+        {"C>", false, {1, 0},  "Cannon_Right.png"},
+        {"C<", false, {-1, 0}, "Cannon_Left.png"},
+        {"L^", true,  {0, -1}, "Laser_UP.png"},
+        {"Lv", true,  {0, 1},  "Laser_Down.png"},
+        {"C^", false, {0, -1}, "Cannon_UP.png"},
+        {"Cv", false, {0, 1},  "Cannon_Down.png"},
+        {"L<", true,  {-1, 0}, "Laser_Left.png"},
+        {"L>", true,  {1, 0},  "Laser_Right.png"},
+    };
+}
 
-void Grid::load()
+const HazardInfo& hazardInfo(HazardType t)
 {
-    if (!textureGrass.loadFromFile("assets/Grass.png"))
-        std::cerr << "Error loading Grass.png\n";
-    if (!textureChest.loadFromFile("assets/Chest.png"))
-        std::cerr << "Error loading Chest.png\n";
-    if (!textureTree.loadFromFile("assets/Tree.png"))
-        std::cerr << "Error loading Tree.png\n";
-    if (!textureWater.loadFromFile("assets/Water.png"))
-        std::cerr << "Error loading Water.png\n";
-    if (!textureBlock.loadFromFile("assets/Block.png"))
-        std::cerr << "Error loading Block.png\n";
-
-    // hazard textures
-    if (!textureCannonRight.loadFromFile("assets/Cannon_Right.png"))
-        std::cerr << "Error loading Cannon_Right.png\n";
-    if (!textureCannonLeft.loadFromFile("assets/Cannon_Left.png"))
-        std::cerr << "Error loading Cannon_Left.png\n";
-    if (!textureLaserUp.loadFromFile("assets/Laser_UP.png"))
-        std::cerr << "Error loading Laser_UP.png\n";
-    if (!textureLaserDown.loadFromFile("assets/Laser_Down.png"))
-        std::cerr << "Error loading Laser_Down.png\n";
-    if (!textureLaserBeam.loadFromFile("assets/Laser_Vertical.png"))
-        std::cerr << "Error loading Laser_Vertical.png\n";
-    if (!textureCannonBall.loadFromFile("assets/Cannon_Ball.png"))
-        std::cerr << "Error loading Cannon_Ball.png\n";
-
-    textureGrass.setSmooth(false);
-    textureChest.setSmooth(true);
-    textureTree.setSmooth(true);
-    textureWater.setSmooth(true);
-    textureBlock.setSmooth(true);
-    textureLaserBeam.setSmooth(true);
-    textureCannonBall.setSmooth(true);
+    return HazardTable[(size_t)t];
 }
 
-void Grid::loadLevel(const std::vector<std::string>& layout)
+HazardType hazardFromToken(char kind, char dir)
 {
-    // Reset
-    items.clear();
-    blockPositions.clear();
-    hazards.clear();
-    activeBeamCells.clear();
-    mapLayout.clear();
-    projectiles.clear();
+    for (size_t t = 0; t < (size_t)HazardType::Count; ++t)
+        if (HazardTable[t].token[0] == kind && HazardTable[t].token[1] == dir) return (HazardType)t;
+    return HazardType::Count;
+}
 
-    // store the layout rows, handling multi-char hazard tokens
-    for (int y = 0; y < (int)layout.size(); ++y) {
-        std::string row = layout[y];
-        if ((int)row.size() < GridSize) row += std::string(GridSize - row.size(), '.');
-        if ((int)row.size() > GridSize) row = row.substr(0, GridSize);
+void Grid::load()
+{
+    using Opt = ResourceCache::TextureOptions;
+    const Opt smooth{true, false};
+    struct TextureFile { std::shared_ptr<const sf::Texture>* tex; const char* file; Opt options; };
+    std::vector<TextureFile> files = {
+        {&textureGrass, "Grass.png", {false, true}},   // the whole visible lawn is one quad
+        {&textureChest, "Chest.png", smooth},
+        {&textureTree, "Tree.png", smooth},
+        {&textureWater, "Water.png", smooth},
+        {&textureBlock, "Block.png", smooth},
+
+        // hazard textures (the emitters come from the hazard table)
+        {&textureLaserBeam, "Laser_Vertical.png", smooth},
+        {&textureLaserBeamH, "Laser_Horizontal.png", smooth},
+        {&textureCannonBall, "Cannon_Ball.png", smooth},
+    };
+    for (size_t t = 0; t < (size_t)HazardType::Count; ++t)
+        files.push_back({&textureHazard[t], HazardTable[t].texture, {}});
+
+    // the cache decodes whatever isn't resident yet in parallel and shares the rest
+    std::vector<ResourceCache::TextureRequest> requests;
+    for (const TextureFile& f : files) requests.push_back({std::string("assets/") + f.file, f.options});
+    auto loaded = ResourceCache::textures(requests);
+    for (size_t i = 0; i < loaded.size(); ++i) *files[i].tex = std::move(loaded[i]);
+}
 
-        for (int x = 0; x < GridSize; ++x)
+std::shared_ptr<const LevelData> GridState::parseLevel(const std::vector<std::string>& layout)
+{
+    TRACE_SCOPE("GridState::parseLevel");
+    auto data = std::make_shared<LevelData>();
+    LevelData& L = *data;
+
+    // '@' lines aren't rows: they give a hazard its schedule (applied once the hazards are known)
+    std::vector<const std::string*> rows, schedules;
+    for (const std::string& line : layout) (!line.empty() && line[0] == '@' ? schedules : rows).push_back(&line);
+
+    // board size comes from the layout itself (widest row x row count)
+    L.height = (int)rows.size();
+    for (auto* row : rows) L.width = std::max(L.width, (int)row->size());
+    L.chunksX = (L.width + ChunkSize - 1) / ChunkSize;
+    L.chunksY = (L.height + ChunkSize - 1) / ChunkSize;
+    L.chunks.resize((size_t)L.chunksX * L.chunksY);
+    for (auto& c : L.chunks) c.tiles.fill('.');
+
+    auto setTile = [&L](int x, int y, char c) {
+        Chunk& ch = L.chunks[(y >> ChunkShift) * L.chunksX + (x >> ChunkShift)];
+        ch.tiles[((y & ChunkMask) << ChunkShift) | (x & ChunkMask)] = c;
+    };
+    auto chunkOf = [&L](sf::Vector2i p) -> Chunk& {
+        return L.chunks[(p.y >> ChunkShift) * L.chunksX + (p.x >> ChunkShift)];
+    };
+
+    // store the tiles, handling multi-char hazard tokens (the 2nd char cell stays grass)
+    for (int y = 0; y < L.height; ++y) {
+        const std::string& row = *rows[y];
+
+        for (int x = 0; x < (int)row.size(); ++x)
         {
             char c = row[x];
 
-            // Cannons: 'C>' or 'C<'
-            if (c == 'C' && x + 1 < (int)layout[y].size())
+            if ((c == 'C' || c == 'L') && x + 1 < (int)row.size())
             {
-                char dir = layout[y][x+1];
-                if (dir == '>') {
-                    hazards.push_back({{x, y}, HazardType::CannonRight, 0});
-                    row[x] = '.'; if (x+1 < GridSize) row[x+1] = '.';
-                    ++x;
-                    continue;
-                } else if (dir == '<') {
-                    hazards.push_back({{x, y}, HazardType::CannonLeft, 0});
-                    row[x] = '.'; if (x+1 < GridSize) row[x+1] = '.';
+                // Cannons 'C>' 'C<' 'C^' 'Cv', lasers 'L>' 'L<' 'L^' 'Lv' (see the hazard table)
+                HazardType type = hazardFromToken(c, row[x+1]);
+                if (type != HazardType::Count) {
+                    chunkOf({x, y}).hazards.push_back((int)L.hazards.size());
+                    L.hazards.push_back({{x, y}, type, {}});
+                    setTile(x, y, 'H');
                     ++x;
                     continue;
                 }
             }
 
-            // Lasers: 'Lv' (down) or 'L^' (up)
-            if (c == 'L' && x + 1 < (int)layout[y].size())
-            {
-                char dir = layout[y][x+1];
-                if (dir == 'v') {
-                    hazards.push_back({{x, y}, HazardType::LaserDown, 0});
-                    row[x] = '.'; if (x+1 < GridSize) row[x+1] = '.';
-                    ++x;
-                    continue;
-                } else if (dir == '^') {
-                    hazards.push_back({{x, y}, HazardType::LaserUp, 0});
-                    row[x] = '.'; if (x+1 < GridSize) row[x+1] = '.';
-                    ++x;
-                    continue;
-                }
+            if (c == 'I') {
+                L.itemAt[y * L.width + x] = (int)L.items.size();
+                chunkOf({x, y}).items.push_back((int)L.items.size());
+                L.items.push_back({{x, y}, false});
             }
 
-            row[x] = c;
+            // unknown symbols (e.g. 'P', which is informational) become grass
+            setTile(x, y, (c == 'T' || c == '~' || c == 'I') ? c : '.');
         }
+    }
 
-        mapLayout.push_back(row);
+    for (const std::string* line : schedules) {
+        int x = 0, y = 0;
+        HazardSchedule sched;
+        if (!HazardSchedule::parse(*line, x, y, sched)) {
+            std::cerr << "Bad hazard schedule (ignored): " << *line << "\n";
+            continue;
+        }
+        auto h = std::find_if(L.hazards.begin(), L.hazards.end(), [&](const Hazard& h) { return h.pos == sf::Vector2i{x, y}; });
+        if (h == L.hazards.end()) std::cerr << "No hazard at " << x << "," << y << " for: " << *line << "\n";
+        else h->schedule = sched;
     }
 
-    // collect items (I) into items vector
-    for (int y = 0; y < (int)mapLayout.size(); ++y)
-        for (int x = 0; x < (int)mapLayout[y].size(); ++x)
-            if (mapLayout[y][x] == 'I')
-                items.push_back({{x, y}, false});
+    return data;
+}
 
-    // compute initial beams (lasers)
-    for (auto &h : hazards) h.beamProgress = 0;
-    computeBeams();
+void Grid::loadLevel(const std::vector<std::string>& layout)
+{
+    loadLevel(parseLevel(layout));
+}
 
-    // projectiles empty at start
-    projectiles.clear();
+void Grid::loadLevel(std::shared_ptr<const LevelData> data)
+{
+    loadLevel(std::move(*prepareLevel(std::move(data))));
+}
+
+std::shared_ptr<Grid::PreparedLevel> Grid::prepareLevel(std::shared_ptr<const LevelData> data) const
+{
+    TRACE_SCOPE("Grid::prepareLevel");
+    auto p = std::make_shared<PreparedLevel>();
+    const LevelData& L = *data;
+
+    p->batches.resize(L.chunks.size());
+    for (int cy = 0; cy < L.chunksY; ++cy)
+        for (int cx = 0; cx < L.chunksX; ++cx)
+            buildChunkBatch(L, cx, cy, p->batches[cy * L.chunksX + cx]);
+
+    // fresh mutable state (never shared with snapshots of a previous level); lasers start
+    // at zero length, so the initial beam set is empty
+    p->start = startState(L);
+    p->projectiles.reserve(maxProjectiles(L));
+
+    p->level = std::move(data);
+    return p;
 }
 
-void Grid::draw(sf::RenderWindow& win)
+void Grid::loadLevel(PreparedLevel&& prepared)
 {
-    sf::Sprite tile(textureGrass);
-    tile.setScale({
-        (float)CellSize / textureGrass.getSize().x,
-        (float)CellSize / textureGrass.getSize().y
-    });
+    TRACE_SCOPE("Grid::loadLevel");
+    batches = std::make_shared<std::vector<ChunkBatch>>(std::move(prepared.batches));
+    adopt(std::move(prepared.level), std::move(prepared.start), std::move(prepared.projectiles));
+}
 
-    float originX = (WindowWidth  - GridSize * CellSize) / 2.f;
-    float originY = (WindowHeight - GridSize * CellSize) / 2.f;
+void Grid::reloadLevel(std::shared_ptr<const LevelData> next)
+{
+    TRACE_SCOPE("Grid::reloadLevel");
+    if (next->width != level->width || next->height != level->height || next->originX != level->originX
+        || batches->size() != next->chunks.size()) {
+        loadLevel(std::move(next));
+        return;
+    }
 
-    for (int y = 0; y < GridSize; ++y)
-    {
-        for (int x = 0; x < GridSize; ++x)
+    // render batches: only chunks with different tiles
+    const LevelData& old = *level;
+    for (int cy = 0; cy < next->chunksY; ++cy)
+        for (int cx = 0; cx < next->chunksX; ++cx) {
+            int ci = cy * next->chunksX + cx;
+            if (old.chunks[ci].tiles == next->chunks[ci].tiles) continue;
+            std::vector<ChunkBatch>& b = writable(batches);
+            b[ci] = ChunkBatch{};
+            buildChunkBatch(*next, cx, cy, b[ci]);
+        }
+
+    GridState::reloadLevel(std::move(next));
+}
+
+void Grid::shiftLevel(std::shared_ptr<const LevelData> next)
+{
+    TRACE_SCOPE("Grid::shiftLevel");
+    const LevelData& old = *level;
+
+    // reuse vertex batches of chunks that are still resident, build the new ones
+    auto newBatches = std::make_shared<std::vector<ChunkBatch>>(next->chunks.size());
+    std::vector<ChunkBatch>& oldBatches = writable(batches);   // moved from below
+    int oldCol0 = old.originX / ChunkSize;
+    int newCol0 = next->originX / ChunkSize;
+    for (int cy = 0; cy < next->chunksY; ++cy)
+        for (int cx = 0; cx < next->chunksX; ++cx)
         {
-            char c = mapLayout[y][x];
-            tile.setPosition({originX + x * CellSize, originY + y * CellSize});
-            win.draw(tile);
+            ChunkBatch& b = (*newBatches)[cy * next->chunksX + cx];
+            int ocx = newCol0 + cx - oldCol0;
+            if (ocx >= 0 && ocx < old.chunksX && cy < old.chunksY && !oldBatches.empty())
+                b = std::move(oldBatches[cy * old.chunksX + ocx]);
+            else
+                buildChunkBatch(*next, cx, cy, b);
+        }
+    batches = std::move(newBatches);
 
-            const sf::Texture* tex = nullptr;
-            if (c == 'T') tex = &textureTree;
-            else if (c == '~') tex = &textureWater;
-            else if (c == 'I') tex = &textureChest;
+    GridState::shiftLevel(std::move(next));
+}
 
-            if (tex)
-            {
-                bool skip = false;
-                if (c == 'I')
-                    for (auto& i : items)
-                        if (i.gridPos == sf::Vector2i(x, y) && i.collected)
-                            skip = true;
-
-                if (!skip)
-                {
-                    sf::Sprite obj(*tex);
-                    obj.setScale({
-                        (float)CellSize / tex->getSize().x,
-                        (float)CellSize / tex->getSize().y
-                    });
-                    obj.setPosition({originX + x * CellSize, originY + y * CellSize});
-                    win.draw(obj);
-                }
+// ---------------- Level state ----------------
+
+GridState::Snapshot GridState::startState(const LevelData& data)
+{
+    Snapshot s;
+    s.items = std::make_shared<std::vector<Item>>(data.items);
+    s.blocks = std::make_shared<std::vector<sf::Vector2i>>();
+    s.beams = std::make_shared<BeamState>();
+    s.beams->progress.assign(data.hazards.size(), 0);
+    s.beams->length.assign(data.hazards.size(), 0);
+    s.beams->count.assign((size_t)data.width * data.height, 0);
+    return s;
+}
+
+size_t GridState::maxProjectiles(const LevelData& data)
+{
+    size_t maxBalls = data.hazards.size() * (size_t)std::max(data.width, data.height);
+    return std::min<size_t>(maxBalls, 1 << 16);
+}
+
+void GridState::adopt(std::shared_ptr<const LevelData> data, Snapshot start, std::vector<Projectile> balls)
+{
+    ++revision;
+    level = std::move(data);
+    items = std::move(start.items);
+    blockPositions = std::move(start.blocks);
+    beams = std::move(start.beams);
+    projectiles = std::move(balls);
+    hazardStep = 0;
+    timers.stale = true;
+    computeBeams();
+}
+
+void GridState::loadLevel(std::shared_ptr<const LevelData> data)
+{
+    std::vector<Projectile> balls;
+    balls.reserve(maxProjectiles(*data));
+    Snapshot start = startState(*data);
+    adopt(std::move(data), std::move(start), std::move(balls));
+}
+
+void GridState::reloadLevel(std::shared_ptr<const LevelData> next)
+{
+    TRACE_SCOPE("GridState::reloadLevel");
+    if (next->width != level->width || next->height != level->height || next->originX != level->originX) {
+        loadLevel(std::move(next));
+        return;
+    }
+
+    auto oldLevel = level;   // keeps the old data alive while state is carried over
+    const LevelData& old = *oldLevel;
+
+    // chests that didn't move keep their collected flag
+    auto newItems = std::make_shared<std::vector<Item>>(next->items);
+    for (Item& it : *newItems) {
+        int oi = old.itemIndex(it.gridPos);
+        if (oi >= 0) it.collected = (*items)[oi].collected;
+    }
+
+    // lasers that didn't move / turn keep their current length (clamped by computeBeams)
+    auto newBeams = std::make_shared<BeamState>();
+    newBeams->progress.assign(next->hazards.size(), 0);
+    for (size_t i = 0; i < next->hazards.size(); ++i)
+        for (size_t j = 0; j < old.hazards.size(); ++j)
+            if (old.hazards[j].pos == next->hazards[i].pos && old.hazards[j].type == next->hazards[i].type) {
+                newBeams->progress[i] = beams->progress[j];
+                break;
             }
+
+    level = std::move(next);
+    items = newItems;
+    beams = newBeams;
+    timers.stale = true;   // hazards / schedules may have changed
+
+    // blocks on cells that are now walls / hazards go, and so do balls inside anything solid
+    auto walled = [this](sf::Vector2i p) {
+        char c = level->tile(p.x, p.y);
+        return c == 'T' || c == '~' || c == 'H';
+    };
+    if (std::any_of(blockPositions->begin(), blockPositions->end(), walled)) {
+        auto& blocks = blocksPool.writable(blockPositions);
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), walled), blocks.end());
+    }
+    projectiles.erase(
+        std::remove_if(projectiles.begin(), projectiles.end(), [&](const Projectile& pr){ return stopsShot(pr.pos); }),
+        projectiles.end()
+    );
+    projectiles.reserve(maxProjectiles(*level));
+
+    ++revision;
+    computeBeams();
+}
+
+bool GridState::restoreRuntime(const std::vector<char>& collected, const std::vector<int>& progress,
+                          const std::vector<sf::Vector2i>& blocks, const std::vector<Projectile>& balls,
+                          std::uint32_t step)
+{
+    if (collected.size() != level->items.size() || progress.size() != level->hazards.size()) return false;
+    for (sf::Vector2i b : blocks)
+        if (!level->inBounds(b) || isBlocked(b)) return false;
+    for (const Projectile& p : balls)
+        if (!level->inBounds(p.pos)) return false;
+
+    auto newItems = std::make_shared<std::vector<Item>>(level->items);
+    for (size_t i = 0; i < collected.size(); ++i) (*newItems)[i].collected = collected[i] != 0;
+    auto newBeams = std::make_shared<BeamState>();
+    newBeams->progress = progress;
+
+    items = newItems;
+    beams = newBeams;
+    blockPositions = std::make_shared<std::vector<sf::Vector2i>>(blocks);
+    projectiles.assign(balls.begin(), balls.end());
+    hazardStep = step;
+    timers.stale = true;
+    ++revision;
+    computeBeams();
+    return true;
+}
+
+const char* GridState::checkLevel(const LevelData& L)
+{
+    if (L.width <= 0 || L.height <= 0) return "empty board";
+
+    auto walkable = [&](sf::Vector2i p) {
+        char c = L.tile(p.x, p.y);
+        return c != 'T' && c != '~' && c != 'H';
+    };
+    sf::Vector2i start{L.originX, L.height - 1};   // Player::resetPosition
+    if (!walkable(start)) return "player start (bottom-left) is blocked";
+
+    // flood fill from the start; blocks can only take cells away, so this is an upper bound
+    std::vector<char> seen((size_t)L.width * L.height, 0);
+    std::vector<sf::Vector2i> stack{start};
+    seen[(size_t)start.y * L.width + (start.x - L.originX)] = 1;
+    const sf::Vector2i dirs[] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    while (!stack.empty()) {
+        sf::Vector2i p = stack.back();
+        stack.pop_back();
+        for (sf::Vector2i d : dirs) {
+            sf::Vector2i q = p + d;
+            if (!L.inBounds(q) || !walkable(q)) continue;
+            char& s = seen[(size_t)q.y * L.width + (q.x - L.originX)];
+            if (s) continue;
+            s = 1;
+            stack.push_back(q);
         }
     }
 
-    // Draw active laser beams (beam cells)
-    sf::Sprite beamSprite(textureLaserBeam);
-    beamSprite.setScale({
-        (float)CellSize / textureLaserBeam.getSize().x,
-        (float)CellSize / textureLaserBeam.getSize().y
-    });
+    for (const Item& it : L.items)
+        if (!seen[(size_t)it.gridPos.y * L.width + (it.gridPos.x - L.originX)]) return "a chest can't be reached";
+    return nullptr;
+}
 
-    for (auto& bc : activeBeamCells)
+std::shared_ptr<const LevelData> GridState::composeColumns(const std::vector<std::shared_ptr<const ChunkColumn>>& cols)
+{
+    TRACE_SCOPE("GridState::composeColumns");
+    auto data = std::make_shared<LevelData>();
+    if (cols.empty()) return data;
+
+    LevelData& L = *data;
+    L.originX = cols.front()->column * ChunkSize;
+    L.height = cols.front()->height;
+    L.chunksX = (int)cols.size();
+    L.chunksY = (int)cols.front()->chunks.size();
+    L.width = L.chunksX * ChunkSize;
+    L.chunks.resize((size_t)L.chunksX * L.chunksY);
+
+    // columns are appended left to right, so items / hazards stay ordered by column
+    for (int cx = 0; cx < L.chunksX; ++cx)
     {
-        beamSprite.setRotation(sf::degrees(0.f));
-        beamSprite.setPosition({originX + bc.x * CellSize, originY + bc.y * CellSize});
-        win.draw(beamSprite);
+        const ChunkColumn& col = *cols[cx];
+        int itemBase = (int)L.items.size();
+        int hazardBase = (int)L.hazards.size();
+
+        for (int cy = 0; cy < L.chunksY; ++cy) {
+            Chunk& c = L.chunks[cy * L.chunksX + cx];
+            c = col.chunks[cy];
+            for (int& i : c.items) i += itemBase;
+            for (int& h : c.hazards) h += hazardBase;
+        }
+
+        for (auto& it : col.items) {
+            L.itemAt[it.gridPos.y * L.width + (it.gridPos.x - L.originX)] = (int)L.items.size();
+            L.items.push_back(it);
+        }
+        L.hazards.insert(L.hazards.end(), col.hazards.begin(), col.hazards.end());
     }
 
-    // Draw hazards (laser/cannon bases) on top of beams
-    for (auto& h : hazards)
+    return data;
+}
+
+void GridState::shiftLevel(std::shared_ptr<const LevelData> next)
+{
+    TRACE_SCOPE("GridState::shiftLevel");
+    std::shared_ptr<const LevelData> oldLevel = level;   // keeps the old board alive until we're done
+    const LevelData& old = *oldLevel;
+
+    // evicted columns are a prefix of the old item / hazard lists; the survivors come first in
+    // the new lists in the same order, so their collected flags / beam progress carry over by index
+    int dropItems = 0;
+    while (dropItems < (int)items->size() && (*items)[dropItems].gridPos.x < next->originX) ++dropItems;
+    int dropHazards = 0;
+    while (dropHazards < (int)old.hazards.size() && old.hazards[dropHazards].pos.x < next->originX) ++dropHazards;
+
+    auto newItems = std::make_shared<std::vector<Item>>(next->items);
+    for (int i = dropItems, j = 0; i < (int)items->size() && j < (int)newItems->size(); ++i, ++j)
+        (*newItems)[j].collected = (*items)[i].collected;
+
+    auto newBeams = std::make_shared<BeamState>();
+    newBeams->progress.assign(next->hazards.size(), 0);
+    for (int i = dropHazards, j = 0; i < (int)beams->progress.size() && j < (int)newBeams->progress.size(); ++i, ++j)
+        newBeams->progress[j] = beams->progress[i];
+
+    level = std::move(next);
+    items = newItems;
+    beams = newBeams;
+    timers.stale = true;   // hazards / schedules may have changed
+
+    // blocks / projectiles that scrolled off the board are dropped
+    auto outside = [this](sf::Vector2i p) { return !level->inBounds(p); };
+    if (std::any_of(blockPositions->begin(), blockPositions->end(), outside)) {
+        auto& blocks = blocksPool.writable(blockPositions);
+        blocks.erase(std::remove_if(blocks.begin(), blocks.end(), outside), blocks.end());
+    }
+    projectiles.erase(
+        std::remove_if(projectiles.begin(), projectiles.end(), [&](const Projectile& pr){ return outside(pr.pos); }),
+        projectiles.end()
+    );
+    projectiles.reserve(maxProjectiles(*level));
+
+    ++revision;
+    computeBeams();
+}
+
+// ---------------- Rendering ----------------
+
+namespace {
+    void appendQuad(sf::VertexArray& va, float x, float y, float w, float h, sf::Vector2f texSize)
     {
-        const sf::Texture* tex = nullptr;
-        float rotation = 0.f;
+        sf::Vertex a{{x, y}, sf::Color::White, {0.f, 0.f}};
+        sf::Vertex b{{x + w, y}, sf::Color::White, {texSize.x, 0.f}};
+        sf::Vertex c{{x + w, y + h}, sf::Color::White, {texSize.x, texSize.y}};
+        sf::Vertex d{{x, y + h}, sf::Color::White, {0.f, texSize.y}};
+        va.append(a); va.append(b); va.append(c);
+        va.append(a); va.append(c); va.append(d);
+    }
+}
 
-        switch (h.type) {
-            case HazardType::CannonRight:
-                tex = &textureCannonRight;
-                rotation = 0.f;
-                break;
-            case HazardType::CannonLeft:
-                tex = &textureCannonLeft;
-                rotation = 0.f;
-                break;
-            case HazardType::LaserDown:
-                tex = &textureLaserDown;
-                rotation = 0.f;
-                break;
-            case HazardType::LaserUp:
-                tex = &textureLaserUp;
-                rotation = 0.f;
-                break;
+void Grid::buildChunkBatch(const LevelData& data, int cx, int cy, ChunkBatch& b) const
+{
+    sf::Vector2f treeSize(textureTree->getSize());
+    sf::Vector2f waterSize(textureWater->getSize());
+
+    int x0 = data.originX + cx * ChunkSize;
+    int x1 = std::min(data.originX + data.width, x0 + ChunkSize);
+    int y1 = std::min(data.height, (cy + 1) * ChunkSize);
+
+    for (int y = cy * ChunkSize; y < y1; ++y)
+        for (int x = x0; x < x1; ++x)
+        {
+            char c = data.tile(x, y);
+            if (c == 'T') appendQuad(b.trees, (float)x * CellSize, (float)y * CellSize, CellSize, CellSize, treeSize);
+            else if (c == '~') appendQuad(b.water, (float)x * CellSize, (float)y * CellSize, CellSize, CellSize, waterSize);
         }
+}
 
-        if (tex) {
-            sf::Sprite obj(*tex);
-            obj.setScale({
-                (float)CellSize / tex->getSize().x,
-                (float)CellSize / tex->getSize().y
-            });
-            obj.setPosition({originX + h.pos.x * CellSize, originY + h.pos.y * CellSize});
-            obj.setRotation(sf::degrees(rotation));
-            win.draw(obj);
+void Grid::fillFrame(Frame& out, const GridState& state) const
+{
+    Snapshot parts = state.snapshot();
+    out.level = state.getLevel();
+    out.batches = batches;
+    out.items = parts.items;
+    out.blocks = parts.blocks;
+
+    out.beamCells.clear();
+    out.beamHorizontal.clear();
+    const std::vector<Hazard>& hazards = state.getLevel()->hazards;
+    const std::vector<int>& lengths = state.getBeamLengths();
+    for (size_t hi = 0; hi < hazards.size(); ++hi) {
+        sf::Vector2i dir = hazards[hi].info().dir;
+        sf::Vector2i cur = hazards[hi].pos;
+        for (int k = 0; k < lengths[hi]; ++k) {
+            cur += dir;
+            out.beamCells.push_back(cur);
+            out.beamHorizontal.push_back(dir.y == 0);
         }
     }
+    out.projectiles.assign(state.getProjectiles().begin(), state.getProjectiles().end());
+}
+
+void Grid::draw(sf::RenderTarget& win, const Frame& f)
+{
+    TRACE_SCOPE("Grid::draw");
+    if (!f.level || f.level->width == 0 || f.level->height == 0) return;
+    const LevelData& L = *f.level;
+
+    // visible cell range from the current view (world units: cell (x,y) at x*CellSize, y*CellSize)
+    const sf::View& view = win.getView();
+    sf::Vector2f c = view.getCenter();
+    sf::Vector2f half = {view.getSize().x / 2.f, view.getSize().y / 2.f};
+    int x0 = std::max(L.originX, (int)std::floor((c.x - half.x) / CellSize));
+    int y0 = std::max(0, (int)std::floor((c.y - half.y) / CellSize));
+    int x1 = std::min(L.originX + L.width, (int)std::ceil((c.x + half.x) / CellSize));
+    int y1 = std::min(L.height, (int)std::ceil((c.y + half.y) / CellSize));
+    if (x0 >= x1 || y0 >= y1) return;
+
+    auto visible = [&](sf::Vector2i p) { return p.x >= x0 && p.x < x1 && p.y >= y0 && p.y < y1; };
+    auto scaleFor = [](const sf::Texture& t) {
+        return sf::Vector2f{(float)CellSize / t.getSize().x, (float)CellSize / t.getSize().y};
+    };
+
+    // grass: one repeated-texture quad over the visible cells
+    {
+        sf::Vector2f ts(textureGrass->getSize());
+        grassQuad.clear();
+        float px = (float)x0 * CellSize, py = (float)y0 * CellSize;
+        float w = (float)(x1 - x0) * CellSize, h = (float)(y1 - y0) * CellSize;
+        sf::Vertex a{{px, py}, sf::Color::White, {0.f, 0.f}};
+        sf::Vertex b{{px + w, py}, sf::Color::White, {ts.x * (x1 - x0), 0.f}};
+        sf::Vertex cc{{px + w, py + h}, sf::Color::White, {ts.x * (x1 - x0), ts.y * (y1 - y0)}};
+        sf::Vertex d{{px, py + h}, sf::Color::White, {0.f, ts.y * (y1 - y0)}};
+        grassQuad.append(a); grassQuad.append(b); grassQuad.append(cc);
+        grassQuad.append(a); grassQuad.append(cc); grassQuad.append(d);
+        win.draw(grassQuad, sf::RenderStates(textureGrass.get()));
+    }
+
+    // static obstacles + chests, per visible chunk
+    int cx0 = (x0 - L.originX) >> ChunkShift, cx1 = (x1 - 1 - L.originX) >> ChunkShift;
+    int cy0 = y0 >> ChunkShift, cy1 = (y1 - 1) >> ChunkShift;
+
+    sf::Sprite chest(*textureChest);
+    chest.setScale(scaleFor(*textureChest));
+
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+        {
+            int ci = cy * L.chunksX + cx;
+            const ChunkBatch& b = (*f.batches)[ci];
+            if (b.trees.getVertexCount()) win.draw(b.trees, sf::RenderStates(textureTree.get()));
+            if (b.water.getVertexCount()) win.draw(b.water, sf::RenderStates(textureWater.get()));
+
+            for (int idx : L.chunks[ci].items)
+            {
+                const Item& it = (*f.items)[idx];
+                if (it.collected) continue;
+                chest.setPosition({(float)it.gridPos.x * CellSize, (float)it.gridPos.y * CellSize});
+                win.draw(chest);
+            }
+        }
+
+    // Draw active laser beams (beam cells)
+    sf::Sprite beamSprite(*textureLaserBeam);
+    beamSprite.setScale(scaleFor(*textureLaserBeam));
+    sf::Sprite beamSpriteH(*textureLaserBeamH);
+    beamSpriteH.setScale(scaleFor(*textureLaserBeamH));
+
+    for (size_t i = 0; i < f.beamCells.size(); ++i)
+    {
+        sf::Vector2i bc = f.beamCells[i];
+        if (!visible(bc)) continue;
+        sf::Sprite& s = f.beamHorizontal[i] ? beamSpriteH : beamSprite;
+        s.setPosition({(float)bc.x * CellSize, (float)bc.y * CellSize});
+        win.draw(s);
+    }
+
+    // Draw hazards (laser/cannon bases) on top of beams
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+            for (int hi : L.chunks[cy * L.chunksX + cx].hazards)
+            {
+                const Hazard& h = L.hazards[hi];
+                const sf::Texture* tex = textureHazard[(size_t)h.type].get();
+
+                sf::Sprite obj(*tex);
+                obj.setScale(scaleFor(*tex));
+                obj.setPosition({(float)h.pos.x * CellSize, (float)h.pos.y * CellSize});
+                win.draw(obj);
+            }
 
     // Draw projectiles (cannon balls)
-    sf::Sprite ballSprite(textureCannonBall);
-    ballSprite.setScale({
-        (float)CellSize / textureCannonBall.getSize().x,
-        (float)CellSize / textureCannonBall.getSize().y
-    });
+    sf::Sprite ballSprite(*textureCannonBall);
+    ballSprite.setScale(scaleFor(*textureCannonBall));
 
-    for (auto& p : projectiles)
+    for (auto& p : f.projectiles)
     {
-        if (!p.alive) continue;
-        ballSprite.setPosition({originX + p.pos.x * CellSize, originY + p.pos.y * CellSize});
+        if (!p.alive || !visible(p.pos)) continue;
+        ballSprite.setPosition({(float)p.pos.x * CellSize, (float)p.pos.y * CellSize});
         win.draw(ballSprite);
     }
 
     // Draw placed blocks
-    for (auto& b : blockPositions)
+    sf::Sprite blockSprite(*textureBlock);
+    blockSprite.setScale(scaleFor(*textureBlock));
+    for (auto& b : *f.blocks)
     {
-        sf::Sprite obj(textureBlock);
-        obj.setScale({
-            (float)CellSize / textureBlock.getSize().x,
-            (float)CellSize / textureBlock.getSize().y
-        });
-        obj.setPosition({originX + b.x * CellSize, originY + b.y * CellSize});
-        win.draw(obj);
+        if (!visible(b)) continue;
+        blockSprite.setPosition({(float)b.x * CellSize, (float)b.y * CellSize});
+        win.draw(blockSprite);
     }
 }
 
-void Grid::placeBlock(const sf::Vector2i& pos)
+// ---------------- Blocks / items ----------------
+
+void GridState::placeBlock(const sf::Vector2i& pos)
 {
+    TRACE_SCOPE("GridState::placeBlock");
     if (isBlocked(pos) || hasBlockAt(pos)) return;
-    blockPositions.push_back(pos);
-    computeBeams();
+    blocksPool.writable(blockPositions).push_back(pos);
+    ++revision;
+    wakeLasers();
+    refreshBeamsThrough(pos);
 }
 
-void Grid::removeBlock(const sf::Vector2i& pos)
+void GridState::removeBlock(const sf::Vector2i& pos)
 {
-    for (auto it = blockPositions.begin(); it != blockPositions.end(); ++it)
+    TRACE_SCOPE("GridState::removeBlock");
+    for (int i = 0; i < (int)blockPositions->size(); ++i)
     {
-        if (*it == pos)
+        if ((*blockPositions)[i] == pos)
         {
-            blockPositions.erase(it);
-            computeBeams();
+            auto& blocks = blocksPool.writable(blockPositions);
+            blocks.erase(blocks.begin() + i);
+            ++revision;
+            wakeLasers();
+            refreshBeamsThrough(pos);
             return;
         }
     }
 }
 
-void Grid::clearBlocks()
+void GridState::clearBlocks()
 {
-    blockPositions.clear();
+    TRACE_SCOPE("GridState::clearBlocks");
+    if (!blockPositions->empty()) {
+        ++revision;
+        blocksPool.writable(blockPositions).clear();   // a pooled buffer, not a new vector, if shared
+        wakeLasers();
+    }
     computeBeams();
 }
 
-bool Grid::hasBlockAt(const sf::Vector2i& pos) const
+bool GridState::hasBlockAt(const sf::Vector2i& pos) const
 {
-    for (auto& b : blockPositions)
+    for (auto& b : *blockPositions)
         if (b == pos) return true;
     return false;
 }
 
-bool Grid::checkItemAt(const sf::Vector2i& playerPos)
+bool GridState::checkItemAt(const sf::Vector2i& playerPos)
 {
-    for (auto& item : items)
-    {
-        if (!item.collected && item.gridPos == playerPos)
-        {
-            item.collected = true;
-            computeBeams();
-            return true;
-        }
-    }
-    return false;
+    if (!level->inBounds(playerPos)) return false;
+    int idx = level->itemIndex(playerPos);
+    if (idx < 0 || (*items)[idx].collected) return false;
+
+    itemsPool.writable(items)[idx].collected = true;
+    wakeLasers();
+    refreshBeamsThrough(playerPos);
+    return true;
 }
 
-bool Grid::isBlocked(const sf::Vector2i& pos) const
+bool GridState::isBlocked(const sf::Vector2i& pos) const
 {
-    if (pos.y < 0 || pos.y >= (int)mapLayout.size() ||
-        pos.x < 0 || pos.x >= (int)mapLayout[0].size())
+    if (!level->inBounds(pos))
         return true;
 
-    // origin hazards are not walkable
-    for (auto &h : hazards) {
-        if (h.pos == pos) return true;
-    }
-
-    char c = mapLayout[pos.y][pos.x];
-
-    // Items are walkable for the player
-    return (c == 'T' || c == '~' || hasBlockAt(pos));
+    // origin hazards ('H') are not walkable; items are walkable for the player
+    char c = level->tile(pos.x, pos.y);
+    return (c == 'T' || c == '~' || c == 'H' || hasBlockAt(pos));
 }
 
-bool Grid::allItemsCollected() const
+bool GridState::allItemsCollected() const
 {
-    for (auto& i : items)
+    for (auto& i : *items)
         if (!i.collected) return false;
     return true;
 }
 
+bool GridState::stopsShot(sf::Vector2i p) const
+{
+    char c = level->tile(p.x, p.y);
+    if (c == 'T' || c == '~') return true;
+    if (c == 'I') {
+        int idx = level->itemIndex(p);
+        return idx >= 0 && !(*items)[idx].collected;
+    }
+    return hasBlockAt(p);
+}
+
 // ---------------- Hazards / Beams ----------------
 
-void Grid::computeBeams()
+void GridState::computeBeams()
 {
-    activeBeamCells.clear();
+    TRACE_SCOPE("GridState::computeBeams");
+    BeamState& b = beamsPool.writable(beams);
+    b.length.assign(level->hazards.size(), 0);
+    b.count.assign((size_t)level->width * level->height, 0);
 
-    for (auto& h : hazards)
+    // Only lasers produce continuous beams. Cannons use projectiles.
+    for (int hi = 0; hi < (int)level->hazards.size(); ++hi)
     {
-        // Only lasers produce continuous beams. Cannons use projectiles.
-        if (h.type == HazardType::CannonLeft || h.type == HazardType::CannonRight)
-            continue;
-
-        sf::Vector2i dir{0,0};
-        if (h.type == HazardType::LaserDown) dir = {0, 1};
-        else if (h.type == HazardType::LaserUp) dir = {0, -1};
-
-        sf::Vector2i cur = h.pos;
-        // add up to beamProgress cells
-        for (int step = 0; step < h.beamProgress; ++step) {
-            cur += dir;
-
-            if (cur.x < 0 || cur.x >= GridSize || cur.y < 0 || cur.y >= GridSize) break;
-
-            // double-check obstacle
-            char c = mapLayout[cur.y][cur.x];
-            bool stop = false;
-            if (c == 'T' || c == '~') stop = true;
-            else if (c == 'I') {
-                for (auto &it : items) if (it.gridPos == cur && !it.collected) { stop = true; break; }
-            } else if (hasBlockAt(cur)) stop = true;
-
-            if (stop) break;
-
-            activeBeamCells.push_back(cur);
-        }
+        const Hazard& h = level->hazards[hi];
+        if (h.info().laser) setBeamLength(b, hi, rayLength(h.pos, h.info().dir, b.progress[hi]));
     }
 }
 
-bool Grid::cellHasBeam(const sf::Vector2i& pos) const
+void GridState::setBeamLength(BeamState& b, int hi, int len) const
 {
-    for (auto& b : activeBeamCells)
-        if (b == pos) return true;
-    return false;
+    const Hazard& h = level->hazards[hi];
+    sf::Vector2i dir = h.info().dir;
+    int& cur = b.length[hi];
+    for (int k = cur + 1; k <= len; ++k) ++b.count[cellIndex(h.pos + dir * k)];
+    for (int k = len + 1; k <= cur; ++k) --b.count[cellIndex(h.pos + dir * k)];
+    cur = len;
 }
 
-void Grid::stepBeams()
+void GridState::refreshBeam(int hi)
 {
-    for (auto &h : hazards) {
-        if (h.type != HazardType::LaserDown && h.type != HazardType::LaserUp) continue;
-
-        sf::Vector2i dir = (h.type == HazardType::LaserDown) ? sf::Vector2i{0,1} : sf::Vector2i{0,-1};
-
-        sf::Vector2i cur = h.pos + dir;
-        int maxLen = 0;
-        while (cur.x >= 0 && cur.x < GridSize && cur.y >= 0 && cur.y < GridSize) {
-            bool stop = false;
-            char c = mapLayout[cur.y][cur.x];
-            if (c == 'T' || c == '~') stop = true;
-            else if (c == 'I') {
-                for (auto &it : items) {
-                    if (it.gridPos == cur && !it.collected) { stop = true; break; }
-                }
-            } else if (hasBlockAt(cur)) stop = true;
-
-            if (stop) break;
-            ++maxLen;
-            cur += dir;
-        }
+    const Hazard& h = level->hazards[hi];
+    int len = rayLength(h.pos, h.info().dir, beams->progress[hi]);
+    if (len != beams->length[hi]) setBeamLength(beamsPool.writable(beams), hi, len);
+}
 
-        if (h.beamProgress < maxLen) ++h.beamProgress;
-        if (h.beamProgress > maxLen) h.beamProgress = maxLen;
+void GridState::refreshBeamsThrough(sf::Vector2i p)
+{
+    const std::vector<Hazard>& hazards = level->hazards;
+    for (int hi = 0; hi < (int)hazards.size(); ++hi)
+    {
+        const HazardInfo& info = hazards[hi].info();
+        if (!info.laser) continue;
+        sf::Vector2i d = p - hazards[hi].pos;
+        int k = d.x * info.dir.x + d.y * info.dir.y;   // cells out along the ray, if it's on it
+        if (d == info.dir * k && k >= 1 && k <= beams->progress[hi]) refreshBeam(hi);
     }
+}
 
-    computeBeams();
+int GridState::rayLength(sf::Vector2i from, sf::Vector2i dir, int maxLen) const
+{
+    int len = 0;
+    for (sf::Vector2i cur = from + dir; len < maxLen && level->inBounds(cur) && !stopsShot(cur); cur += dir) ++len;
+    return len;
 }
 
-// ---------------- Projectile logic for cannons ----------------
+// ---------------- Hazard steps ----------------
 
-void Grid::stepProjectiles()
+void GridState::stepHazards()
 {
+    TRACE_SCOPE("GridState::stepHazards");
+    if (timers.stale) rebuildTimers();
+
     // 1) Move existing projectiles first (so newly spawned ones don't move immediately)
     for (auto& p : projectiles)
     {
         if (!p.alive) continue;
 
-        sf::Vector2i next = p.pos + p.dir;
-
-        // bounds check
-        if (next.x < 0 || next.x >= GridSize || next.y < 0 || next.y >= GridSize) {
-            p.alive = false;
-            continue;
-        }
-
-        // check obstacle at next pos: Tree, Water, uncollected chest, block -> projectile disappears
-        char c = mapLayout[next.y][next.x];
-        bool stops = false;
-        if (c == 'T' || c == '~') stops = true;
-        else if (c == 'I') {
-            for (auto& it : items) if (it.gridPos == next && !it.collected) { stops = true; break; }
-        } else if (hasBlockAt(next)) stops = true;
-
-        if (stops) {
+        // off the board, or obstacle at next pos: Tree, Water, uncollected chest, block -> projectile disappears
+        if (rayLength(p.pos, p.dir, 1) == 0) {
             p.alive = false;
             continue;
         }
 
         // move forward
-        p.pos = next;
+        p.pos += p.dir;
     }
 
-    // 2) Spawn new cannonballs after moving existing ones
-    for (auto& h : hazards)
+    // 2) The hazards due this step, in index order like a full sweep (balls spawn in that order)
+    std::uint32_t step = hazardStep++;
+    timers.due.clear();
+    timers.wheel.collect(timers.due);
+    std::sort(timers.due.begin(), timers.due.end());
+
+    for (int hi : timers.due)
     {
-        if (h.type == HazardType::CannonLeft || h.type == HazardType::CannonRight)
-        {
-            sf::Vector2i dir = (h.type == HazardType::CannonRight) ? sf::Vector2i{1,0} : sf::Vector2i{-1,0};
-            sf::Vector2i spawnPos = h.pos + dir;
+        if (timers.dueAt[hi] != step) continue;   // rescheduled since (or a duplicate)
+        timers.dueAt[hi] = HazardSchedule::Never;
+        const Hazard& h = level->hazards[hi];
+        const HazardInfo& info = h.info();
 
-            // spawn only if inside map and not immediately blocked
-            if (spawnPos.x >= 0 && spawnPos.x < GridSize && spawnPos.y >= 0 && spawnPos.y < GridSize)
-            {
-                char c = mapLayout[spawnPos.y][spawnPos.x];
-                bool blocked = false;
-                if (c == 'T' || c == '~') blocked = true;
-                else if (c == 'I') {
-                    for (auto& it : items) if (it.gridPos == spawnPos && !it.collected) { blocked = true; break; }
-                } else if (hasBlockAt(spawnPos)) blocked = true;
-
-                if (!blocked) {
-                    Projectile p;
-                    p.pos = spawnPos;
-                    p.dir = dir;
-                    p.alive = true;
-                    projectiles.push_back(p);
-                }
-            }
+        if (info.laser) {
+            if (stepLaser(hi, step)) refreshBeam(hi);
+            continue;
+        }
+
+        // cannon: spawn only if inside map and not immediately blocked
+        if (rayLength(h.pos, info.dir, 1) == 1) {
+            Projectile p;
+            p.pos = h.pos + info.dir;
+            p.dir = info.dir;
+            p.alive = true;
+            projectiles.push_back(p);
         }
+        scheduleHazard(hi, h.schedule.nextAct(step + 1));
     }
 
     // 3) Garbage-collect dead projectiles
@@ -453,21 +816,123 @@ void Grid::stepProjectiles()
     );
 }
 
-bool Grid::cellHasProjectile(const sf::Vector2i& pos) const
+bool GridState::stepLaser(int hi, std::uint32_t step)
+{
+    const Hazard& h = level->hazards[hi];
+    const HazardSchedule& sched = h.schedule;
+    int old = beams->progress[hi];
+    int progress = old;
+    bool rest = sched.restsAt(step);
+
+    if (rest) {
+        progress = 0;   // pulse over: switched off until its next window
+    } else {
+        // grow one cell up to the first obstacle; only look one cell past the current
+        // progress: that's all this step can grow
+        int maxLen = rayLength(h.pos, h.info().dir, progress + 1);
+        if (progress < maxLen) ++progress;
+        if (progress > maxLen) progress = maxLen;
+    }
+    if (progress != old) beamsPool.writable(beams).progress[hi] = progress;
+
+    // a laser that didn't change won't on its later steps either, until something in its way
+    // does: it only keeps the end of its pulse (if any) and sleeps otherwise
+    std::uint32_t next = sched.nextRest(step + 1);
+    if (rest || progress != old) {
+        next = std::min(next, sched.nextAct(step + 1));
+    } else if (!timers.asleep[hi]) {
+        timers.asleep[hi] = 1;
+        timers.sleeping.push_back(hi);
+    }
+    scheduleHazard(hi, next);
+    return progress != old;
+}
+
+void GridState::scheduleHazard(int hi, std::uint32_t at)
+{
+    if (at == HazardSchedule::Never || at >= timers.dueAt[hi]) return;
+    timers.dueAt[hi] = at;
+    timers.wheel.schedule(hi, at);
+}
+
+void GridState::rebuildTimers()
+{
+    TRACE_SCOPE("GridState::rebuildTimers");
+    size_t n = level->hazards.size();
+    timers.stale = false;
+    timers.wheel.reset(hazardStep);
+    timers.dueAt.assign(n, HazardSchedule::Never);
+    timers.asleep.assign(n, 0);
+    timers.sleeping.clear();
+
+    // everything at its next act (a laser also at the end of its pulse, whichever comes first);
+    // lasers that turn out to have nothing to do go back to sleep on that step
+    for (size_t hi = 0; hi < n; ++hi) {
+        const Hazard& h = level->hazards[hi];
+        std::uint32_t at = h.schedule.nextAct(hazardStep);
+        if (h.info().laser) at = std::min(at, h.schedule.nextRest(hazardStep));
+        scheduleHazard((int)hi, at);
+    }
+}
+
+void GridState::wakeLasers()
+{
+    if (timers.stale) return;
+    for (int hi : timers.sleeping) {
+        if (!timers.asleep[hi]) continue;
+        timers.asleep[hi] = 0;
+        scheduleHazard(hi, level->hazards[hi].schedule.nextAct(hazardStep));
+    }
+    timers.sleeping.clear();
+}
+
+// ---------------- Projectiles ----------------
+
+bool GridState::cellHasProjectile(const sf::Vector2i& pos) const
 {
     for (auto& p : projectiles)
         if (p.alive && p.pos == pos) return true;
     return false;
 }
 
-void Grid::clearProjectiles()
+void GridState::clearProjectiles()
 {
     projectiles.clear();
 }
 
-void Grid::resetItemsToOriginal()
+void GridState::resetItemsToOriginal()
+{
+    for (auto& it : itemsPool.writable(items)) it.collected = false;
+    for (auto& p : beamsPool.writable(beams).progress) p = 0;
+    wakeLasers();
+    computeBeams();
+}
+
+// ---------------- Snapshots ----------------
+
+GridState::Snapshot GridState::snapshot() const
+{
+    return {items, blockPositions, beams};
+}
+
+void GridState::restore(const Snapshot& s)
+{
+    TRACE_SCOPE("GridState::restore");
+    items = s.items;
+    beams = s.beams;
+    if (blockPositions != s.blocks) {
+        blockPositions = s.blocks;
+        ++revision;
+    }
+    projectiles.clear();
+    wakeLasers();   // chests, blocks and laser lengths all went back
+}
+
+void GridState::restoreBlocks(const Snapshot& s)
 {
-    for (auto& it : items) it.collected = false;
-    for (auto &h : hazards) h.beamProgress = 0;
+    if (blockPositions == s.blocks) return;
+    blockPositions = s.blocks;
+    ++revision;
+    wakeLasers();
     computeBeams();
 }
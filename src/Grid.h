@@ -2,24 +2,48 @@
 #include <SFML/Graphics.hpp>
 #include <vector>
 #include <string>
+#include <memory>
+#include <array>
+#include <unordered_map>
 #include "Config.h"
+#include "Hazard.h"
 
 struct Item {
     sf::Vector2i gridPos;
     bool collected = false;
 };
 
-enum class HazardType {
+// A hazard is a kind (cannon or laser) and a direction. Everything that handles one (parsing,
+// stepping, beams, drawing, solvers) reads hazardInfo() instead of switching on the type, so a
+// new direction is a row in the table (Grid.cpp) plus its sprite.
+enum class HazardType : std::uint8_t {
     CannonRight,
     CannonLeft,
     LaserUp,
-    LaserDown
+    LaserDown,
+    CannonUp,
+    CannonDown,
+    LaserLeft,
+    LaserRight,
+    Count
 };
 
+struct HazardInfo {
+    char token[3];          // in level files, e.g. "C>"
+    bool laser;             // a beam that grows (otherwise a cannon firing balls)
+    sf::Vector2i dir;       // where it fires
+    const char* texture;    // emitter sprite in assets/
+};
+
+const HazardInfo& hazardInfo(HazardType t);
+HazardType hazardFromToken(char kind, char dir);   // HazardType::Count if it isn't one
+
 struct Hazard {
     sf::Vector2i pos;
     HazardType type;
-    int beamProgress = 0; // for lasers: how many cells currently visible
+    HazardSchedule schedule;   // from the level's '@' lines (default: acts every step)
+
+    const HazardInfo& info() const { return hazardInfo(type); }
 };
 
 struct Projectile {
@@ -28,57 +52,334 @@ struct Projectile {
     bool alive = true;
 };
 
-class Grid {
+// Square block of tiles; boards are stored as a row-major array of these so a
+// neighbourhood (ray, view rect) touches a few contiguous 256-byte blocks.
+const int ChunkShift = 4;
+const int ChunkSize = 1 << ChunkShift;   // 16 x 16 tiles
+const int ChunkMask = ChunkSize - 1;
+
+struct Chunk {
+    std::array<char, ChunkSize * ChunkSize> tiles;   // '.', 'T', '~', 'I', 'H' (hazard origin)
+    std::vector<int> items;                          // indices into LevelData::items
+    std::vector<int> hazards;                        // indices into LevelData::hazards
+};
+
+// Pristine parse of a level layout. Immutable once built and shared between
+// the Grid, level-start snapshots and retries, so a restart never re-parses.
+struct LevelData {
+    int originX = 0;    // world x of the first stored column (endless mode scrolls this)
+    int width = 0;
+    int height = 0;
+    int chunksX = 0;
+    int chunksY = 0;
+    std::vector<Chunk> chunks;
+    std::vector<Hazard> hazards;
+    std::vector<Item> items;                    // all uncollected
+    std::unordered_map<int, int> itemAt;        // y * width + (x - originX) -> item index
+
+    bool inBounds(sf::Vector2i p) const { return p.x >= originX && p.y >= 0 && p.x < originX + width && p.y < height; }
+
+    char tile(int x, int y) const
+    {
+        x -= originX;
+        const Chunk& c = chunks[(y >> ChunkShift) * chunksX + (x >> ChunkShift)];
+        return c.tiles[((y & ChunkMask) << ChunkShift) | (x & ChunkMask)];
+    }
+
+    int itemIndex(sf::Vector2i p) const
+    {
+        auto it = itemAt.find(p.y * width + (p.x - originX));
+        return it == itemAt.end() ? -1 : it->second;
+    }
+};
+
+// One ChunkSize-wide strip of generated terrain (endless mode), chunks top to bottom.
+// Item / hazard positions are world cells; chunk index lists refer to this column's vectors.
+struct ChunkColumn {
+    int column = 0;     // world chunk column (cells column * ChunkSize ...)
+    int height = 0;     // board rows
+    std::vector<Chunk> chunks;
+    std::vector<Hazard> hazards;
+    std::vector<Item> items;
+};
+
+// Laser state: per-hazard beam progress and lit span (parallel to LevelData::hazards) + how many
+// beams light each cell. A laser that changes only touches the cells between its old and new
+// span ends, and "is this cell in a beam" is one lookup.
+struct BeamState {
+    std::vector<int> progress;              // for lasers: how many cells it has grown
+    std::vector<int> length;                // how many of those are lit: progress cut at the first obstacle
+    std::vector<std::uint8_t> count;        // per board cell (row-major from originX): beams through it (one per direction at most)
+};
+
+// CowPool: the buffers one state's copy-on-write part has been cloned into. A clone copies into
+// one of them nobody else holds any more (a snapshot moved on, a restore() swapped it out),
+// reusing its capacity, instead of allocating; so once a few turns have cycled through, taking
+// snapshots and writing after them allocates nothing. A part held only by the state and its
+// own slot here is written in place: after a snapshot only the first write copies. A copy of
+// the owner starts with none.
+template <class T>
+class CowPool {
 public:
-    void load();
-    void loadLevel(const std::vector<std::string>& layout);
-    void draw(sf::RenderWindow& win);
+    CowPool() = default;
+    CowPool(const CowPool&) {}
+    CowPool& operator=(const CowPool&) { return *this; }
+
+    T& writable(std::shared_ptr<T>& p)
+    {
+        if (p.use_count() == 1 || (p.use_count() == 2 && owns(p))) return *p;
+        for (auto& b : buffers) {
+            if (b && b.use_count() == 1) {
+                *b = *p;
+                p = b;
+                ++copyCount;
+                return *p;
+            }
+        }
+        p = std::make_shared<T>(*p);
+        ++copyCount;
+        for (auto& b : buffers)
+            if (!b) { b = p; break; }   // all taken: this one isn't recycled
+        return *p;
+    }
+
+    // copies of a part that writable() made, since the pool was created (for checks)
+    unsigned copies() const { return copyCount; }
+
+private:
+    bool owns(const std::shared_ptr<T>& p) const
+    {
+        for (const auto& b : buffers)
+            if (b == p) return true;
+        return false;
+    }
+
+    std::array<std::shared_ptr<T>, 6> buffers;   // the state's own, turn start / rewind copies, a spare
+    unsigned copyCount = 0;
+};
+
+// GridState: the gameplay half of a board (level, chests, blocks, beams, cannonballs) with every
+// rule that reads or changes it, and no textures or vertex data. Copying one is a handful of
+// shared_ptr copies plus the cannonball list: the parts are shared copy-on-write, so a copy
+// that changes something clones just that part. Solvers / previews / replays can clone it freely.
+class GridState {
+public:
+    // Copy-on-write snapshot of the mutable level state. Taking one only copies
+    // three shared pointers; the state clones a part the first time it writes to it
+    // while a snapshot still shares it. Projectiles are transient and not captured.
+    struct Snapshot {
+        std::shared_ptr<std::vector<Item>> items;
+        std::shared_ptr<std::vector<sf::Vector2i>> blocks;
+        std::shared_ptr<BeamState> beams;
+    };
+
+    static std::shared_ptr<const LevelData> parseLevel(const std::vector<std::string>& layout);
+
+    // fresh level-start state for `data` (nothing collected, no blocks, lasers at zero length)
+    static Snapshot startState(const LevelData& data);
+
+    // first problem found with a level (nullptr if none): empty board, start cell not
+    // walkable, a chest the player can't reach
+    static const char* checkLevel(const LevelData& data);
+
+    // endless mode: build a board from consecutive columns
+    static std::shared_ptr<const LevelData> composeColumns(const std::vector<std::shared_ptr<const ChunkColumn>>& cols);
+
+    // start `data` from scratch
+    void loadLevel(std::shared_ptr<const LevelData> data);
+
+    // swap in an edited version of the current level, keeping collected chests, beam progress,
+    // blocks and projectiles wherever they still fit (a resized board starts from scratch)
+    void reloadLevel(std::shared_ptr<const LevelData> next);
+
+    // endless mode: swap in a scrolled board, keeping the same state for the columns both share
+    void shiftLevel(std::shared_ptr<const LevelData> next);
+
+    const std::shared_ptr<const LevelData>& getLevel() const { return level; }
+    int getWidth() const { return level->width; }
+    int getHeight() const { return level->height; }
+    sf::IntRect getBounds() const { return {{level->originX, 0}, {level->width, level->height}}; }
 
     bool checkItemAt(const sf::Vector2i& playerPos);
     bool isBlocked(const sf::Vector2i& pos) const;
     bool allItemsCollected() const;
 
+    // true for cells that stop beams and cannon balls (trees, water, uncollected chests, blocks)
+    bool stopsShot(sf::Vector2i p) const;
+
     // 🧱 Block functions
     void placeBlock(const sf::Vector2i& pos);
     void removeBlock(const sf::Vector2i& pos);
     void clearBlocks();
     bool hasBlockAt(const sf::Vector2i& pos) const;
-    int getBlockCount() const { return (int)blockPositions.size(); }
+    int getBlockCount() const { return (int)blockPositions->size(); }
+    const std::vector<sf::Vector2i>& getBlocks() const { return *blockPositions; }
+    const std::vector<Item>& getItems() const { return *items; }
+    const std::vector<int>& getBeamProgress() const { return beams->progress; }
+    const std::vector<int>& getBeamLengths() const { return beams->length; }   // lit cells out from each laser
+    const std::vector<Projectile>& getProjectiles() const { return projectiles; }
+
+    // put saved runtime state back onto the loaded level (save / resume). Returns false and
+    // changes nothing if it doesn't match the level (counts, cells out of bounds or solid).
+    bool restoreRuntime(const std::vector<char>& collected, const std::vector<int>& progress,
+                        const std::vector<sf::Vector2i>& blocks, const std::vector<Projectile>& balls,
+                        std::uint32_t step);
+
+    // bumped whenever isBlocked() answers may change (level load, block place/remove)
+    unsigned getRevision() const { return revision; }
 
     // Hazards / Beams / Projectiles
-    void computeBeams();               // build activeBeamCells from hazard beamProgress
-    void stepBeams();                  // advance beamProgress for lasers (animate appearance)
-    bool cellHasBeam(const sf::Vector2i& pos) const;
+    void computeBeams();               // rebuild every laser's span from the beam progress
+    bool cellHasBeam(const sf::Vector2i& pos) const
+    {
+        return level->inBounds(pos) && beams->count[cellIndex(pos)] > 0;
+    }
+
+    // one hazard step: cannonballs move, then the cannons / lasers due on this step (see
+    // HazardSchedule) fire / grow. Only the due ones are touched, through a timer wheel.
+    void stepHazards();
+    std::uint32_t getHazardStep() const { return hazardStep; }   // steps since the level started
 
-    // Cannon projectile system
-    void stepProjectiles();            // move existing projectiles and spawn new ones
     bool cellHasProjectile(const sf::Vector2i& pos) const;
     void clearProjectiles();
     void resetItemsToOriginal();        // reset collected state back to false
 
-private:
-    sf::Texture textureGrass;
-    sf::Texture textureChest;
-    sf::Texture textureTree;
-    sf::Texture textureWater;
-    sf::Texture textureBlock;
+    // Snapshots (O(1) to take and to restore, no beam recompute)
+    Snapshot snapshot() const;
+    void restore(const Snapshot& s);         // items, blocks and beams; clears projectiles
+    void restoreBlocks(const Snapshot& s);   // blocks only (beams recomputed against them)
+    // parts cloned by writes since this state was made (checks: at most one per part per snapshot)
+    unsigned cowCopies() const { return itemsPool.copies() + blocksPool.copies() + beamsPool.copies(); }
 
-    // hazard textures
-    sf::Texture textureCannonRight;
-    sf::Texture textureCannonLeft;
-    sf::Texture textureLaserUp;
-    sf::Texture textureLaserDown;
-    sf::Texture textureLaserBeam; // continuous beam tile (used per-cell)
-    sf::Texture textureCannonBall; // for projectile (cannonball)
+protected:
+    friend class TickHistory;   // replays recorded ticks onto a copy (rewind)
 
-    std::vector<Item> items;
-    std::vector<std::string> mapLayout; // (GridSize x GridSize), hazard origins replaced with '.'
-    std::vector<sf::Vector2i> blockPositions;
+    // copy-on-write: clone a shared part before the first write while a snapshot / copy still
+    // holds it (the parts below go through their pools instead)
+    template <class T>
+    static T& writable(std::shared_ptr<T>& p)
+    {
+        if (p.use_count() > 1) p = std::make_shared<T>(*p);
+        return *p;
+    }
 
-    // hazards and active beam cells (cells that are dangerous)
-    std::vector<Hazard> hazards;
-    std::vector<sf::Vector2i> activeBeamCells;
+    // each cannon can have at most one ball per cell in its row; reserving that up front keeps
+    // stepHazards() from reallocating mid-game
+    static size_t maxProjectiles(const LevelData& data);
+
+    // swap in a level with its start state
+    void adopt(std::shared_ptr<const LevelData> data, Snapshot start, std::vector<Projectile> balls);
+
+    // the one ray walk every hazard uses: free cells after `from` going `dir`, up to maxLen
+    int rayLength(sf::Vector2i from, sf::Vector2i dir, int maxLen) const;
+
+    int cellIndex(sf::Vector2i p) const { return p.y * level->width + (p.x - level->originX); }
+
+    // beam spans: one laser's span recounted against what's in its way now, or every laser that
+    // reaches `p` (a block / chest there changed)
+    void setBeamLength(BeamState& b, int hi, int len) const;
+    void refreshBeam(int hi);
+    void refreshBeamsThrough(sf::Vector2i p);
+
+    // hazard timers: one laser's step (true if its length changed), queueing a hazard's next
+    // wake-up, and waking the lasers that were idle because nothing was in their way changing
+    bool stepLaser(int hi, std::uint32_t step);
+    void scheduleHazard(int hi, std::uint32_t at);
+    void rebuildTimers();
+    void wakeLasers();
+
+    // immutable level (tiles, hazard origins, item positions)
+    std::shared_ptr<const LevelData> level = std::make_shared<const LevelData>();
+
+    // mutable state, shared copy-on-write with snapshots (and copies)
+    std::shared_ptr<std::vector<Item>> items = std::make_shared<std::vector<Item>>();
+    std::shared_ptr<std::vector<sf::Vector2i>> blockPositions = std::make_shared<std::vector<sf::Vector2i>>();
+    std::shared_ptr<BeamState> beams = std::make_shared<BeamState>();
+    CowPool<std::vector<Item>> itemsPool;
+    CowPool<std::vector<sf::Vector2i>> blocksPool;
+    CowPool<BeamState> beamsPool;
 
     // projectiles for cannons
     std::vector<Projectile> projectiles;
+
+    std::uint32_t hazardStep = 0;   // next step stepHazards() plays
+    HazardTimers timers;            // derived from the above, rebuilt when stale
+
+    unsigned revision = 0;
+};
+
+// Grid: the game's board, a GridState plus what it takes to draw it: tile textures (shared
+// through the ResourceCache) and per-chunk vertex batches that follow every level change.
+class Grid : public GridState {
+public:
+    // static tile batches for one chunk (only non-grass tiles, grass is one repeated quad)
+    struct ChunkBatch {
+        sf::VertexArray trees{sf::PrimitiveType::Triangles};
+        sf::VertexArray water{sf::PrimitiveType::Triangles};
+    };
+
+    // everything draw() reads, taken by the simulation thread for the render thread. The parts
+    // that rarely change are shared copy-on-write; beams and cannonballs change every hazard
+    // tick, so they are copied into the frame's own buffers (which stop growing once warm).
+    struct Frame {
+        std::shared_ptr<const LevelData> level;
+        std::shared_ptr<const std::vector<ChunkBatch>> batches;
+        std::shared_ptr<const std::vector<Item>> items;
+        std::shared_ptr<const std::vector<sf::Vector2i>> blocks;
+        std::vector<sf::Vector2i> beamCells;
+        std::vector<char> beamHorizontal;   // parallel to beamCells
+        std::vector<Projectile> projectiles;
+    };
+
+    // everything loadLevel() builds for a level, ready to be swapped in
+    struct PreparedLevel {
+        std::shared_ptr<const LevelData> level;
+        std::vector<ChunkBatch> batches;    // parallel to level->chunks
+        Snapshot start;                     // fresh items / blocks / beams
+        std::vector<Projectile> projectiles; // empty, capacity reserved
+    };
+
+    void load();
+    void loadLevel(const std::vector<std::string>& layout);
+    void loadLevel(std::shared_ptr<const LevelData> data);
+
+    // builds a PreparedLevel without touching the grid's own state (only reads texture sizes),
+    // so it can run on a worker while another level is being played; load() must be done first
+    std::shared_ptr<PreparedLevel> prepareLevel(std::shared_ptr<const LevelData> data) const;
+    void loadLevel(PreparedLevel&& prepared);
+
+    // hot reload: same-size boards only rebuild the chunk batches whose tiles changed
+    void reloadLevel(std::shared_ptr<const LevelData> next);
+
+    // endless mode: chunk batches of columns that stay resident are reused
+    void shiftLevel(std::shared_ptr<const LevelData> next);
+
+    void fillFrame(Frame& out) const { fillFrame(out, *this); }
+
+    // `state` drawn with this grid's textures and batches (it must be on the same level, e.g. a
+    // copy being replayed)
+    void fillFrame(Frame& out, const GridState& state) const;
+
+    // draws only the chunks / entities of `f` inside the window's current view. Only the
+    // textures (fixed after load()) are read from the grid itself, so this runs on the render
+    // thread while the simulation thread keeps changing the grid.
+    void draw(sf::RenderTarget& win, const Frame& f);
+
+private:
+    void buildChunkBatch(const LevelData& data, int cx, int cy, ChunkBatch& b) const;
+
+    std::shared_ptr<const sf::Texture> textureGrass;
+    std::shared_ptr<const sf::Texture> textureChest;
+    std::shared_ptr<const sf::Texture> textureTree;
+    std::shared_ptr<const sf::Texture> textureWater;
+    std::shared_ptr<const sf::Texture> textureBlock;
+
+    // hazard textures
+    std::array<std::shared_ptr<const sf::Texture>, (size_t)HazardType::Count> textureHazard;   // per HazardType
+    std::shared_ptr<const sf::Texture> textureLaserBeam;  // continuous beam tile (used per-cell)
+    std::shared_ptr<const sf::Texture> textureLaserBeamH; // same, for left / right lasers
+    std::shared_ptr<const sf::Texture> textureCannonBall; // for projectile (cannonball)
+
+    std::shared_ptr<std::vector<ChunkBatch>> batches = std::make_shared<std::vector<ChunkBatch>>();   // parallel to level->chunks, copy-on-write
+    sf::VertexArray grassQuad{sf::PrimitiveType::Triangles};   // render thread scratch (draw)
 };
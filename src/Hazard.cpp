@@ -1 +1,97 @@
-// Hazard.cpp
+#include "Hazard.h"
+#include <cstdlib>
+#include <sstream>
+
+// ---------------- Schedules ----------------
+
+std::uint32_t HazardSchedule::nextAct(std::uint32_t from) const
+{
+    if (from < offset) from = offset;
+    std::uint32_t local = from - offset;
+    if (!pulsing()) return from + (every - local % every) % every;
+
+    // acts on steps 0, every, 2*every ... of each on window
+    std::uint32_t cycle = (std::uint32_t)on + off;
+    std::uint32_t start = local - local % cycle;
+    std::uint32_t k = (local - start + every - 1) / every * every;
+    if (k < on) return offset + start + k;
+    return offset + start + cycle;   // a window opens with an act
+}
+
+std::uint32_t HazardSchedule::nextRest(std::uint32_t from) const
+{
+    if (!pulsing()) return Never;
+    if (from < offset) from = offset;
+    std::uint32_t local = from - offset;
+    std::uint32_t cycle = (std::uint32_t)on + off;
+    std::uint32_t edge = local - local % cycle + on;
+    if (local > edge) edge += cycle;
+    return offset + edge;
+}
+
+bool HazardSchedule::parse(const std::string& line, int& x, int& y, HazardSchedule& out)
+{
+    std::istringstream in(line);
+    char at = 0, comma = 0;
+    if (!(in >> at >> x >> comma >> y) || at != '@' || comma != ',') return false;
+
+    auto number = [](const char* s, char*& end, unsigned long& v) {
+        v = std::strtoul(s, &end, 10);
+        return end != s && v <= MaxSteps;
+    };
+
+    HazardSchedule s;
+    std::string field;
+    while (in >> field) {
+        std::size_t eq = field.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = field.substr(0, eq);
+        char* end = nullptr;
+        unsigned long v = 0;
+        if (!number(field.c_str() + eq + 1, end, v)) return false;
+
+        if (key == "every" && *end == 0 && v >= 1) s.every = (std::uint16_t)v;
+        else if (key == "offset" && *end == 0) s.offset = (std::uint16_t)v;
+        else if (key == "pulse" && *end == '/' && v >= 1) {
+            unsigned long offSteps = 0;
+            if (!number(end + 1, end, offSteps) || *end != 0) return false;
+            s.on = (std::uint16_t)v;
+            s.off = (std::uint16_t)offSteps;
+        }
+        else return false;
+    }
+    out = s;
+    return true;
+}
+
+// ---------------- Timer wheel ----------------
+
+void TimerWheel::reset(std::uint32_t now)
+{
+    for (auto& slot : slots) slot.clear();
+    current = now;
+}
+
+void TimerWheel::schedule(int id, std::uint32_t at)
+{
+    // the lowest level whose span (the digits above it) it shares with now
+    int level = 0;
+    while (level < Levels - 1 && (at >> (SlotBits * (level + 1))) != (current >> (SlotBits * (level + 1)))) ++level;
+    slots[level * Slots + ((at >> (SlotBits * level)) & (Slots - 1))].push_back({id, at});
+}
+
+void TimerWheel::collect(std::vector<int>& out)
+{
+    // entering a new span of a level: its timers move down to where they belong now
+    for (int level = Levels - 1; level >= 1; --level) {
+        if (current & ((1u << (SlotBits * level)) - 1)) continue;
+        cascade.swap(slots[level * Slots + ((current >> (SlotBits * level)) & (Slots - 1))]);
+        for (const Timer& t : cascade) schedule(t.id, t.at);
+        cascade.clear();
+    }
+
+    std::vector<Timer>& slot = slots[current & (Slots - 1)];
+    for (const Timer& t : slot) out.push_back(t.id);
+    slot.clear();
+    ++current;
+}
@@ -1 +1,75 @@
-// Hazard.h
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hazard timing. Hazards act on hazard steps (one every 220 ms, counted from the level start):
+// a cannon fires a ball, a laser grows one cell. By default every hazard acts on every step;
+// a level can give one a slower rate, a phase offset and an on / off pulse with a schedule
+// line after the rows:
+//
+//     @x,y every=N offset=N pulse=ON/OFF
+//
+// (x, y = the hazard's cell, every field optional). A pulsing hazard acts only during its ON
+// steps and then rests for OFF steps; a laser switches off (length 0) when a rest begins.
+struct HazardSchedule {
+    static constexpr std::uint32_t Never = 0xFFFFFFFFu;
+    static constexpr std::uint32_t MaxSteps = 4096;   // per field, keeps wake-ups within the timer wheel
+
+    std::uint16_t every = 1;    // acts on every n-th step of an on window
+    std::uint16_t offset = 0;   // first step it can act on
+    std::uint16_t on = 0;       // pulse lengths in steps (either one 0 => always on)
+    std::uint16_t off = 0;
+
+    bool pulsing() const { return on > 0 && off > 0; }
+
+    std::uint32_t nextAct(std::uint32_t from) const;    // first step >= from it acts on
+    std::uint32_t nextRest(std::uint32_t from) const;   // first step >= from a rest begins (Never if it doesn't pulse)
+    bool actsAt(std::uint32_t step) const { return nextAct(step) == step; }
+    bool restsAt(std::uint32_t step) const { return pulsing() && nextRest(step) == step; }
+
+    // one '@' line; false if it isn't well formed
+    static bool parse(const std::string& line, int& x, int& y, HazardSchedule& out);
+};
+
+// TimerWheel: hierarchical timing wheel over hazard steps. Timers sit in 64-slot levels by how
+// far off they are and move down a level when their span comes up, so collecting a step only
+// touches what is due (plus the occasional cascade), however many timers are waiting.
+class TimerWheel {
+public:
+    void reset(std::uint32_t now);                // drops every timer; `now` = next step collected
+    void schedule(int id, std::uint32_t at);      // at >= now()
+    void collect(std::vector<int>& out);          // appends the ids due at now(), then moves on a step
+    std::uint32_t now() const { return current; }
+
+private:
+    static constexpr int SlotBits = 6;
+    static constexpr int Slots = 1 << SlotBits;
+    static constexpr int Levels = 4;              // the last one also takes anything further off
+
+    struct Timer {
+        int id;
+        std::uint32_t at;
+    };
+
+    std::array<std::vector<Timer>, Levels * Slots> slots;
+    std::vector<Timer> cascade;                   // scratch
+    std::uint32_t current = 0;
+};
+
+// HazardTimers: a GridState's wake-up list, rebuilt from the level, the step count and the laser
+// lengths whenever it's stale. Copies come out stale (and empty), so copying a GridState stays
+// cheap and only a copy that steps its own hazards pays for the rebuild.
+struct HazardTimers {
+    HazardTimers() = default;
+    HazardTimers(const HazardTimers&) {}
+    HazardTimers& operator=(const HazardTimers&) { stale = true; return *this; }
+
+    bool stale = true;
+    TimerWheel wheel;
+    std::vector<std::uint32_t> dueAt;   // per hazard, Never = not scheduled
+    std::vector<char> asleep;           // per hazard: a laser with nothing to do until its way changes
+    std::vector<int> sleeping;          // those lasers (may hold ones that woke up since)
+    std::vector<int> due;               // scratch
+};
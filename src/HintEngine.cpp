@@ -0,0 +1,204 @@
+#include "HintEngine.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+
+namespace {
+    const int StepCost = 2;
+    const int DangerCostShielded = 6;   // hazard line, but a block is left to stop it
+    const int DangerCost = 16;          // hazard line and no blocks left
+    const int CancelCheckEvery = 256;   // node expansions between cancel / deadline checks
+}
+
+HintEngine::~HintEngine()
+{
+    // the search job uses this object; stop it and wait until it's gone
+    generation.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending = false;
+    }
+    JobSystem::instance().wait(*jobs);
+}
+
+void HintEngine::request(HintRequest req)
+{
+    unsigned gen = generation.fetch_add(1) + 1;   // cancels the running search
+    std::lock_guard<std::mutex> lock(mtx);
+    next = std::move(req);
+    pending = true;
+    resultGen = gen;          // anything older is stale now
+    resultFresh = false;
+
+    // one search job at a time: a running one picks this request up when it notices the cancel
+    if (!running) {
+        running = true;
+        JobSystem::instance().submit([this]{ runSearches(); }, jobs);
+    }
+}
+
+void HintEngine::cancel()
+{
+    generation.fetch_add(1);
+    std::lock_guard<std::mutex> lock(mtx);
+    pending = false;
+    resultFresh = false;
+}
+
+bool HintEngine::poll(std::vector<Direction>& moves, sf::Vector2i& start)
+{
+    std::unique_lock<std::mutex> lock(mtx, std::try_to_lock);
+    if (!lock || !resultFresh) return false;
+
+    moves.assign(resultMoves.begin(), resultMoves.end());
+    start = resultStart;
+    resultFresh = false;
+    return true;
+}
+
+void HintEngine::publish(unsigned gen, const std::vector<Direction>& moves, sf::Vector2i start)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (gen != resultGen || cancelled(gen)) return;
+    resultMoves.assign(moves.begin(), moves.end());
+    resultStart = start;
+    resultFresh = true;
+}
+
+void HintEngine::runSearches()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true)
+    {
+        if (!pending) { running = false; return; }
+
+        HintRequest req = std::move(next);
+        pending = false;
+        unsigned gen = resultGen;
+
+        lock.unlock();
+        search(req, gen);
+        lock.lock();
+    }
+}
+
+// ---------------- Search ----------------
+
+void HintEngine::search(const HintRequest& req, unsigned gen)
+{
+    TRACE_SCOPE("HintEngine::search");
+    const LevelData& L = *req.level;
+    if (L.width == 0 || L.height == 0 || req.maxMoves <= 0) return;
+
+    auto deadline = std::chrono::steady_clock::now()
+                  + std::chrono::microseconds((long long)(req.budgetSeconds * 1e6f));
+
+    const int W = L.width, H = L.height;
+    const size_t N = (size_t)W * H;
+    auto index = [&](sf::Vector2i p) { return p.y * W + (p.x - L.originX); };
+    auto cellAt = [&](int i) { return sf::Vector2i{L.originX + i % W, i / W}; };
+
+    std::vector<char> collected(req.items.size());
+    for (size_t i = 0; i < req.items.size(); ++i) collected[i] = req.items[i].collected;
+
+    auto hasBlock = [&](sf::Vector2i p) {
+        return std::find(req.blocks.begin(), req.blocks.end(), p) != req.blocks.end();
+    };
+    auto walkable = [&](sf::Vector2i p) {
+        char c = L.tile(p.x, p.y);
+        return c != 'T' && c != '~' && c != 'H' && !hasBlock(p);
+    };
+    auto stopsShot = [&](sf::Vector2i p) {
+        char c = L.tile(p.x, p.y);
+        if (c == 'T' || c == '~') return true;
+        if (c == 'I') { int i = L.itemIndex(p); return i >= 0 && !collected[i]; }
+        return hasBlock(p);
+    };
+
+    // every cell a laser or cannon can reach (beams grow over time, so use their full length)
+    danger.assign(N, 0);
+    for (auto& h : L.hazards) {
+        sf::Vector2i dir = h.info().dir;
+        for (sf::Vector2i p = h.pos + dir; L.inBounds(p) && !stopsShot(p); p += dir)
+            danger[index(p)] = 1;
+    }
+    const int dangerCost = req.blocksLeft > 0 ? DangerCostShielded : DangerCost;
+
+    dist.resize(N);
+    parent.resize(N);
+
+    std::vector<Direction> route;
+    route.reserve(req.maxMoves);
+    sf::Vector2i pos = req.start;
+    if (!L.inBounds(pos)) return;
+
+    using Node = std::pair<int, int>;   // (cost, cell)
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+    int expansions = 0;
+
+    // greedy tour: cheapest chest from here, then the next one from there, publishing after each leg
+    while ((int)route.size() < req.maxMoves)
+    {
+        std::fill(dist.begin(), dist.end(), -1);
+        open = {};
+        int from = index(pos);
+        dist[from] = 0;
+        parent[from] = -1;
+        open.push({0, from});
+
+        // cells further away than the plan has room for can't be part of the route
+        int room = req.maxMoves - (int)route.size();
+
+        int goal = -1;
+        while (!open.empty())
+        {
+            auto [d, i] = open.top();
+            open.pop();
+            if (d != dist[i]) continue;
+
+            if (++expansions % CancelCheckEvery == 0) {
+                if (cancelled(gen) || std::chrono::steady_clock::now() > deadline) return;
+            }
+
+            sf::Vector2i p = cellAt(i);
+            if (L.tile(p.x, p.y) == 'I') {
+                int item = L.itemIndex(p);
+                if (item >= 0 && !collected[item] && i != from) { goal = i; break; }
+            }
+
+            const sf::Vector2i steps[4] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+            for (auto s : steps) {
+                sf::Vector2i q = p + s;
+                if (!L.inBounds(q) || !walkable(q)) continue;
+                if (std::abs(q.x - pos.x) + std::abs(q.y - pos.y) > room) continue;
+                int j = index(q);
+                int nd = d + StepCost + (danger[j] ? dangerCost : 0);
+                if (dist[j] >= 0 && dist[j] <= nd) continue;
+                dist[j] = nd;
+                parent[j] = i;
+                open.push({nd, j});
+            }
+        }
+        if (goal < 0) break;   // nothing else reachable
+
+        // walk the parents back and append the leg (trimmed to the room left in the plan)
+        std::vector<Direction> leg;
+        for (int i = goal; parent[i] >= 0; i = parent[i]) {
+            sf::Vector2i a = cellAt(parent[i]), b = cellAt(i);
+            leg.push_back(b.y < a.y ? Direction::Up : b.y > a.y ? Direction::Down
+                        : b.x < a.x ? Direction::Left : Direction::Right);
+        }
+        std::reverse(leg.begin(), leg.end());
+        if ((int)leg.size() > room) leg.resize(room);
+        route.insert(route.end(), leg.begin(), leg.end());
+
+        collected[L.itemIndex(cellAt(goal))] = 1;
+        pos = cellAt(goal);
+        publish(gen, route, req.start);
+
+        if (cancelled(gen) || std::chrono::steady_clock::now() > deadline) return;
+    }
+}
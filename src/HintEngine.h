@@ -0,0 +1,63 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Grid.h"
+#include "JobSystem.h"
+#include "MovePlan.h"
+
+// Everything a hint search needs, copied out of the game so the worker never touches live state
+struct HintRequest {
+    std::shared_ptr<const LevelData> level;   // immutable, shared
+    std::vector<Item> items;                  // collected flags as of the request
+    std::vector<sf::Vector2i> blocks;         // blocks placed this turn
+    int blocksLeft = 0;
+    sf::Vector2i start;                       // where the current plan ends
+    int maxMoves = 0;                         // room left in the MovePlan
+    float budgetSeconds = 0.5f;               // wall-clock limit for the whole search
+};
+
+// HintEngine: time-bounded chest route search, run as a JobSystem job.
+// request() cancels whatever is running and starts over from the new state;
+// results are published after every chest leg so the best route so far is
+// always available, and poll() never blocks the render loop.
+class HintEngine {
+public:
+    HintEngine() = default;
+    ~HintEngine();
+    HintEngine(const HintEngine&) = delete;
+    HintEngine& operator=(const HintEngine&) = delete;
+
+    void request(HintRequest req);
+    void cancel();
+
+    // copies the newest route (moves starting at `start`) if it changed since the last poll.
+    // Returns false when there's nothing new or the worker is publishing right now.
+    bool poll(std::vector<Direction>& moves, sf::Vector2i& start);
+
+private:
+    void runSearches();   // job body: runs requests until none is pending
+    void search(const HintRequest& req, unsigned gen);
+    void publish(unsigned gen, const std::vector<Direction>& moves, sf::Vector2i start);
+    bool cancelled(unsigned gen) const { return generation.load(std::memory_order_relaxed) != gen; }
+
+    std::mutex mtx;
+    std::shared_ptr<TaskGroup> jobs = JobSystem::instance().makeGroup();
+    bool running = false;                  // a search job is queued or running
+    bool pending = false;
+    HintRequest next;                      // request waiting for the search job
+    std::atomic<unsigned> generation{0};   // bumped by request() / cancel(); a running search checks it
+
+    // latest published route (guarded by mtx)
+    std::vector<Direction> resultMoves;
+    sf::Vector2i resultStart;
+    unsigned resultGen = 0;
+    bool resultFresh = false;
+
+    // search scratch (only one search job runs at a time, reused between searches)
+    std::vector<int> dist;
+    std::vector<int> parent;
+    std::vector<char> danger;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// menu / screen buttons, clicked on the window thread and carried out by the simulation
+enum class UiCommand : std::uint8_t {
+    PlayCampaign, PlayEndless, PlayRace, OpenSettings, OpenLevelSelect, PlayLevel,
+    SetEasy, SetNormal, SetHard,
+    Resume, RestartLevel, MainMenu, NextLevel, RetryLevel,
+    CycleSpeed
+};
+
+// one forwarded input: a key press or a button command
+struct InputEvent {
+    enum class Kind : std::uint8_t { Key, Command };
+
+    Kind kind = Kind::Key;
+    sf::Keyboard::Key key = sf::Keyboard::Key::Unknown;
+    bool shift = false;
+    UiCommand command = UiCommand::MainMenu;
+    int level = 0;          // PlayLevel: campaign index
+};
+
+// SpscRing: single producer / single consumer ring between two threads; push and pop are a
+// couple of loads and one store each (wait-free, no allocation). A full ring drops the new item
+// rather than block the producer.
+template <class T, std::uint32_t N>
+class SpscRing {
+public:
+    static constexpr std::uint32_t Capacity = N;
+    static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+    // producer thread only
+    bool push(const T& e)
+    {
+        std::uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity) return false;
+        ring[h & (Capacity - 1)] = e;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only
+    bool pop(T& out)
+    {
+        std::uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = ring[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool empty() const { return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire); }
+
+private:
+    std::array<T, Capacity> ring{};
+    alignas(64) std::atomic<std::uint32_t> head{0};   // next slot to write
+    alignas(64) std::atomic<std::uint32_t> tail{0};   // next slot to read
+};
+
+// InputQueue: window thread -> simulation thread (a full queue drops the new input)
+using InputQueue = SpscRing<InputEvent, 256>;
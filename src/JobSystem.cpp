@@ -0,0 +1,184 @@
+#include "JobSystem.h"
+#include "AllocTracker.h"
+#include "Trace.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace {
+    thread_local const JobSystem* tlsSystem = nullptr;
+    thread_local int tlsWorker = -1;
+}
+
+// ---------------- TaskGroup ----------------
+
+void TaskGroup::then(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (pending.load(std::memory_order_acquire) > 0) {
+            continuation = std::move(job);
+            return;
+        }
+    }
+    JobSystem::instance().submit(std::move(job));
+}
+
+// ---------------- JobSystem ----------------
+
+JobSystem& JobSystem::instance()
+{
+    static JobSystem js(std::max(1, (int)std::thread::hardware_concurrency() - 1));
+    return js;
+}
+
+JobSystem::JobSystem(int count)
+{
+    for (int i = 0; i < count; ++i) queues.push_back(std::make_unique<Queue>());
+    for (int i = 0; i < count; ++i) workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        stopping = true;
+    }
+    sleepCv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void JobSystem::submit(std::function<void()> job, const std::shared_ptr<TaskGroup>& group, Priority prio)
+{
+    if (group) group->pending.fetch_add(1, std::memory_order_relaxed);
+
+    Queue* q = &highLane;
+    if (prio == Priority::Normal) {
+        // a worker keeps what it spawns (cache-warm, LIFO); other threads spread round-robin
+        int idx = (tlsSystem == this && tlsWorker >= 0)
+                ? tlsWorker
+                : (int)(nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size());
+        q = queues[idx].get();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(q->mtx);
+        q->tasks.push_back({std::move(job), group});
+    }
+    queued.fetch_add(1, std::memory_order_release);
+
+    // take the sleep lock so a worker between its check and its wait can't miss this
+    { std::lock_guard<std::mutex> lock(sleepMtx); }
+    sleepCv.notify_one();
+}
+
+void JobSystem::wait(TaskGroup& group)
+{
+    TRACE_SCOPE("JobSystem::wait");
+    Task t;
+    while (!group.isDone()) {
+        if (popForWait(group, t)) run(t);
+        else std::this_thread::yield();
+    }
+}
+
+bool JobSystem::popForWait(const TaskGroup& group, Task& out)
+{
+    {
+        std::lock_guard<std::mutex> lock(highLane.mtx);
+        if (!highLane.tasks.empty()) {
+            out = std::move(highLane.tasks.front());
+            highLane.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // the group's own jobs that no worker has started yet (oldest first)
+    for (auto& q : queues) {
+        std::lock_guard<std::mutex> lock(q->mtx);
+        auto it = std::find_if(q->tasks.begin(), q->tasks.end(), [&](const Task& t) { return t.group.get() == &group; });
+        if (it == q->tasks.end()) continue;
+        out = std::move(*it);
+        q->tasks.erase(it);
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::popTask(int self, Task& out)
+{
+    auto take = [&](Queue& q, bool back) {
+        std::lock_guard<std::mutex> lock(q.mtx);
+        if (q.tasks.empty()) return false;
+        if (back) { out = std::move(q.tasks.back()); q.tasks.pop_back(); }
+        else      { out = std::move(q.tasks.front()); q.tasks.pop_front(); }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    };
+
+    // latency-sensitive lane first, then our own deque (newest first), then steal (oldest first)
+    if (take(highLane, false)) return true;
+    if (self >= 0 && take(*queues[self], true)) return true;
+
+    int n = (int)queues.size();
+    int startAt = self >= 0 ? self + 1 : 0;
+    for (int k = 0; k < n; ++k) {
+        int victim = (startAt + k) % n;
+        if (victim == self) continue;
+        if (take(*queues[victim], false)) return true;
+    }
+    return false;
+}
+
+bool JobSystem::tryRunOne(int self)
+{
+    Task t;
+    if (!popTask(self, t)) return false;
+    run(t);
+    return true;
+}
+
+void JobSystem::run(Task& t)
+{
+    // jobs of a cancelled group are skipped but still count as finished
+    if (!t.group || !t.group->isCancelled()) {
+        try {
+            t.fn();
+        } catch (const std::exception& e) {
+            std::cerr << "[jobs] job threw: " << e.what() << "\n";
+        }
+    }
+    finish(t.group);
+}
+
+void JobSystem::finish(const std::shared_ptr<TaskGroup>& group)
+{
+    if (!group) return;
+    if (group->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    std::function<void()> cont;
+    {
+        std::lock_guard<std::mutex> lock(group->mtx);
+        cont = std::move(group->continuation);
+        group->continuation = nullptr;
+    }
+    if (cont) submit(std::move(cont));
+}
+
+void JobSystem::workerLoop(int index)
+{
+    tlsSystem = this;
+    tlsWorker = index;
+    AllocTracker::enter(AllocTracker::Background);
+
+    while (true)
+    {
+        if (tryRunOne(index)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        sleepCv.wait(lock, [this]{ return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) return;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A set of jobs that can be waited on, cancelled and followed by a continuation.
+// Jobs keep their group alive (shared_ptr), so a group may be dropped early.
+class TaskGroup {
+public:
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    // run `job` (as a normal job) once every job in the group has finished or been
+    // skipped; runs right away if the group is already idle. One continuation per group.
+    void then(std::function<void()> job);
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> pending{0};
+    std::atomic<bool> cancelled{false};
+    std::mutex mtx;
+    std::function<void()> continuation;
+};
+
+// JobSystem: fixed pool of workers (hardware threads - 1, at least one), one deque each.
+// A worker pops its own deque from the back and steals from the front of the others.
+// High-priority jobs go to a shared lane that every worker drains first, so something the
+// render thread blocks on isn't stuck behind background work. A thread in wait() only helps
+// with the high lane and with the group it waits for: it never picks up an unrelated long job
+// (a hint search, a race batch) and blocks for its whole length.
+class JobSystem {
+public:
+    enum class Priority { Normal, High };
+
+    static JobSystem& instance();
+
+    explicit JobSystem(int workers);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    std::shared_ptr<TaskGroup> makeGroup() { return std::make_shared<TaskGroup>(); }
+
+    // queue a job; it is skipped (not run) if its group was cancelled before it started
+    void submit(std::function<void()> job, const std::shared_ptr<TaskGroup>& group = nullptr,
+                Priority prio = Priority::Normal);
+
+    // block until the group is idle, running its queued jobs (and high-priority ones) on this
+    // thread meanwhile
+    void wait(TaskGroup& group);
+
+    int workerCount() const { return (int)workers.size(); }
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        std::shared_ptr<TaskGroup> group;
+    };
+
+    struct Queue {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int index);
+    bool tryRunOne(int self);   // self = worker index, -1 for non-worker threads
+    bool popTask(int self, Task& out);
+    bool popForWait(const TaskGroup& group, Task& out);   // high lane, else a job of `group`
+    void run(Task& t);
+    void finish(const std::shared_ptr<TaskGroup>& group);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;   // one per worker
+    Queue highLane;
+
+    std::mutex sleepMtx;
+    std::condition_variable sleepCv;
+    std::atomic<int> queued{0};       // tasks sitting in any queue
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+};
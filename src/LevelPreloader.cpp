@@ -0,0 +1,64 @@
+#include "LevelPreloader.h"
+#include "Trace.h"
+#include <algorithm>
+#include <iostream>
+
+LevelPreloader::~LevelPreloader()
+{
+    // jobs read the grid's textures, so they have to be gone before it is
+    cancel();
+    for (auto& g : abandoned) JobSystem::instance().wait(*g);
+}
+
+void LevelPreloader::cancel()
+{
+    if (jobs) {
+        jobs->cancel();   // skipped if it hasn't started
+        if (!jobs->isDone()) abandoned.push_back(std::move(jobs));
+        jobs.reset();
+    }
+    slot.reset();
+    index = -1;
+
+    // forget the abandoned ones that have finished meanwhile
+    abandoned.erase(std::remove_if(abandoned.begin(), abandoned.end(),
+                                   [](const std::shared_ptr<TaskGroup>& g) { return g->isDone(); }),
+                    abandoned.end());
+}
+
+void LevelPreloader::start(const Grid& grid, int idx, std::shared_ptr<const LevelData> parsed,
+                           std::vector<std::string> layout)
+{
+    if (jobs && index == idx) return;   // already on it
+    cancel();
+
+    index = idx;
+    jobs = JobSystem::instance().makeGroup();
+    slot = std::make_shared<Slot>();
+    const Grid* g = &grid;
+    JobSystem::instance().submit([out = slot, g, idx, parsed = std::move(parsed), layout = std::move(layout)]() mutable {
+        TRACE_SCOPE("LevelPreloader::job");
+        if (!parsed) parsed = Grid::parseLevel(layout);
+        if (const char* problem = Grid::checkLevel(*parsed))
+            std::cerr << "[levels] level " << (idx + 1) << ": " << problem << "\n";
+
+        auto prepared = g->prepareLevel(std::move(parsed));
+        std::lock_guard<std::mutex> lock(out->mtx);
+        out->result = std::move(prepared);
+    }, jobs);
+}
+
+std::shared_ptr<Grid::PreparedLevel> LevelPreloader::take(int idx)
+{
+    if (!jobs || index != idx) return nullptr;
+
+    // normally long done by the time the player presses Next; if not, the caller builds the
+    // level itself rather than this tick waiting on the worker
+    std::shared_ptr<Grid::PreparedLevel> out;
+    if (jobs->isDone()) {
+        std::lock_guard<std::mutex> lock(slot->mtx);
+        out = std::move(slot->result);
+    }
+    cancel();
+    return out;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Grid.h"
+#include "JobSystem.h"
+
+// LevelPreloader: gets the next campaign level ready on a JobSystem worker while the current
+// one is played (parse if needed, checkLevel, tile batches, fresh item / beam state), so the
+// switch is just Grid::loadLevel(PreparedLevel&&). One level is kept in flight at a time.
+// Nothing here blocks the caller: a preload that isn't finished when it's needed (or that is
+// dropped) is abandoned to finish on its own, and its result goes nowhere.
+class LevelPreloader {
+public:
+    LevelPreloader() = default;
+    ~LevelPreloader();
+    LevelPreloader(const LevelPreloader&) = delete;
+    LevelPreloader& operator=(const LevelPreloader&) = delete;
+
+    // start preparing level `index` (drops any other preload). `parsed` may be null, then the
+    // layout is parsed on the worker. `grid` must outlive the preloader (its job reads the
+    // grid's textures).
+    void start(const Grid& grid, int index, std::shared_ptr<const LevelData> parsed,
+               std::vector<std::string> layout);
+
+    // the prepared level if `index` is the one being preloaded and it's done, otherwise nullptr
+    // (the caller builds the level itself). The preload is consumed either way.
+    std::shared_ptr<Grid::PreparedLevel> take(int index);
+
+    // drop whatever is in flight (without waiting for it)
+    void cancel();
+
+private:
+    // where a job puts its level; owned jointly with the job, so an abandoned job can't write
+    // into a preload that has moved on
+    struct Slot {
+        std::mutex mtx;
+        std::shared_ptr<Grid::PreparedLevel> result;
+    };
+
+    std::shared_ptr<TaskGroup> jobs;
+    std::shared_ptr<Slot> slot;
+    int index = -1;
+    std::vector<std::shared_ptr<TaskGroup>> abandoned;   // still running; waited for on destruction
+};
@@ -0,0 +1,206 @@
+#include "LevelWatcher.h"
+#include "Levels.h"
+#include <algorithm>
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+// one ReadDirectoryChangesW kept in flight; poll() picks up its result without waiting
+struct LevelWatcher::WinWatch {
+    HANDLE dir = INVALID_HANDLE_VALUE;
+    OVERLAPPED ov{};
+    bool pending = false;
+    alignas(DWORD) char buf[8192];
+
+    bool arm()
+    {
+        ResetEvent(ov.hEvent);
+        pending = ReadDirectoryChangesW(dir, buf, sizeof(buf), FALSE,
+                                        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                        nullptr, &ov, nullptr) != 0;
+        return pending;
+    }
+
+    ~WinWatch()
+    {
+        if (pending) {
+            // the kernel writes into buf until the cancel completes
+            DWORD n = 0;
+            CancelIo(dir);
+            GetOverlappedResult(dir, &ov, &n, TRUE);
+        }
+        if (dir != INVALID_HANDLE_VALUE) CloseHandle(dir);
+        if (ov.hEvent) CloseHandle(ov.hEvent);
+    }
+};
+#else
+struct LevelWatcher::WinWatch {};
+#endif
+
+LevelWatcher::LevelWatcher() = default;
+
+LevelWatcher::~LevelWatcher()
+{
+#ifdef __linux__
+    if (fd >= 0) ::close(fd);
+#endif
+}
+
+bool LevelWatcher::start(const std::string& d, int levelCount)
+{
+    dir = d;
+    std::error_code ec;
+    watching = std::filesystem::is_directory(dir, ec);
+    if (!watching) return false;
+
+    files.clear();
+    files.reserve(levelCount + 8);
+    for (int i = 0; i <= levelCount; ++i) watchLevel(i);
+
+#ifdef __linux__
+    // written in place (close after write) or saved via rename (most editors)
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0 && inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (fd < 0) std::cerr << "[levels] inotify unavailable, polling " << dir << " instead\n";
+    if (fd >= 0) return true;
+#endif
+
+#ifdef _WIN32
+    // file names cover saves via rename, last write covers saves in place
+    auto w = std::make_unique<WinWatch>();
+    w->dir = CreateFileA(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    w->ov.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (w->dir != INVALID_HANDLE_VALUE && w->ov.hEvent && w->arm()) {
+        win = std::move(w);
+        return true;
+    }
+    std::cerr << "[levels] ReadDirectoryChangesW unavailable, polling " << dir << " instead\n";
+#endif
+
+    scan(nullptr);   // remember the current stamps
+    return true;
+}
+
+void LevelWatcher::watchLevel(int index)
+{
+    Watched w;
+    w.name = levelFileName(index);
+    w.path = std::filesystem::path(dir) / w.name;
+    files.push_back(std::move(w));
+}
+
+void LevelWatcher::poll(std::vector<std::string>& changed)
+{
+    if (!watching) return;
+
+#ifdef __linux__
+    if (fd >= 0) {
+        alignas(inotify_event) char buf[4096];
+        while (true) {
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n <= 0) {
+                if (n < 0 && errno != EAGAIN && errno != EINTR)
+                    std::cerr << "[levels] inotify read failed\n";
+                break;
+            }
+            for (ssize_t off = 0; off < n; ) {
+                auto* ev = reinterpret_cast<inotify_event*>(buf + off);
+                if (ev->len > 0 && !(ev->mask & IN_ISDIR)) {
+                    std::string name(ev->name);
+                    if (std::find(changed.begin(), changed.end(), name) == changed.end())
+                        changed.push_back(std::move(name));
+                }
+                off += sizeof(inotify_event) + ev->len;
+            }
+        }
+        return;
+    }
+#endif
+
+#ifdef _WIN32
+    if (win) {
+        DWORD n = 0;
+        if (!GetOverlappedResult(win->dir, &win->ov, &n, FALSE)) {
+            if (GetLastError() == ERROR_IO_INCOMPLETE) return;   // nothing yet
+            n = 0;
+        }
+        win->pending = false;
+
+        if (n == 0) {
+            // the buffer overflowed (or the read failed): report every level file, unchanged ones
+            // are skipped by the reload
+            for (const Watched& f : files)
+                if (std::find(changed.begin(), changed.end(), f.name) == changed.end()) changed.push_back(f.name);
+        }
+        for (DWORD off = 0; n > 0; ) {
+            auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(win->buf + off);
+            bool written = info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                           info->Action == FILE_ACTION_RENAMED_NEW_NAME;
+
+            // level file names are short and ASCII; anything else isn't one
+            char name[32];
+            size_t len = info->FileNameLength / sizeof(WCHAR);
+            bool ascii = len < sizeof(name);
+            for (size_t i = 0; ascii && i < len; ++i) {
+                ascii = info->FileName[i] < 0x80;
+                name[i] = (char)info->FileName[i];
+            }
+            if (written && ascii) {
+                name[len] = 0;
+                if (std::find(changed.begin(), changed.end(), name) == changed.end()) changed.emplace_back(name, len);
+            }
+            if (info->NextEntryOffset == 0) break;
+            off += info->NextEntryOffset;
+        }
+
+        if (!win->arm()) {
+            std::cerr << "[levels] ReadDirectoryChangesW failed, polling " << dir << " instead\n";
+            win.reset();
+            scan(nullptr);
+        }
+        return;
+    }
+#endif
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < nextScan) return;
+    nextScan = now + PollInterval;
+    scan(&changed);
+}
+
+void LevelWatcher::scan(std::vector<std::string>* changed)
+{
+    std::error_code ec;
+    for (size_t i = 0; i < files.size(); ++i) {
+        Watched& f = files[i];
+        auto stamp = std::filesystem::last_write_time(f.path, ec);
+        bool exists = !ec;
+        if (exists == f.exists && (!exists || stamp == f.stamp)) continue;
+
+        f.exists = exists;
+        f.stamp = stamp;
+        if (!exists) continue;   // deleted: nothing to reload
+        if (changed) changed->push_back(f.name);
+
+        // the next number in line can add a level now
+        if (i + 1 == files.size()) watchLevel((int)files.size());
+    }
+}
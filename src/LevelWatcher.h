@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// LevelWatcher: reports files in a directory that were written since the last poll().
+// Linux uses inotify and Windows an overlapped ReadDirectoryChangesW (a non-blocking check per
+// poll, so a save shows up on the next frame). Elsewhere, or if neither can be set up, the level
+// files (level1.txt ... and the next number in line) are stat'ed every PollInterval instead; their
+// paths are built up front, so a scan doesn't allocate.
+class LevelWatcher {
+public:
+    static constexpr std::chrono::milliseconds PollInterval{250};
+
+    LevelWatcher();
+    ~LevelWatcher();
+    LevelWatcher(const LevelWatcher&) = delete;
+    LevelWatcher& operator=(const LevelWatcher&) = delete;
+
+    // false if the directory doesn't exist (nothing will be reported). levelCount is how many
+    // levels the game has; the polling fallback watches their files plus the next one in line.
+    bool start(const std::string& dir, int levelCount);
+
+    // appends the file names (not paths) changed since the last call; never blocks
+    void poll(std::vector<std::string>& changed);
+
+    const std::string& directory() const { return dir; }
+
+private:
+    struct Watched {
+        std::string name;
+        std::filesystem::path path;
+        std::filesystem::file_time_type stamp{};
+        bool exists = false;
+    };
+    struct WinWatch;                   // pending ReadDirectoryChangesW (Windows)
+
+    void watchLevel(int index);
+    void scan(std::vector<std::string>* changed);   // fallback: compare modification times
+
+    std::string dir;
+    bool watching = false;
+    int fd = -1;                       // inotify instance (Linux)
+    std::unique_ptr<WinWatch> win;
+
+    std::vector<Watched> files;        // level1.txt ... the next level in line
+    std::chrono::steady_clock::time_point nextScan;
+};
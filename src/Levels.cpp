@@ -0,0 +1,203 @@
+#include "Levels.h"
+#include <fstream>
+
+namespace {
+
+// --- Level literals (20x20) ---
+const std::vector<std::string> L1 = {
+"....................",
+"....................",
+"....................",
+".........Lv.........",
+"....................",
+"....................",
+"....................",
+"....................",
+"....................",
+"....................",
+".........I..........",
+"....................",
+"....P...............",
+"....................",
+"....................",
+"....................",
+"....................",
+"....................",
+"..........I.........",
+"...................."
+};
+
+const std::vector<std::string> L2 = {
+"....................",
+"....................",
+"....C>..I..C<.......",
+"....................",
+"....................",
+"....................",
+"....................",
+".....I..............",
+"....................",
+"....................",
+"....................",
+"....................",
+"....P...............",
+"....................",
+".........Lv.........",
+"....................",
+"....................",
+"....................",
+"..........I.........",
+"...................."
+};
+
+const std::vector<std::string> L3 = {
+"..............T.....",
+"....................",
+"....C>......I.......",
+"....................",
+"..I....I....C<......",
+"....................",
+"....................",
+".........Lv.........",
+"....................",
+"....TTT.............",
+"....T~T.............",
+"P...T~T......I......",
+"....T~T.............",
+"....TTT.............",
+"....................",
+"...........Lv.......",
+"....................",
+"......C>............",
+".................TT.",
+"....T.......I......."
+};
+
+const std::vector<std::string> L4 = {
+".................Lv.",
+"...C>.......C<......",
+"...TTT......TTT.....",
+"...T~T......T~T..I..",
+"...T~T......T~T.....",
+"...TTT......TTT.....",
+"....................",
+"......I.............",
+"....C>......C<......",
+"....................",
+"....................",
+"..Lv................",
+"......I.......I.....",
+"....................",
+"....................",
+"........I...........",
+"....................",
+"....................",
+"P...................",
+"...................."
+};
+
+const std::vector<std::string> L5 = {
+"....................",
+"....................",
+"C>....I.......I...C<",
+"....................",
+"....TTT.............",
+"....T~T.............",
+"....T~T.....I.......",
+"....TTT.............",
+"....................",
+"....................",
+"..LvC>.....Lv.T.....",
+"....................",
+"....I.........I.....",
+"....................",
+"....................",
+"....................",
+".........I..........",
+".................TTT",
+"P................T~T",
+".................TTT"
+};
+
+const std::vector<std::string> L6 = {
+".........C>.........",
+"....................",
+"...I.........I......",
+"....................",
+"C>.......I....Lv....",
+"....................",
+"....................",
+".....TTT.........TT.",
+".....T~T.....I......",
+".....T~T............",
+".....TTT............",
+"....................",
+"..................C<",
+"....................",
+"....................",
+"............TTTTT...",
+"....I.......T~~~T...",
+"............TTTTT...",
+"P...................",
+"...............TT..."
+};
+
+}
+
+const std::vector<std::vector<std::string>>& builtinLevels()
+{
+    static const std::vector<std::vector<std::string>> levels = {L1, L2, L3, L4, L5, L6};
+    return levels;
+}
+
+std::string levelFileName(int index)
+{
+    return "level" + std::to_string(index + 1) + ".txt";
+}
+
+int levelIndexFromFileName(const std::string& name)
+{
+    const std::string prefix = "level", suffix = ".txt";
+    if (name.size() <= prefix.size() + suffix.size()) return -1;
+    if (name.compare(0, prefix.size(), prefix) != 0) return -1;
+    if (name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) return -1;
+
+    int n = 0;
+    for (size_t i = prefix.size(); i < name.size() - suffix.size(); ++i) {
+        if (name[i] < '0' || name[i] > '9') return -1;
+        n = n * 10 + (name[i] - '0');
+        if (n > 9999) return -1;
+    }
+    return n - 1;
+}
+
+bool readLevelFile(const std::string& path, std::vector<std::string>& layout)
+{
+    std::ifstream in(path);
+    if (!in) return false;
+
+    layout.clear();
+    std::string row;
+    while (std::getline(in, row)) {
+        if (!row.empty() && row.back() == '\r') row.pop_back();   // CRLF files
+        layout.push_back(row);
+    }
+    // trailing blank lines aren't rows
+    while (!layout.empty() && layout.back().empty()) layout.pop_back();
+    return !layout.empty();
+}
+
+std::vector<std::vector<std::string>> loadCampaignLevels()
+{
+    std::vector<std::vector<std::string>> levels = builtinLevels();
+    std::vector<std::string> layout;
+    for (int i = 0; ; ++i) {
+        if (readLevelFile(std::string(LevelDir) + "/" + levelFileName(i), layout)) {
+            if (i < (int)levels.size()) levels[i] = layout;
+            else levels.push_back(layout);
+        } else if (i >= (int)levels.size()) {
+            break;
+        }
+    }
+    return levels;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// the campaign levels, in play order (20x20 layouts, see the map symbols in the README)
+const std::vector<std::vector<std::string>>& builtinLevels();
+
+// Level files: levels/level1.txt, level2.txt, ... one row per line. A file overrides the
+// built-in level with the same number; numbers past the built-in ones add levels.
+const char* const LevelDir = "levels";
+std::string levelFileName(int index);                  // 0-based index -> "level<index+1>.txt"
+int levelIndexFromFileName(const std::string& name);   // -1 if it isn't a level file
+
+// false if the file is missing or has no rows
+bool readLevelFile(const std::string& path, std::vector<std::string>& layout);
+
+// built-in levels overridden / extended by whatever is in LevelDir
+std::vector<std::vector<std::string>> loadCampaignLevels();
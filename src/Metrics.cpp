@@ -0,0 +1,199 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    const double MinMs = 0.01;
+    const double Growth = 1.08;
+    const double LogGrowth = std::log(Growth);
+
+    enum Budget : unsigned {
+        FrameP95 = 1u << 0,
+        FrameP99 = 1u << 1,
+        FrameMax = 1u << 2,
+        TickP95  = 1u << 3,
+        TickP99  = 1u << 4,
+    };
+
+    const struct { Budget bit; const char* name; } BudgetNames[] = {
+        { FrameP95, "frame_p95" }, { FrameP99, "frame_p99" }, { FrameMax, "frame_max" },
+        { TickP95, "tick_p95" },   { TickP99, "tick_p99" },
+    };
+
+    float upperEdge(int bucket) { return (float)(MinMs * std::pow(Growth, bucket + 1)); }
+}
+
+// ---------------- LatencyHistogram ----------------
+
+void LatencyHistogram::record(float ms)
+{
+    int b = 0;
+    if (ms > MinMs) b = (int)(std::log(ms / MinMs) / LogGrowth);
+    if (b >= Buckets) b = Buckets - 1;
+    ++counts[b];
+    ++total;
+    sum += ms;
+    if (ms > maxSeen) maxSeen = ms;
+}
+
+float LatencyHistogram::quantile(double q) const
+{
+    if (total == 0) return 0.f;
+    std::uint64_t rank = (std::uint64_t)std::ceil(q * (double)total);
+    if (rank < 1) rank = 1;
+
+    std::uint64_t seen = 0;
+    for (int b = 0; b < Buckets; ++b) {
+        seen += counts[b];
+        if (seen >= rank) return std::min(upperEdge(b), maxSeen);
+    }
+    return maxSeen;
+}
+
+// ---------------- Budgets ----------------
+
+bool MetricBudgets::loadFile(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in) return true;   // optional
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        auto eq = line.find('=');
+        if (eq == std::string::npos) {
+            if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                std::cerr << "[metrics] " << path << ":" << lineNo << ": expected key = value\n";
+                return false;
+            }
+            continue;
+        }
+
+        std::string key;
+        std::istringstream(line.substr(0, eq)) >> key;
+        float v = 0.f;
+        if (!(std::istringstream(line.substr(eq + 1)) >> v)) {
+            std::cerr << "[metrics] " << path << ":" << lineNo << ": bad value for " << key << "\n";
+            return false;
+        }
+
+        if (key == "frame_p95_ms") frameP95Ms = v;
+        else if (key == "frame_p99_ms") frameP99Ms = v;
+        else if (key == "frame_max_ms") frameMaxMs = v;
+        else if (key == "tick_p95_ms") tickP95Ms = v;
+        else if (key == "tick_p99_ms") tickP99Ms = v;
+        else if (key == "min_samples") minSamples = (int)v;
+        else std::cerr << "[metrics] " << path << ":" << lineNo << ": unknown budget " << key << "\n";
+    }
+    return true;
+}
+
+// ---------------- SessionMetrics ----------------
+
+int SessionMetrics::addSeries(const char* label, const char* value)
+{
+    series.push_back({label, value, {}, {}});
+    return (int)series.size() - 1;
+}
+
+int SessionMetrics::addInputSeries(const char* value)
+{
+    inputs.push_back({value, {}});
+    return (int)inputs.size() - 1;
+}
+
+unsigned SessionMetrics::breaches(const Series& s) const
+{
+    if (s.frame.count() < (std::uint64_t)budgets.minSamples) return 0;
+
+    unsigned b = 0;
+    if (s.frame.quantile(0.95) > budgets.frameP95Ms) b |= FrameP95;
+    if (s.frame.quantile(0.99) > budgets.frameP99Ms) b |= FrameP99;
+    if (s.frame.maxMs() > budgets.frameMaxMs)        b |= FrameMax;
+    if (s.tick.quantile(0.95) > budgets.tickP95Ms)   b |= TickP95;
+    if (s.tick.quantile(0.99) > budgets.tickP99Ms)   b |= TickP99;
+    return b;
+}
+
+bool SessionMetrics::overBudget() const
+{
+    for (const Series& s : series)
+        if (breaches(s)) return true;
+    return false;
+}
+
+bool SessionMetrics::writeOpenMetrics(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    // OpenMetrics wants base units, so seconds
+    auto summary = [&](const char* name, const char* help, bool frame) {
+        out << "# TYPE " << name << " summary\n";
+        out << "# UNIT " << name << " seconds\n";
+        out << "# HELP " << name << " " << help << "\n";
+        for (const Series& s : series) {
+            const LatencyHistogram& h = frame ? s.frame : s.tick;
+            if (h.count() == 0) continue;
+            std::string labels = std::string(s.label) + "=\"" + s.value + "\"";
+            for (double q : {0.5, 0.95, 0.99})
+                out << name << "{" << labels << ",quantile=\"" << q << "\"} " << h.quantile(q) / 1000.0 << "\n";
+            out << name << "_sum{" << labels << "} " << h.sumMs() / 1000.0 << "\n";
+            out << name << "_count{" << labels << "} " << h.count() << "\n";
+        }
+    };
+    auto gaugeMax = [&](const char* name, const char* help, bool frame) {
+        out << "# TYPE " << name << " gauge\n";
+        out << "# UNIT " << name << " seconds\n";
+        out << "# HELP " << name << " " << help << "\n";
+        for (const Series& s : series) {
+            const LatencyHistogram& h = frame ? s.frame : s.tick;
+            if (h.count() == 0) continue;
+            out << name << "{" << s.label << "=\"" << s.value << "\"} " << h.maxMs() / 1000.0 << "\n";
+        }
+    };
+
+    summary("game_frame_seconds", "Whole frame time.", true);
+    gaugeMax("game_frame_max_seconds", "Longest frame.", true);
+    summary("game_tick_seconds", "Game::update time per simulation tick.", false);
+    gaugeMax("game_tick_max_seconds", "Longest Game::update.", false);
+
+    out << "# TYPE game_input_latency_seconds summary\n";
+    out << "# UNIT game_input_latency_seconds seconds\n";
+    out << "# HELP game_input_latency_seconds Input seen by the window until the first frame showing it is presented.\n";
+    for (const InputSeries& s : inputs) {
+        const LatencyHistogram& h = s.latency;
+        if (h.count() == 0) continue;
+        for (double q : {0.5, 0.95, 0.99})
+            out << "game_input_latency_seconds{input=\"" << s.value << "\",quantile=\"" << q << "\"} " << h.quantile(q) / 1000.0 << "\n";
+        out << "game_input_latency_seconds_sum{input=\"" << s.value << "\"} " << h.sumMs() / 1000.0 << "\n";
+        out << "game_input_latency_seconds_count{input=\"" << s.value << "\"} " << h.count() << "\n";
+    }
+    out << "# TYPE game_input_latency_max_seconds gauge\n";
+    out << "# UNIT game_input_latency_max_seconds seconds\n";
+    out << "# HELP game_input_latency_max_seconds Slowest input.\n";
+    for (const InputSeries& s : inputs)
+        if (s.latency.count())
+            out << "game_input_latency_max_seconds{input=\"" << s.value << "\"} " << s.latency.maxMs() / 1000.0 << "\n";
+
+    out << "# TYPE game_budget_exceeded gauge\n";
+    out << "# HELP game_budget_exceeded 1 if the series broke the budget (series with too few frames are 0).\n";
+    for (const Series& s : series) {
+        if (s.frame.count() == 0) continue;
+        unsigned b = breaches(s);
+        for (const auto& bn : BudgetNames)
+            out << "game_budget_exceeded{" << s.label << "=\"" << s.value << "\",budget=\"" << bn.name << "\"} "
+                << ((b & bn.bit) ? 1 : 0) << "\n";
+    }
+
+    out << "# TYPE game_session_over_budget gauge\n";
+    out << "game_session_over_budget " << (overBudget() ? 1 : 0) << "\n";
+    out << "# EOF\n";
+    return (bool)out;
+}
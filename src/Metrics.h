@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fixed log-scale latency histogram: ~8% wide buckets from 0.01 ms to ~1 s, so recording is
+// one log() and an increment, and quantiles are accurate to a bucket (reported as its upper edge,
+// clamped to the largest value seen).
+class LatencyHistogram {
+public:
+    static constexpr int Buckets = 150;
+
+    void record(float ms);
+    float quantile(double q) const;    // q in [0, 1]
+    std::uint64_t count() const { return total; }
+    double sumMs() const { return sum; }
+    float maxMs() const { return maxSeen; }
+
+private:
+    std::array<std::uint32_t, Buckets> counts{};
+    std::uint64_t total = 0;
+    double sum = 0.0;
+    float maxSeen = 0.f;
+};
+
+// frame-time budgets; a series that breaks one gets flagged in the export
+struct MetricBudgets {
+    float frameP95Ms = 16.7f;
+    float frameP99Ms = 33.3f;
+    float frameMaxMs = 250.f;
+    float tickP95Ms = 4.f;
+    float tickP99Ms = 8.f;
+    int minSamples = 120;           // series with fewer frames aren't judged
+
+    // `key = value` lines (frame_p95_ms, frame_p99_ms, frame_max_ms, tick_p95_ms, tick_p99_ms,
+    // min_samples); missing file => defaults. Returns false on a parse error.
+    bool loadFile(const std::string& path);
+};
+
+// SessionMetrics: frame and simulation tick (Game::update) time histograms per labelled series
+// (one per UIState, one per GamePhase), plus input-to-display latency per kind of input,
+// exported in the OpenMetrics text format.
+class SessionMetrics {
+public:
+    // register a series up front (label="value" on every exported sample); returns its index
+    int addSeries(const char* label, const char* value);
+
+    // one presented frame (window thread) / one simulation tick; ticks are recorded one by one
+    // as the simulation passes them over, not summed per frame
+    void recordFrame(int s, float frameMs) { series[s].frame.record(frameMs); }
+    void recordTick(int s, float tickMs) { series[s].tick.record(tickMs); }
+
+    // input latency: key press / click seen by the window -> first frame showing its effect
+    // presented. Series are registered up front like the frame ones (label input="<value>").
+    int addInputSeries(const char* value);
+    void recordInput(int series, float ms) { inputs[series].latency.record(ms); }
+
+    MetricBudgets budgets;
+
+    // true if any series with enough samples is over budget
+    bool overBudget() const;
+
+    // full snapshot, returns false on I/O error
+    bool writeOpenMetrics(const std::string& path) const;
+
+private:
+    struct Series {
+        const char* label;
+        const char* value;
+        LatencyHistogram frame;
+        LatencyHistogram tick;
+    };
+
+    // which budgets a series breaks (bit per budget, see Metrics.cpp)
+    unsigned breaches(const Series& s) const;
+
+    struct InputSeries {
+        const char* value;
+        LatencyHistogram latency;
+    };
+
+    std::vector<Series> series;
+    std::vector<InputSeries> inputs;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+enum class Direction : std::uint8_t { Up, Down, Left, Right };
+
+// MovePlan: fixed-capacity ring of planned moves, packed 2 bits per move.
+// Append, undo (popBack), execute (popFront) and indexed access are all O(1),
+// and the whole plan is 72 bytes of plain data, so copying it is a cheap snapshot.
+class MovePlan {
+public:
+    static constexpr int Capacity = 256;   // must be a power of two (and a multiple of 32)
+
+    bool push(Direction d)
+    {
+        if (count == Capacity) return false;
+        set((head + count) & Mask, d);
+        ++count;
+        ++rev;
+        return true;
+    }
+
+    void popBack()  { if (count > 0) { --count; ++rev; } }
+    void popFront() { if (count > 0) { head = (head + 1) & Mask; --count; ++rev; } }
+    void clear()    { head = 0; count = 0; ++rev; }
+
+    Direction front() const { return (*this)[0]; }
+    Direction back() const  { return (*this)[count - 1]; }
+
+    // i = 0 is the next move to execute
+    Direction operator[](int i) const
+    {
+        int slot = (head + i) & Mask;
+        return (Direction)((words[slot >> 5] >> ((slot & 31) * 2)) & 3u);
+    }
+
+    int size() const   { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const  { return count == Capacity; }
+
+    // changes on every push / pop / clear, so caches of the plan (GhostPath) can tell a plan that
+    // merely has the same length apart from the one they were built for. A copy carries its
+    // source's revision.
+    std::uint32_t revision() const { return rev; }
+
+    // minimal iterator so range-for works
+    class const_iterator {
+    public:
+        const_iterator(const MovePlan* p, int i) : plan(p), idx(i) {}
+        Direction operator*() const { return (*plan)[idx]; }
+        const_iterator& operator++() { ++idx; return *this; }
+        bool operator!=(const const_iterator& o) const { return idx != o.idx; }
+    private:
+        const MovePlan* plan;
+        int idx;
+    };
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const   { return {this, count}; }
+
+private:
+    static constexpr int Mask = Capacity - 1;
+    static constexpr int Words = Capacity / 32;   // 32 moves per 64-bit word
+
+    void set(int slot, Direction d)
+    {
+        std::uint64_t& w = words[slot >> 5];
+        int shift = (slot & 31) * 2;
+        w = (w & ~(std::uint64_t(3) << shift)) | (std::uint64_t((std::uint8_t)d & 3u) << shift);
+    }
+
+    std::uint64_t words[Words] = {};
+    std::uint16_t head = 0;    // slot of the next move to execute
+    std::uint16_t count = 0;
+    std::uint32_t rev = 0;
+};
+
+static_assert((MovePlan::Capacity & (MovePlan::Capacity - 1)) == 0, "MovePlan capacity must be a power of two");
+static_assert(std::is_trivially_copyable<MovePlan>::value, "MovePlan snapshots are plain copies");
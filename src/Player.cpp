@@ -1,116 +1,74 @@
 #include "Player.h"
-#include <iostream>
+#include "ResourceCache.h"
 
-Player::Player()
-{
-    loadTextures();
-    mSprite = std::make_unique<sf::Sprite>(texUp); // SFML 3: no default ctor
-    resetPosition();
-}
+// ---------------- State ----------------
 
-void Player::loadTextures()
+void PlayerState::resetPosition()
 {
-    if (!texUp.loadFromFile("assets/Player_Up.png"))    std::cerr << "Error: Player_Up.png\n";
-    if (!texDown.loadFromFile("assets/Player_Down.png")) std::cerr << "Error: Player_Down.png\n";
-    if (!texLeft.loadFromFile("assets/Player_Right.png")) std::cerr << "Error: Player_Left.png\n";
-    if (!texRight.loadFromFile("assets/Player_Left.png")) std::cerr << "Error: Player_Right.png\n";
+    gridPos = {board.position.x, board.position.y + board.size.y - 1};
 }
 
-void Player::resetPosition()
-{
-    gridPos = {0, GridSize - 1};
-
-    float originX = (WindowWidth  - GridSize * CellSize) / 2.f;
-    float originY = (WindowHeight - GridSize * CellSize) / 2.f;
-
-    mSprite->setPosition({
-        originX + gridPos.x * CellSize,
-        originY + gridPos.y * CellSize
-    });
-
-    auto s = mSprite->getTexture().getSize(); // SFML 3: reference, not pointer
-    mSprite->setScale({
-        (float)CellSize / s.x,
-        (float)CellSize / s.y
-    });
-}
-
-void Player::enqueueMove(Direction dir)
-{
-    moves.push(dir);
-}
-
-void Player::executeNextMove()
+void PlayerState::executeNextMove()
 {
     if (moves.empty()) return;
 
-    Direction d = moves.front(); moves.pop();
-
-    if (d == Direction::Up    && gridPos.y > 0)               gridPos.y--;
-    else if (d == Direction::Down  && gridPos.y < GridSize-1) gridPos.y++;
-    else if (d == Direction::Left  && gridPos.x > 0)          gridPos.x--;
-    else if (d == Direction::Right && gridPos.x < GridSize-1) gridPos.x++;
-
-    updateSpriteTexture(d);
-
-    float originX = (WindowWidth  - GridSize * CellSize) / 2.f;
-    float originY = (WindowHeight - GridSize * CellSize) / 2.f;
-
-    mSprite->setPosition({
-        originX + gridPos.x * CellSize,
-        originY + gridPos.y * CellSize
-    });
+    Direction d = moves.front(); moves.popFront();
+    gridPos = stepFrom(gridPos, d, board);
+    facing = d;
 }
 
-void Player::updateSpriteTexture(Direction dir)
+sf::Vector2i PlayerState::stepFrom(sf::Vector2i p, Direction d, const sf::IntRect& board)
 {
-    switch (dir) {
-        case Direction::Up:    mSprite->setTexture(texUp); break;
-        case Direction::Down:  mSprite->setTexture(texDown); break;
-        case Direction::Left:  mSprite->setTexture(texLeft); break;
-        case Direction::Right: mSprite->setTexture(texRight); break;
-    }
+    int left = board.position.x, top = board.position.y;
+    int right = left + board.size.x - 1, bottom = top + board.size.y - 1;
 
-    auto s = mSprite->getTexture().getSize();
-    mSprite->setScale({
-        (float)CellSize / s.x,
-        (float)CellSize / s.y
-    });
+    if (d == Direction::Up    && p.y > top)         p.y--;
+    else if (d == Direction::Down  && p.y < bottom) p.y++;
+    else if (d == Direction::Left  && p.x > left)   p.x--;
+    else if (d == Direction::Right && p.x < right)  p.x++;
+    return p;
 }
 
-sf::Vector2i Player::peekNextMove() const
+sf::Vector2i PlayerState::peekNextMove() const
 {
     if (moves.empty()) return gridPos;
-    Direction d = moves.front();
-    sf::Vector2i p = gridPos;
-
-    if (d == Direction::Up    && p.y > 0)            p.y--;
-    else if (d == Direction::Down  && p.y < GridSize-1) p.y++;
-    else if (d == Direction::Left  && p.x > 0)       p.x--;
-    else if (d == Direction::Right && p.x < GridSize-1) p.x++;
-    return p;
+    return stepFrom(gridPos, moves.front(), board);
 }
 
-void Player::undoLastMove()
+// ---------------- Rendering ----------------
+
+Player::Player()
 {
-    if (moves.empty()) return;
+    // (the left / right art is swapped in the files)
+    auto tex = ResourceCache::textures({
+        {"assets/Player_Up.png", {}},
+        {"assets/Player_Down.png", {}},
+        {"assets/Player_Right.png", {}},
+        {"assets/Player_Left.png", {}},
+    });
+    texUp = tex[0];
+    texDown = tex[1];
+    texLeft = tex[2];
+    texRight = tex[3];
 
-    std::queue<Direction> temp;
-    std::vector<Direction> allMoves;
+    mSprite = std::make_unique<sf::Sprite>(*texUp); // SFML 3: no default ctor
+    resetPosition();
+}
 
-    while (!moves.empty())
-    {
-        allMoves.push_back(moves.front());
-        moves.pop();
+const sf::Sprite& Player::getSprite(const PlayerState& state)
+{
+    const sf::Texture* tex = texUp.get();
+    switch (state.facing) {
+        case Direction::Up:    tex = texUp.get(); break;
+        case Direction::Down:  tex = texDown.get(); break;
+        case Direction::Left:  tex = texLeft.get(); break;
+        case Direction::Right: tex = texRight.get(); break;
     }
+    mSprite->setTexture(*tex, true);
 
-    allMoves.pop_back(); // remove last
-
-    for (auto& m : allMoves)
-        moves.push(m);
+    // world coordinates; the game's camera view maps them to the window
+    auto s = tex->getSize();
+    mSprite->setScale({(float)CellSize / s.x, (float)CellSize / s.y});
+    mSprite->setPosition({(float)state.gridPos.x * CellSize, (float)state.gridPos.y * CellSize});
+    return *mSprite;
 }
-
-
-
-
-
@@ -1,32 +1,42 @@
 #pragma once
 #include <SFML/Graphics.hpp>
-#include <queue>
 #include <memory>
+#include <type_traits>
 #include "Config.h"
+#include "MovePlan.h"
 
-enum class Direction { Up, Down, Left, Right };
+// PlayerState: where the player is, what they have planned and which way they face. Plain data
+// (no textures), so solvers / previews / replays can copy it as often as they like.
+struct PlayerState {
+    MovePlan moves;   // planned moves, front = next to execute
+    sf::Vector2i gridPos = {0, GridSize - 1}; // start bottom-left
+    sf::IntRect board = {{0, 0}, {GridSize, GridSize}};   // cells the player may stand on
+    Direction facing = Direction::Up;
 
-class Player {
-public:
-    Player();
-    void loadTextures();
     void resetPosition();
-    void enqueueMove(Direction dir);
+    void placeAt(sf::Vector2i cell) { gridPos = cell; }   // jump to a cell (resume), plan untouched
+    void setBoard(sf::IntRect bounds) { board = bounds; }   // call before resetPosition()
+    bool enqueueMove(Direction dir) { return moves.push(dir); }   // false when the plan is full
     void executeNextMove();
-    void updateSpriteTexture(Direction dir);
-    void undoLastMove();
+    void undoLastMove() { moves.popBack(); }
+    sf::Vector2i peekNextMove() const;
 
+    // one step in direction d, clamped to the board (shared by execution and previews)
+    static sf::Vector2i stepFrom(sf::Vector2i p, Direction d, const sf::IntRect& board);
+};
 
-    sf::Sprite& getSprite() { return *mSprite; }
+static_assert(std::is_trivially_copyable<PlayerState>::value, "PlayerState clones are plain copies");
 
-public: // exposed for preview
-    std::queue<Direction> moves;
-    sf::Vector2i gridPos = {0, GridSize - 1}; // start bottom-left
-    sf::Vector2i peekNextMove() const;
+// Player: the state plus its look. The four facing textures come from the ResourceCache (shared
+// by every Player); the sprite is brought up to date with the state when it's asked for.
+class Player : public PlayerState {
+public:
+    Player();
 
+    const sf::Sprite& getSprite() { return getSprite(*this); }
+    const sf::Sprite& getSprite(const PlayerState& state);   // any state, e.g. a replayed one
 
 private:
-    sf::Texture texUp, texDown, texLeft, texRight;
+    std::shared_ptr<const sf::Texture> texUp, texDown, texLeft, texRight;
     std::unique_ptr<sf::Sprite> mSprite;
 };
-
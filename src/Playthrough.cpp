@@ -0,0 +1,75 @@
+#include "Playthrough.h"
+#include <algorithm>
+
+bool TurnPlan::hasBlock(sf::Vector2i c) const
+{
+    return std::find(blocks.begin(), blocks.end(), c) != blocks.end();
+}
+
+void Playthrough::start(const GridState& level, const TurnRules& rules)
+{
+    g = level;
+    levelStart = level.snapshot();
+    R = rules;
+
+    p = PlayerState{};
+    p.setBoard(g.getBounds());
+    p.resetPosition();
+    turns = rules.turnLimit;
+    clockMs = 0;
+    nextHazardMs = HazardMs;
+    nextMoveMs = 0;
+}
+
+bool Playthrough::placeBlock(sf::Vector2i c)
+{
+    if (g.isBlocked(c) || g.hasBlockAt(c)) return false;
+    g.placeBlock(c);
+    return true;
+}
+
+TurnOutcome Playthrough::moveTick()
+{
+    if (p.moves.empty()) {
+        // execution finished normally: count the turn, then the next one starts from a clear board
+        if (R.turnLimit >= 0) --turns;
+        if (g.allItemsCollected()) return TurnOutcome::Completed;
+        if (R.turnLimit >= 0 && turns <= 0) return TurnOutcome::Failed;
+        g.clearBlocks();
+        g.clearProjectiles();
+        return TurnOutcome::TurnEnded;
+    }
+
+    if (g.isBlocked(p.peekNextMove())) {
+        p.moves.popFront();   // blocked move is consumed in place
+        return TurnOutcome::Running;
+    }
+
+    p.executeNextMove();
+    bool picked = g.checkItemAt(p.gridPos);
+
+    if (g.cellHasBeam(p.gridPos) || g.cellHasProjectile(p.gridPos)) {
+        if (R.turnLimit >= 0) --turns;
+        if (R.doubleDeathPenalty && R.turnLimit >= 0) --turns;
+
+        // level start: chests back, blocks / beams / balls gone, player home (hazard steps go on)
+        p.resetPosition();
+        p.moves.clear();
+        g.restore(levelStart);
+
+        if (R.turnLimit >= 0 && turns <= 0) return TurnOutcome::Failed;
+        return TurnOutcome::Died;
+    }
+
+    if (picked && g.allItemsCollected()) return TurnOutcome::Completed;
+    return TurnOutcome::Running;
+}
+
+TurnOutcome Playthrough::playMove()
+{
+    int at = nextMoveMs;
+    clockMs = at;
+    TurnOutcome o = moveTick();
+    nextMoveMs = at + MoveMs;
+    return o;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Grid.h"
+#include "Player.h"
+
+// Headless play of one level on the game's own GridState / PlayerState: the turn loop of
+// Game::updatePlaying (planning-phase hazard ticks, blocks, execution, deaths, turn counting)
+// without a window, so stress runs and solvers play by exactly the rules the game does.
+
+// difficulty-dependent numbers (see Settings in Game.h)
+struct TurnRules {
+    int blocksPerTurn = 2;
+    int turnLimit = -1;             // -1 => infinite
+    bool doubleDeathPenalty = true; // Normal / Hard lose two turns per death
+};
+
+// One planning turn's input: blocks are placed first, then the moves execute. Reusing one keeps
+// its block list's capacity.
+struct TurnPlan {
+    MovePlan moves;
+    std::vector<sf::Vector2i> blocks;
+
+    void clear() { moves.clear(); blocks.clear(); }
+    bool hasBlock(sf::Vector2i c) const;
+};
+
+enum class TurnOutcome : std::uint8_t { Running, Died, TurnEnded, Completed, Failed };
+
+// Copying one is a GridState copy (shared parts, see GridState); assigning onto an existing one
+// reuses its buffers, so planners keep a scratch Playthrough per thread and try moves on it.
+class Playthrough {
+public:
+    static constexpr int PlanningMs = 10000;   // Game::planningTime
+    static constexpr int HazardMs = 220;       // Game::HazardIntervalMs
+    static constexpr int MoveMs = 250;         // Game::MoveIntervalMs
+
+    // level start: `level` is a GridState fresh from loadLevel (only its shared parts are taken)
+    void start(const GridState& level, const TurnRules& rules);
+
+    const GridState& grid() const { return g; }
+    const PlayerState& player() const { return p; }
+    const TurnRules& rules() const { return R; }
+    int turnsRemaining() const { return turns; }
+
+    sf::Vector2i step(sf::Vector2i c, Direction d) const { return PlayerState::stepFrom(c, d, p.board); }
+    bool placeBlock(sf::Vector2i c);            // what B does (no-op when blocked / taken)
+    void queueMove(Direction d) { p.moves.push(d); }
+
+    // plays one whole turn: planning-phase hazard ticks, the plan's blocks, then execution.
+    // onTick(const Playthrough&, TurnOutcome) runs after every hazard or move tick and can
+    // return false to stop early.
+    template <class OnTick>
+    TurnOutcome runTurn(const TurnPlan& plan, OnTick&& onTick);
+
+    // runTurn's phases, for planners that pick each move as the turn plays out:
+    // playPlanning() places the plan's blocks, queues its moves and plays the planning phase,
+    // playUntilMove() plays the hazard ticks due before the next move, playMove() makes that
+    // move (with nothing queued it ends the turn). The first two return false if onTick stopped them.
+    template <class OnTick>
+    bool playPlanning(const TurnPlan& plan, OnTick&& onTick);
+    template <class OnTick>
+    bool playUntilMove(OnTick&& onTick);
+    TurnOutcome playMove();
+
+private:
+    TurnOutcome moveTick();                     // Game::executeMove
+
+    GridState g;
+    PlayerState p;
+    GridState::Snapshot levelStart;
+    TurnRules R;
+    int turns = -1;
+    int clockMs = 0;                            // simulated time, drives the hazard / move cadence
+    int nextHazardMs = 0;
+    int nextMoveMs = 0;
+};
+
+template <class OnTick>
+TurnOutcome Playthrough::runTurn(const TurnPlan& plan, OnTick&& onTick)
+{
+    if (!playPlanning(plan, onTick)) return TurnOutcome::Running;
+
+    // execution: moves every MoveMs, hazards keep their own cadence in between
+    while (true) {
+        if (!playUntilMove(onTick)) return TurnOutcome::Running;
+        TurnOutcome o = playMove();
+        if (!onTick(*this, o)) return o;
+        if (o != TurnOutcome::Running) return o;
+    }
+}
+
+template <class OnTick>
+bool Playthrough::playPlanning(const TurnPlan& plan, OnTick&& onTick)
+{
+    for (size_t i = 0; i < plan.blocks.size() && (int)i < R.blocksPerTurn; ++i) placeBlock(plan.blocks[i]);
+    p.moves = plan.moves;
+
+    // planning: only hazards move
+    int planningEnd = clockMs + PlanningMs;
+    while (nextHazardMs <= planningEnd) {
+        clockMs = nextHazardMs;
+        g.stepHazards();
+        nextHazardMs += HazardMs;
+        if (!onTick(*this, TurnOutcome::Running)) return false;
+    }
+    clockMs = planningEnd;
+    nextMoveMs = clockMs + MoveMs;
+    return true;
+}
+
+template <class OnTick>
+bool Playthrough::playUntilMove(OnTick&& onTick)
+{
+    while (nextHazardMs <= nextMoveMs) {
+        clockMs = nextHazardMs;
+        g.stepHazards();
+        nextHazardMs += HazardMs;
+        if (!onTick(*this, TurnOutcome::Running)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,183 @@
+#include "Profiler.h"
+#include "Config.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+    // overlay layout (window coordinates)
+    const float PanelW = 250.f;
+    const float PanelH = 215.f;
+    const float PanelX = WindowWidth - PanelW - 10.f;
+    const float PanelY = 70.f;
+    const float GraphH = 60.f;
+    const float GraphMaxMs = 33.3f;   // top of the graph (~30 fps)
+    const float BudgetMs = 16.7f;     // reference line (60 fps)
+}
+
+const char* FrameProfiler::stageName(ProfileStage s)
+{
+    switch (s) {
+        case ProfileStage::Events:   return "events";
+        case ProfileStage::Update:   return "update";
+        case ProfileStage::Hazards:  return "hazards";
+        case ProfileStage::GridDraw: return "grid_draw";
+        case ProfileStage::Hud:      return "hud";
+        case ProfileStage::Display:  return "display";
+        case ProfileStage::Count:    break;
+    }
+    return "?";
+}
+
+void FrameProfiler::beginFrame()
+{
+    current = FrameSample{};
+    frameStart = clock.getElapsedTime();
+    AllocTracker::snapshot(allocBase);
+}
+
+void FrameProfiler::endFrame()
+{
+    current.frameMs = (clock.getElapsedTime() - frameStart).asMicroseconds() / 1000.f;
+
+    if (AllocTracker::Enabled) {
+        AllocTracker::Snapshot now;
+        AllocTracker::snapshot(now);
+        for (int i = 0; i < AllocTracker::MaxSubsystems; ++i) {
+            if (i == AllocTracker::Background) continue;
+            auto n = (std::uint32_t)(now.perSubsystem[i].allocs - allocBase.perSubsystem[i].allocs);
+            auto b = (std::uint32_t)(now.perSubsystem[i].bytes - allocBase.perSubsystem[i].bytes);
+            current.allocs += n;
+            current.allocBytes += b;
+            if (i >= 1 && i <= (int)ProfileStage::Count) current.stageAllocs[i - 1] = n;
+        }
+    }
+
+    samples[head] = current;
+    head = (head + 1) % HistorySize;
+    if (count < HistorySize) ++count;
+}
+
+void FrameProfiler::beginStage(ProfileStage s)
+{
+    stageStart[(int)s] = clock.getElapsedTime();
+    allocPrev[(int)s] = AllocTracker::enter((int)s + 1);
+}
+
+void FrameProfiler::endStage(ProfileStage s)
+{
+    AllocTracker::leave(allocPrev[(int)s]);
+
+    // accumulate: a stage may run more than once per frame
+    sf::Time d = clock.getElapsedTime() - stageStart[(int)s];
+    current.stageMs[(int)s] += d.asMicroseconds() / 1000.f;
+}
+
+void FrameProfiler::addStageTime(ProfileStage s, float ms)
+{
+    current.stageMs[(int)s] += ms;
+}
+
+const FrameSample& FrameProfiler::sampleAt(int age) const
+{
+    int idx = (head - 1 - age + HistorySize * 2) % HistorySize;
+    return samples[idx];
+}
+
+bool FrameProfiler::dumpCsv(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "frame,frame_ms";
+    for (int s = 0; s < (int)ProfileStage::Count; ++s)
+        out << ',' << stageName((ProfileStage)s) << "_ms";
+    if (AllocTracker::Enabled) {
+        out << ",allocs,alloc_bytes";
+        for (int s = 0; s < (int)ProfileStage::Count; ++s)
+            out << ',' << stageName((ProfileStage)s) << "_allocs";
+    }
+    out << '\n';
+
+    for (int i = count - 1, n = 0; i >= 0; --i, ++n) {
+        const FrameSample& fs = sampleAt(i);
+        out << n << ',' << fs.frameMs;
+        for (float v : fs.stageMs) out << ',' << v;
+        if (AllocTracker::Enabled) {
+            out << ',' << fs.allocs << ',' << fs.allocBytes;
+            for (auto a : fs.stageAllocs) out << ',' << a;
+        }
+        out << '\n';
+    }
+    return (bool)out;
+}
+
+// ---------------- Overlay ----------------
+
+void FrameProfiler::draw(sf::RenderTarget& win, const sf::Font& font)
+{
+    if (!visible) return;
+
+    if (!statsText) {
+        statsText = std::make_unique<sf::Text>(font, "", 13u);
+        statsText->setFillColor(sf::Color::White);
+        statsText->setPosition({PanelX + 8.f, PanelY + 6.f});
+
+        panel.setSize({PanelW, PanelH});
+        panel.setPosition({PanelX, PanelY});
+        panel.setFillColor(sf::Color(0, 0, 0, 170));
+        panel.setOutlineColor(sf::Color(255, 255, 255, 120));
+        panel.setOutlineThickness(1.f);
+
+        float budgetY = PanelY + PanelH - 6.f - GraphH * (BudgetMs / GraphMaxMs);
+        budgetLine.setSize({PanelW - 12.f, 1.f});
+        budgetLine.setPosition({PanelX + 6.f, budgetY});
+        budgetLine.setFillColor(sf::Color(80, 220, 80, 160));
+
+        graph.resize(HistorySize);
+    }
+
+    // rolling frame-time graph (newest on the right)
+    float graphBottom = PanelY + PanelH - 6.f;
+    float stepX = (PanelW - 12.f) / (HistorySize - 1);
+    for (int i = 0; i < HistorySize; ++i) {
+        int age = HistorySize - 1 - i;
+        float ms = age < count ? sampleAt(age).frameMs : 0.f;
+        float h = std::min(ms, GraphMaxMs) / GraphMaxMs * GraphH;
+        graph[i].position = {PanelX + 6.f + i * stepX, graphBottom - h};
+        graph[i].color = ms > BudgetMs ? sf::Color(255, 90, 90) : sf::Color(255, 230, 80);
+    }
+
+    // refresh numbers ~4 times per second so they stay readable
+    if (framesSinceTextUpdate-- <= 0 && count > 0) {
+        framesSinceTextUpdate = 15;
+
+        float sum = 0.f, worst = 0.f;
+        std::array<float, (int)ProfileStage::Count> stageSum{};
+        for (int age = 0; age < count; ++age) {
+            const FrameSample& fs = sampleAt(age);
+            sum += fs.frameMs;
+            worst = std::max(worst, fs.frameMs);
+            for (int s = 0; s < (int)ProfileStage::Count; ++s) stageSum[s] += fs.stageMs[s];
+        }
+
+        char buf[512];
+        int n = snprintf(buf, sizeof(buf), "frame  avg %.2f  max %.2f ms\n", sum / count, worst);
+        const FrameSample& last = sampleAt(0);
+        for (int s = 0; s < (int)ProfileStage::Count && n < (int)sizeof(buf); ++s) {
+            n += snprintf(buf + n, sizeof(buf) - n, "%-10s %6.2f  (avg %.2f)",
+                          stageName((ProfileStage)s), last.stageMs[s], stageSum[s] / count);
+            if (AllocTracker::Enabled && n < (int)sizeof(buf))
+                n += snprintf(buf + n, sizeof(buf) - n, "  %u a", (unsigned)last.stageAllocs[s]);
+            if (n < (int)sizeof(buf) - 1) { buf[n++] = '\n'; buf[n] = '\0'; }
+        }
+        if (AllocTracker::Enabled && n < (int)sizeof(buf))
+            snprintf(buf + n, sizeof(buf) - n, "allocs %u  (%u bytes)", (unsigned)last.allocs, (unsigned)last.allocBytes);
+        statsText->setString(buf);
+    }
+
+    win.draw(panel);
+    win.draw(budgetLine);
+    win.draw(graph);
+    win.draw(*statsText);
+}
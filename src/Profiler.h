@@ -0,0 +1,86 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include "AllocTracker.h"
+
+// Stages timed by the frame profiler (order = CSV column order)
+enum class ProfileStage {
+    Events,     // window.pollEvent loop (+ waiting for a planning key's frame)
+    Update,     // Game::update on the simulation thread (includes hazard steps)
+    Hazards,    // grid.stepHazards (simulation thread)
+    GridDraw,   // Grid::draw
+    Hud,        // HUD / menu text drawing
+    Display,    // window.display (vsync / driver wait)
+    Count
+};
+
+// One recorded frame (times in milliseconds; alloc counts only filled with TRACK_ALLOCS)
+struct FrameSample {
+    float frameMs = 0.f;
+    std::array<float, (int)ProfileStage::Count> stageMs{};
+    std::uint32_t allocs = 0;           // heap allocations during the frame (all stages)
+    std::uint32_t allocBytes = 0;
+    std::array<std::uint32_t, (int)ProfileStage::Count> stageAllocs{};
+};
+
+// FrameProfiler: fixed-size ring of frame samples + toggleable overlay (F3) and CSV dump (F4)
+class FrameProfiler {
+public:
+    static constexpr int HistorySize = 240; // ~4 seconds at 60 fps
+
+    void beginFrame();
+    void endFrame();
+
+    void beginStage(ProfileStage s);
+    void endStage(ProfileStage s);
+    void addStageTime(ProfileStage s, float ms);   // a stage that ran on another thread this frame
+
+    void toggle() { visible = !visible; }
+    bool isVisible() const { return visible; }
+
+    // write the ring buffer (oldest -> newest) as CSV, returns false on I/O error
+    bool dumpCsv(const std::string& path) const;
+
+    // draw overlay panel in window (default view) coordinates
+    void draw(sf::RenderTarget& win, const sf::Font& font);
+
+    static const char* stageName(ProfileStage s);
+
+    const FrameSample& latest() const { return sampleAt(0); }
+
+private:
+    const FrameSample& sampleAt(int age) const; // 0 = most recent finished frame
+
+    std::array<FrameSample, HistorySize> samples{};
+    int head = 0;   // next slot to write
+    int count = 0;  // number of valid samples
+
+    FrameSample current;
+    sf::Clock clock;                 // monotonic time base
+    sf::Time frameStart;
+    std::array<sf::Time, (int)ProfileStage::Count> stageStart{};
+    std::array<int, (int)ProfileStage::Count> allocPrev{};  // alloc subsystem to restore per stage
+    AllocTracker::Snapshot allocBase;                         // counters at frame start
+
+    bool visible = false;
+
+    // overlay resources (built lazily, text refreshed a few times per second)
+    std::unique_ptr<sf::Text> statsText;
+    sf::VertexArray graph{sf::PrimitiveType::LineStrip};
+    sf::RectangleShape panel;
+    sf::RectangleShape budgetLine;
+    int framesSinceTextUpdate = 0;
+};
+
+// RAII helper: times a stage for the enclosing scope
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler& p, ProfileStage s) : prof(p), stage(s) { prof.beginStage(stage); }
+    ~ProfileScope() { prof.endStage(stage); }
+private:
+    FrameProfiler& prof;
+    ProfileStage stage;
+};
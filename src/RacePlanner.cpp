@@ -0,0 +1,251 @@
+#include "RacePlanner.h"
+#include "AgentStore.h"
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace {
+    const int GhostsPerJob = 16;
+    const int MaxTurns = 24;      // a run that hasn't cleared the level by then just stops
+    const int MinPace = 12;       // moves per turn, picked per ghost
+    const int MaxPace = 40;
+
+    const Direction Dirs[4] = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
+
+    // BFS scratch for one job (board-sized, reused by all its ghosts)
+    struct Router {
+        std::vector<int> parent;                 // per board cell
+        std::vector<sf::Vector2i> queue;
+        std::vector<char> onPath;                // per board cell
+        std::vector<char> taken;                 // per chest: a look-ahead route already passed it
+
+        static int index(const LevelData& L, sf::Vector2i c) { return c.y * L.width + (c.x - L.originX); }
+
+        bool isTarget(const GridState& g, sf::Vector2i c) const
+        {
+            int item = g.getLevel()->itemIndex(c);
+            return item >= 0 && !g.getItems()[item].collected && !taken[item];
+        }
+
+        // first move of a shortest route from `from` to the nearest uncollected chest, neighbours
+        // tried in `order`; cells under a beam right now are avoided if `avoidBeams`
+        bool firstStep(const Playthrough& sim, sf::Vector2i from, const std::array<Direction, 4>& order, bool avoidBeams,
+                       Direction& out)
+        {
+            const GridState& g = sim.grid();
+            const LevelData& L = *g.getLevel();
+            parent.assign((size_t)L.width * L.height, -1);
+            queue.clear();
+            queue.push_back(from);
+            int origin = index(L, from);
+            parent[origin] = origin;
+
+            for (size_t qi = 0; qi < queue.size(); ++qi) {
+                sf::Vector2i c = queue[qi];
+                for (Direction d : order) {
+                    sf::Vector2i n = sim.step(c, d);
+                    int ni = index(L, n);
+                    if (parent[ni] >= 0 || g.isBlocked(n) || (avoidBeams && g.cellHasBeam(n))) continue;
+                    parent[ni] = index(L, c);
+                    if (isTarget(g, n)) {
+                        while (parent[ni] != origin) ni = parent[ni];
+                        for (Direction f : Dirs)
+                            if (index(L, sim.step(from, f)) == ni) { out = f; return true; }
+                        return false;
+                    }
+                    queue.push_back(n);
+                }
+            }
+            return false;
+        }
+    };
+
+    // everything one job reuses for all its ghosts
+    struct Scratch {
+        Router router;
+        Playthrough sim;
+        Playthrough trial;   // a move tried out before it's made
+        TurnPlan plan;
+    };
+
+    // blocks for the coming turn: follow the route to the next chests (hazards ignored) and,
+    // wherever it crosses a cannon's or laser's lane, block that lane as close to the hazard as
+    // the route allows
+    void chooseBlocks(const Playthrough& sim, Router& router, const std::array<Direction, 4>& order, int pace,
+                      TurnPlan& plan)
+    {
+        const GridState& g = sim.grid();
+        const LevelData& L = *g.getLevel();
+        int limit = std::min(sim.rules().blocksPerTurn, AgentStore::MaxBlocks);
+        if (limit <= 0) return;
+
+        router.onPath.assign((size_t)L.width * L.height, 0);
+        std::fill(router.taken.begin(), router.taken.end(), 0);
+        sf::Vector2i at = sim.player().gridPos;
+        router.onPath[Router::index(L, at)] = 1;
+        Direction d;
+        for (int m = 0; m < pace && router.firstStep(sim, at, order, false, d); ++m) {
+            at = sim.step(at, d);
+            router.onPath[Router::index(L, at)] = 1;
+            int item = L.itemIndex(at);
+            if (item >= 0) router.taken[item] = 1;
+        }
+
+        for (size_t h = 0; h < L.hazards.size() && (int)plan.blocks.size() < limit; ++h) {
+            const Hazard& hz = L.hazards[h];
+            sf::Vector2i dir = hz.info().dir;
+            sf::Vector2i first;   // first lane cell off the route, so far
+            bool found = false;
+            for (sf::Vector2i c = hz.pos + dir; L.inBounds(c) && !g.stopsShot(c); c += dir) {
+                if (router.onPath[Router::index(L, c)]) {
+                    if (found) plan.blocks.push_back(first);
+                    break;
+                }
+                if (!found && !g.isBlocked(c) && c != sim.player().gridPos) { first = c; found = true; }
+            }
+        }
+    }
+
+    bool survives(const Playthrough& sim, Playthrough& trial, Direction d)
+    {
+        trial = sim;   // (into the trial's own buffers)
+        trial.queueMove(d);
+        TurnOutcome o = trial.playMove();
+        return o != TurnOutcome::Died && o != TurnOutcome::Failed;
+    }
+
+    // one ghost's whole run, appended to `out` in AgentStore format. Each move is picked as the
+    // turn plays out: toward the nearest chest if that is safe right then, otherwise waiting
+    // against a wall or stepping aside. A ghost only dies when every option would kill it.
+    bool planGhost(const GridState& level, const TurnRules& rules, std::mt19937& rng, Scratch& s,
+                   std::vector<std::uint8_t>& out)
+    {
+        Playthrough& sim = s.sim;
+        Router& router = s.router;
+        TurnPlan& plan = s.plan;
+        sim.start(level, rules);
+        router.taken.assign(level.getItems().size(), 0);
+        int pace = std::uniform_int_distribution<int>(MinPace, MaxPace)(rng);
+        auto always = [](const Playthrough&, TurnOutcome) { return true; };
+        std::array<Direction, 4> order = { Direction::Up, Direction::Down, Direction::Left, Direction::Right };
+
+        for (int turn = 0; turn < MaxTurns; ++turn) {
+            plan.clear();
+            std::shuffle(order.begin(), order.end(), rng);
+            chooseBlocks(sim, router, order, pace, plan);
+            for (sf::Vector2i b : plan.blocks) {
+                out.push_back(AgentStore::BlockOp);
+                out.push_back((std::uint8_t)b.x);
+                out.push_back((std::uint8_t)b.y);
+            }
+            sim.playPlanning(plan, always);
+            std::fill(router.taken.begin(), router.taken.end(), 0);
+
+            for (int m = 0; m < pace; ++m) {
+                sim.playUntilMove(always);
+                sf::Vector2i at = sim.player().gridPos;
+                std::shuffle(order.begin(), order.end(), rng);
+
+                Direction toward;
+                if (!router.firstStep(sim, at, order, true, toward) && !router.firstStep(sim, at, order, false, toward))
+                    break;   // nothing left to reach: this ghost's turn is over
+
+                // candidates: toward the chest, wait (walk into a wall), any other way
+                Direction pick = toward;
+                bool safe = survives(sim, s.trial, toward);
+                for (int k = 0; k < 4 && !safe; ++k) {
+                    sf::Vector2i n = sim.step(at, order[k]);
+                    if ((n == at || sim.grid().isBlocked(n)) && survives(sim, s.trial, order[k])) { pick = order[k]; safe = true; }
+                }
+                for (int k = 0; k < 4 && !safe; ++k)
+                    if (order[k] != toward && survives(sim, s.trial, order[k])) { pick = order[k]; safe = true; }
+
+                sim.queueMove(pick);
+                out.push_back((std::uint8_t)pick);
+                TurnOutcome o = sim.playMove();
+                if (o == TurnOutcome::Completed) return true;
+                if (!safe) return false;   // every option kills it: the run ends with this move
+            }
+
+            // end of the turn (turn counter, blocks / cannonballs cleared)
+            out.push_back(AgentStore::TurnBreak);
+            sim.playUntilMove(always);
+            TurnOutcome o = sim.playMove();
+            if (o == TurnOutcome::Completed) return true;
+            if (o == TurnOutcome::Failed) return false;
+        }
+        return false;
+    }
+}
+
+struct RacePlanner::Work {
+    GridState level;   // fresh from loadLevel; each ghost's Playthrough starts from a copy
+    TurnRules rules;
+    std::uint32_t seed = 0;
+    std::vector<std::vector<std::uint8_t>> runs;   // one per ghost, each written by one job
+    std::vector<std::uint8_t> completes;
+};
+
+RacePlanner::~RacePlanner()
+{
+    cancel();
+}
+
+void RacePlanner::cancel()
+{
+    if (jobs) {
+        jobs->cancel();
+        JobSystem::instance().wait(*jobs);
+        jobs.reset();
+    }
+    work.reset();
+}
+
+void RacePlanner::start(std::shared_ptr<const LevelData> level, const TurnRules& rules, int ghosts, std::uint32_t seed)
+{
+    TRACE_SCOPE("RacePlanner::start");
+    cancel();
+
+    auto w = std::make_shared<Work>();
+    w->level.loadLevel(std::move(level));
+    w->rules = rules;
+    w->seed = seed;
+    w->runs.resize(ghosts);
+    w->completes.assign(ghosts, 0);
+
+    work = w;
+    jobs = JobSystem::instance().makeGroup();
+    for (int first = 0; first < ghosts; first += GhostsPerJob) {
+        int last = std::min(ghosts, first + GhostsPerJob);
+        JobSystem::instance().submit([w, first, last] {
+            TRACE_SCOPE("RacePlanner::job");
+            Scratch scratch;
+            for (int g = first; g < last; ++g) {
+                std::mt19937 rng(w->seed * 0x9E3779B9u + (std::uint32_t)g);
+                w->completes[g] = planGhost(w->level, w->rules, rng, scratch, w->runs[g]) ? 1 : 0;
+            }
+        }, jobs);
+    }
+}
+
+std::shared_ptr<const RacePlans> RacePlanner::poll()
+{
+    if (!jobs || !jobs->isDone()) return nullptr;
+    jobs.reset();
+
+    // flatten into one buffer, the layout AgentStore keeps
+    auto plans = std::make_shared<RacePlans>();
+    size_t total = 0;
+    for (const auto& r : work->runs) total += r.size();
+    plans->moves.reserve(total);
+    plans->offsets.reserve(work->runs.size() + 1);
+    for (const auto& r : work->runs) {
+        plans->offsets.push_back((std::uint32_t)plans->moves.size());
+        plans->moves.insert(plans->moves.end(), r.begin(), r.end());
+    }
+    plans->offsets.push_back((std::uint32_t)plans->moves.size());
+    plans->completes = std::move(work->completes);
+    work.reset();
+    return plans;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Grid.h"
+#include "JobSystem.h"
+#include "Playthrough.h"
+
+// Ghost runs for race mode, in AgentStore's plan format (Direction bytes, TurnBreak after each turn)
+struct RacePlans {
+    std::vector<std::uint8_t> moves;      // every run back to back
+    std::vector<std::uint32_t> offsets;   // run g = moves[offsets[g], offsets[g + 1])
+    std::vector<std::uint8_t> completes;  // 1 if the run clears the level when played out
+
+    int count() const { return (int)completes.size(); }
+};
+
+// RacePlanner: builds solver ghosts for a level on JobSystem workers. Each ghost plays the level
+// in a Playthrough, heading for the nearest chest with its own random tie-breaks and moves per
+// turn, and checks every move against the hazards before making it. One level is planned at a
+// time; poll() never blocks.
+class RacePlanner {
+public:
+    RacePlanner() = default;
+    ~RacePlanner();
+    RacePlanner(const RacePlanner&) = delete;
+    RacePlanner& operator=(const RacePlanner&) = delete;
+
+    // drops any other planning
+    void start(std::shared_ptr<const LevelData> level, const TurnRules& rules, int ghosts, std::uint32_t seed);
+
+    // the finished runs once every job is done (then nullptr until the next start)
+    std::shared_ptr<const RacePlans> poll();
+
+    void cancel();
+
+private:
+    struct Work;   // shared with the jobs
+
+    std::shared_ptr<TaskGroup> jobs;
+    std::shared_ptr<Work> work;
+};
@@ -0,0 +1,80 @@
+#include "ResourceCache.h"
+#include "JobSystem.h"
+#include "Trace.h"
+#include <iostream>
+
+ResourceCache& ResourceCache::instance()
+{
+    static ResourceCache cache;
+    return cache;
+}
+
+std::shared_ptr<const sf::Texture> ResourceCache::texture(const std::string& path, TextureOptions options)
+{
+    return textures({{path, options}}).front();
+}
+
+std::vector<std::shared_ptr<const sf::Texture>> ResourceCache::textures(const std::vector<TextureRequest>& requests)
+{
+    TRACE_SCOPE("ResourceCache::textures");
+    ResourceCache& rc = instance();
+    std::vector<std::shared_ptr<const sf::Texture>> out(requests.size());
+
+    // what's already resident
+    std::vector<size_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(rc.mtx);
+        for (size_t i = 0; i < requests.size(); ++i) {
+            auto it = rc.textureCache.find({requests[i].path, optionBits(requests[i].options)});
+            if (it != rc.textureCache.end()) out[i] = it->second.lock();
+            if (!out[i]) missing.push_back(i);
+        }
+    }
+    if (missing.empty()) return out;
+
+    // decode the rest in parallel (callers wait, so high priority), upload here: textures need
+    // the GL context
+    JobSystem& jobs = JobSystem::instance();
+    auto group = jobs.makeGroup();
+    std::vector<sf::Image> images(missing.size());
+    std::vector<char> decoded(missing.size(), 0);
+    for (size_t k = 0; k < missing.size(); ++k)
+        jobs.submit([&, k]{ decoded[k] = images[k].loadFromFile(requests[missing[k]].path); },
+                    group, JobSystem::Priority::High);
+    jobs.wait(*group);
+
+    std::lock_guard<std::mutex> lock(rc.mtx);
+    for (size_t k = 0; k < missing.size(); ++k) {
+        const TextureRequest& r = requests[missing[k]];
+        TextureKey key{r.path, optionBits(r.options)};
+
+        // someone else may have loaded it meanwhile (or the same file was asked for twice)
+        std::weak_ptr<const sf::Texture>& slot = rc.textureCache[key];
+        if (auto existing = slot.lock()) {
+            out[missing[k]] = existing;
+            continue;
+        }
+
+        auto tex = std::make_shared<sf::Texture>();
+        if (!decoded[k] || !tex->loadFromImage(images[k]))
+            std::cerr << "Error loading " << r.path << "\n";
+        tex->setSmooth(r.options.smooth);
+        tex->setRepeated(r.options.repeated);
+        slot = tex;
+        out[missing[k]] = std::move(tex);
+    }
+    return out;
+}
+
+std::shared_ptr<const sf::Font> ResourceCache::font(const std::string& path)
+{
+    ResourceCache& rc = instance();
+    std::lock_guard<std::mutex> lock(rc.mtx);
+    std::weak_ptr<const sf::Font>& slot = rc.fontCache[path];
+    if (auto f = slot.lock()) return f;
+
+    auto f = std::make_shared<sf::Font>();
+    if (!f->openFromFile(path)) std::cerr << "Missing font: " << path << "\n";
+    slot = f;
+    return f;
+}
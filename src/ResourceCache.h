@@ -0,0 +1,45 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// ResourceCache: process-wide, reference-counted textures and fonts. Every file is loaded once
+// and shared by everyone asking for it; it's freed when the last shared_ptr to it goes away, so
+// a second Grid / Player (or a preview) costs no GPU memory. Failures are reported on std::cerr
+// and give an empty resource (never null). Textures need the window's GL context, so ask for
+// them from the window thread; the lookup itself is thread-safe.
+class ResourceCache {
+public:
+    struct TextureOptions {
+        bool smooth = false;
+        bool repeated = false;
+    };
+
+    struct TextureRequest {
+        std::string path;
+        TextureOptions options;
+    };
+
+    static std::shared_ptr<const sf::Texture> texture(const std::string& path) { return texture(path, TextureOptions{}); }
+    static std::shared_ptr<const sf::Texture> texture(const std::string& path, TextureOptions options);
+
+    // several at once: the ones not loaded yet are decoded in parallel on the JobSystem, then
+    // uploaded on this thread. Results are in request order.
+    static std::vector<std::shared_ptr<const sf::Texture>> textures(const std::vector<TextureRequest>& requests);
+
+    static std::shared_ptr<const sf::Font> font(const std::string& path);
+
+private:
+    // path (+ options: the same file smooth and not smooth are two textures)
+    using TextureKey = std::pair<std::string, unsigned>;
+    static unsigned optionBits(TextureOptions o) { return (o.smooth ? 1u : 0u) | (o.repeated ? 2u : 0u); }
+
+    static ResourceCache& instance();
+
+    std::mutex mtx;
+    std::map<TextureKey, std::weak_ptr<const sf::Texture>> textureCache;
+    std::map<std::string, std::weak_ptr<const sf::Font>> fontCache;
+};
@@ -0,0 +1,299 @@
+#include "SaveState.h"
+#include "Trace.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    const char Magic[4] = {'T', 'S', 'A', 'S'};
+    const std::size_t HeaderSize = 16;
+
+    std::uint32_t fnv1a(const std::uint8_t* p, std::size_t n)
+    {
+        std::uint32_t h = 2166136261u;
+        for (std::size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 16777619u; }
+        return h;
+    }
+
+    // little-endian writer into a reused buffer
+    struct Writer {
+        std::vector<std::uint8_t>& out;
+
+        void u8(std::uint32_t v) { out.push_back((std::uint8_t)v); }
+        void u16(std::uint32_t v) { u8(v); u8(v >> 8); }
+        void u32(std::uint32_t v) { u16(v); u16(v >> 16); }
+        void i16(int v) { u16((std::uint32_t)(std::uint16_t)(std::int16_t)v); }
+        void i32(int v) { u32((std::uint32_t)v); }
+        void f32(float v) { std::uint32_t b; std::memcpy(&b, &v, 4); u32(b); }
+        void cell(sf::Vector2i p) { i16(p.x); i16(p.y); }
+    };
+
+    // bounds-checked reader; any overrun just sets `ok` to false
+    struct Reader {
+        const std::uint8_t* p;
+        const std::uint8_t* end;
+        bool ok = true;
+
+        std::uint32_t u8()
+        {
+            if (p >= end) { ok = false; return 0; }
+            return *p++;
+        }
+        std::uint32_t u16() { std::uint32_t a = u8(); return a | (u8() << 8); }
+        std::uint32_t u32() { std::uint32_t a = u16(); return a | (u16() << 16); }
+        int i16() { return (std::int16_t)(std::uint16_t)u16(); }
+        int i32() { return (std::int32_t)u32(); }
+        float f32() { std::uint32_t b = u32(); float v; std::memcpy(&v, &b, 4); return v; }
+        sf::Vector2i cell() { int x = i16(); return {x, i16()}; }
+    };
+}
+
+std::uint32_t SaveState::layoutHash(const std::vector<std::string>& layout)
+{
+    std::uint32_t h = 2166136261u;
+    for (const std::string& row : layout) {
+        for (char c : row) { h ^= (std::uint8_t)c; h *= 16777619u; }
+        h ^= '\n'; h *= 16777619u;
+    }
+    return h;
+}
+
+// ---------------- Encoding ----------------
+
+void encodeSave(const SaveState& s, std::vector<std::uint8_t>& out)
+{
+    out.clear();
+    out.resize(HeaderSize);   // filled in at the end
+    Writer w{out};
+
+    w.u8(s.difficulty);
+    w.u8(s.phase);
+    w.i32(s.level);
+    w.u32(s.levelHash);
+    w.i32(s.initialTurns);
+    w.i32(s.turnsRemaining);
+    w.i32(s.turnNumber);
+    w.i32(s.blocksLeft);
+    w.f32(s.phaseElapsed);
+    w.cell(s.player);
+
+    // moves: 2 bits each
+    w.u16((std::uint32_t)s.moves.size());
+    for (int i = 0; i < s.moves.size(); i += 4) {
+        std::uint32_t packed = 0;
+        for (int k = 0; k < 4 && i + k < s.moves.size(); ++k) packed |= ((std::uint32_t)s.moves[i + k] & 3u) << (k * 2);
+        w.u8(packed);
+    }
+
+    // collected flags: 1 bit each
+    w.u16((std::uint32_t)s.collected.size());
+    for (std::size_t i = 0; i < s.collected.size(); i += 8) {
+        std::uint32_t packed = 0;
+        for (std::size_t k = 0; k < 8 && i + k < s.collected.size(); ++k) packed |= (s.collected[i + k] ? 1u : 0u) << k;
+        w.u8(packed);
+    }
+
+    w.u16((std::uint32_t)s.beamProgress.size());
+    for (int p : s.beamProgress) w.u16((std::uint32_t)p);
+    w.u32(s.hazardStep);
+
+    w.u16((std::uint32_t)s.blocks.size());
+    for (sf::Vector2i b : s.blocks) w.cell(b);
+
+    w.u16((std::uint32_t)s.placedBlocks.size());
+    for (sf::Vector2i b : s.placedBlocks) w.cell(b);
+
+    w.u16((std::uint32_t)s.actions.size());
+    for (const SaveState::Action& a : s.actions) {
+        w.u8((a.isBlock ? 4u : 0u) | ((std::uint32_t)a.dir & 3u));
+        if (a.isBlock) w.cell(a.blockPos);
+    }
+
+    w.u16((std::uint32_t)s.projectiles.size());
+    for (const Projectile& p : s.projectiles) {
+        w.cell(p.pos);
+        w.u8((std::uint32_t)(std::uint8_t)(std::int8_t)p.dir.x);
+        w.u8((std::uint32_t)(std::uint8_t)(std::int8_t)p.dir.y);
+    }
+
+    // header
+    std::uint32_t payload = (std::uint32_t)(out.size() - HeaderSize);
+    std::uint32_t sum = fnv1a(out.data() + HeaderSize, payload);
+    std::memcpy(out.data(), Magic, 4);
+    std::uint8_t* h = out.data() + 4;
+    auto put32 = [&h](std::uint32_t v) { for (int i = 0; i < 4; ++i) *h++ = (std::uint8_t)(v >> (i * 8)); };
+    put32(SaveState::Version);
+    put32(payload);
+    put32(sum);
+}
+
+bool decodeSave(const std::uint8_t* data, std::size_t size, SaveState& s)
+{
+    if (size < HeaderSize || std::memcmp(data, Magic, 4) != 0) return false;
+
+    Reader hr{data + 4, data + HeaderSize};
+    std::uint32_t version = hr.u32();
+    std::uint32_t payload = hr.u32();
+    std::uint32_t sum = hr.u32();
+    if (version != SaveState::Version || payload != size - HeaderSize) return false;
+    if (fnv1a(data + HeaderSize, payload) != sum) return false;
+
+    Reader r{data + HeaderSize, data + size};
+    s.difficulty = (std::uint8_t)r.u8();
+    s.phase = (std::uint8_t)r.u8();
+    s.level = r.i32();
+    s.levelHash = r.u32();
+    s.initialTurns = r.i32();
+    s.turnsRemaining = r.i32();
+    s.turnNumber = r.i32();
+    s.blocksLeft = r.i32();
+    s.phaseElapsed = r.f32();
+    s.player = r.cell();
+
+    int moves = (int)r.u16();
+    if (moves > MovePlan::Capacity) return false;
+    s.moves.clear();
+    for (int i = 0; i < moves && r.ok; i += 4) {
+        std::uint32_t packed = r.u8();
+        for (int k = 0; k < 4 && i + k < moves; ++k) s.moves.push((Direction)((packed >> (k * 2)) & 3u));
+    }
+
+    std::size_t items = r.u16();
+    s.collected.assign(items, 0);
+    for (std::size_t i = 0; i < items && r.ok; i += 8) {
+        std::uint32_t packed = r.u8();
+        for (std::size_t k = 0; k < 8 && i + k < items; ++k) s.collected[i + k] = (packed >> k) & 1u;
+    }
+
+    s.beamProgress.resize(r.u16());
+    for (int& p : s.beamProgress) p = (int)r.u16();
+    s.hazardStep = r.u32();
+
+    s.blocks.resize(r.u16());
+    for (sf::Vector2i& b : s.blocks) b = r.cell();
+
+    s.placedBlocks.resize(r.u16());
+    for (sf::Vector2i& b : s.placedBlocks) b = r.cell();
+
+    s.actions.resize(r.u16());
+    for (SaveState::Action& a : s.actions) {
+        std::uint32_t bits = r.u8();
+        a.isBlock = (bits & 4u) != 0;
+        a.dir = (Direction)(bits & 3u);
+        a.blockPos = a.isBlock ? r.cell() : sf::Vector2i{};
+    }
+
+    s.projectiles.resize(r.u16());
+    for (Projectile& p : s.projectiles) {
+        p.pos = r.cell();
+        int dx = (std::int8_t)r.u8();
+        p.dir = {dx, (int)(std::int8_t)r.u8()};
+        p.alive = true;
+    }
+
+    return r.ok && r.p == r.end;
+}
+
+bool readSaveFile(const std::string& path, SaveState& out)
+{
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    std::vector<std::uint8_t> bytes;
+    std::uint8_t buf[4096];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) bytes.insert(bytes.end(), buf, buf + n);
+    std::fclose(f);
+
+    if (!decodeSave(bytes.data(), bytes.size(), out)) {
+        std::cerr << "[save] " << path << " is corrupt or from another version, ignoring it\n";
+        return false;
+    }
+    return true;
+}
+
+void removeSaveFile(const std::string& path)
+{
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+// ---------------- SaveWriter ----------------
+
+SaveWriter::~SaveWriter()
+{
+    flush();
+}
+
+void SaveWriter::write(std::vector<std::uint8_t>& bytes)
+{
+    if (path.empty()) return;
+    std::lock_guard<std::mutex> lock(mtx);
+    next.swap(bytes);
+    pending = true;
+    if (!running) {
+        running = true;
+        JobSystem::instance().submit([this]{ writeLoop(); }, jobs);
+    }
+}
+
+void SaveWriter::flush()
+{
+    JobSystem::instance().wait(*jobs);
+}
+
+void SaveWriter::remove()
+{
+    std::vector<std::uint8_t> none;
+    write(none);
+}
+
+void SaveWriter::writeLoop()
+{
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!pending) { running = false; return; }
+            pending = false;
+            writing.swap(next);
+        }
+        if (writing.empty()) removeSaveFile(path);
+        else writeAtomically(writing);
+    }
+}
+
+bool SaveWriter::writeAtomically(const std::vector<std::uint8_t>& bytes)
+{
+    TRACE_SCOPE("SaveWriter::write");
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        std::cerr << "[save] can't write " << tmp << "\n";
+        return false;
+    }
+
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size() && std::fflush(f) == 0;
+    // on disk before the rename, so a power cut leaves either the old save or the new one
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(f)) == 0;
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+#endif
+    ok = std::fclose(f) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    if (!ok || ec) {
+        std::cerr << "[save] writing " << path << " failed\n";
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Grid.h"
+#include "JobSystem.h"
+#include "MovePlan.h"
+
+// Everything needed to put a campaign level back exactly where it was left.
+// Plain data; Game fills / applies it, SaveState.cpp only (de)serializes.
+struct SaveState {
+    static constexpr std::uint16_t Version = 2;
+
+    std::uint8_t difficulty = 0;        // Difficulty
+    std::uint8_t phase = 0;             // GamePhase
+    std::int32_t level = 0;             // campaign index
+    std::uint32_t levelHash = 0;        // layoutHash() of the level when saved (edited level => save ignored)
+    std::int32_t initialTurns = -1;
+    std::int32_t turnsRemaining = -1;
+    std::int32_t turnNumber = 0;
+    std::int32_t blocksLeft = 0;
+    float phaseElapsed = 0.f;           // seconds into the current phase
+    sf::Vector2i player;
+    MovePlan moves;
+
+    struct Action {                     // ActionRecord
+        bool isBlock = false;
+        Direction dir = Direction::Up;
+        sf::Vector2i blockPos;
+    };
+
+    std::vector<char> collected;        // per LevelData::items
+    std::vector<int> beamProgress;      // per LevelData::hazards
+    std::uint32_t hazardStep = 0;       // GridState::getHazardStep (where the hazard schedules are)
+    std::vector<sf::Vector2i> blocks;   // on the grid
+    std::vector<sf::Vector2i> placedBlocks;
+    std::vector<Action> actions;
+    std::vector<Projectile> projectiles;
+
+    static std::uint32_t layoutHash(const std::vector<std::string>& layout);
+};
+
+// Binary format: 16-byte header ("TSAS", version, payload size, FNV-1a of the payload), then
+// little-endian fields with 16-bit coordinates / counts. A few hundred bytes for a 20x20 level.
+void encodeSave(const SaveState& s, std::vector<std::uint8_t>& out);
+bool decodeSave(const std::uint8_t* data, std::size_t size, SaveState& out);   // false if corrupt / other version
+
+bool readSaveFile(const std::string& path, SaveState& out);   // false if missing or unusable
+void removeSaveFile(const std::string& path);
+
+// SaveWriter: writes encoded saves on a JobSystem worker (temp file, flush to disk, rename over
+// the old one), so the game thread only pays for encoding and a save is never half-written.
+// Saves arriving while one is being written replace each other; only the newest is written.
+class SaveWriter {
+public:
+    // an empty path writes nothing (headless runs)
+    explicit SaveWriter(std::string path) : path(std::move(path)) {}
+    ~SaveWriter();
+    SaveWriter(const SaveWriter&) = delete;
+    SaveWriter& operator=(const SaveWriter&) = delete;
+
+    // takes the bytes (swaps with an old buffer, so callers can keep reusing theirs)
+    void write(std::vector<std::uint8_t>& bytes);
+    void remove();     // replaces any pending save with deleting the file
+    void flush();      // waits until everything submitted is done
+
+    const std::string& file() const { return path; }
+
+private:
+    void writeLoop();   // job body: writes until nothing is pending
+    bool writeAtomically(const std::vector<std::uint8_t>& bytes);
+
+    std::string path;
+    std::mutex mtx;
+    std::shared_ptr<TaskGroup> jobs = JobSystem::instance().makeGroup();
+    bool running = false;
+    bool pending = false;
+    std::vector<std::uint8_t> next;      // newest save, not yet written (empty => delete the file)
+    std::vector<std::uint8_t> writing;   // owned by the job while it runs
+};
@@ -0,0 +1,510 @@
+#include "Stress.h"
+#include "Playthrough.h"
+#include "Levels.h"
+#include "Game.h"
+#include "GhostPath.h"
+#include "JobSystem.h"
+#include "AllocTracker.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+    const int MaxTurns = 16;     // a run gives up after this many turns (Easy never fails on its own)
+    const int MaxActions = 64;   // key presses per planning turn
+    const int CheckEvery = 256;  // runs between deadline / stop checks
+
+    const Difficulty Difficulties[] = { Difficulty::Easy, Difficulty::Normal, Difficulty::Hard };
+
+    TurnRules rulesFor(Difficulty d)
+    {
+        Settings s;
+        s.difficulty = d;
+        return { s.blocksPerTurn(), s.turnLimit(), d != Difficulty::Easy };
+    }
+
+    const char* difficultyName(int d)
+    {
+        switch (d) { case 0: return "Easy"; case 1: return "Normal"; default: return "Hard"; }
+    }
+
+    // xorshift64*: tiny state, no allocation, plenty for picking keys
+    struct Rng {
+        std::uint64_t s;
+        explicit Rng(std::uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ull + 1) {}
+        std::uint32_t next()
+        {
+            s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+            return (std::uint32_t)((s * 0x2545F4914F6CDD1Dull) >> 32);
+        }
+        int below(int n) { return (int)(next() % (std::uint32_t)n); }
+    };
+
+    // everything needed to replay one level attempt from its start
+    struct Run {
+        int level = 0;
+        int difficulty = 0;
+        int turns = 0;
+        std::array<TurnPlan, MaxTurns> plans;
+    };
+
+    struct Failure {
+        char what[160] = {};
+        int turn = 0;
+    };
+
+    // the ghost path: walk the plan from `start` until the first blocked cell
+    sf::Vector2i ghostEnd(const Playthrough& sim, const TurnPlan& p, sf::Vector2i start, bool& blocked)
+    {
+        sf::Vector2i c = start;
+        blocked = false;
+        for (Direction d : p.moves) {
+            c = sim.step(c, d);
+            if (sim.grid().isBlocked(c) || p.hasBlock(c)) { blocked = true; break; }
+        }
+        return c;
+    }
+
+    // random key presses with the same rules as Game::handleInputPlaying: arrows append moves,
+    // B drops a block where the ghost path ends (never on the player) and eats the move before it
+    void randomPlan(const Playthrough& sim, Rng& rng, TurnPlan& p)
+    {
+        p.clear();
+        sf::Vector2i start = sim.player().gridPos;
+        int blocksLeft = sim.rules().blocksPerTurn;
+        bool lastWasMove = false;
+
+        int actions = rng.below(MaxActions + 1);
+        for (int a = 0; a < actions; ++a) {
+            if (blocksLeft > 0 && rng.below(6) == 0) {
+                bool blocked;
+                sf::Vector2i end = ghostEnd(sim, p, start, blocked);
+                if (blocked || end == start || sim.grid().isBlocked(end) || p.hasBlock(end)) continue;
+                p.blocks.push_back(end);
+                --blocksLeft;
+                if (lastWasMove) p.moves.popBack();
+                lastWasMove = false;
+            } else {
+                if (!p.moves.push((Direction)rng.below(4))) break;
+                lastWasMove = true;
+            }
+        }
+    }
+
+    // what a player could have entered at the start of this turn (used when replaying shrunk plans)
+    bool isLegal(const Playthrough& sim, const TurnPlan& p)
+    {
+        if ((int)p.blocks.size() > sim.rules().blocksPerTurn) return false;
+        for (size_t i = 0; i < p.blocks.size(); ++i) {
+            sf::Vector2i c = p.blocks[i];
+            if (c == sim.player().gridPos || sim.grid().isBlocked(c)) return false;
+            for (size_t j = 0; j < i; ++j)
+                if (p.blocks[j] == c) return false;
+        }
+        return true;
+    }
+
+    // ---------------- Invariants ----------------
+
+    struct Checker {
+        int chests;
+        int turns;
+        std::vector<char> solid;   // scratch, per board cell: stops a shot (worked out here, not by the grid)
+        std::vector<char> reach;   // scratch, per board cell: a beam could get here
+        Failure* fail;
+
+        static int chestsLeft(const GridState& g)
+        {
+            int n = 0;
+            for (const Item& it : g.getItems()) n += it.collected ? 0 : 1;
+            return n;
+        }
+
+        void start(const Playthrough& sim, Failure* f)
+        {
+            chests = chestsLeft(sim.grid());
+            turns = sim.turnsRemaining();
+            fail = f;
+        }
+
+        bool operator()(const Playthrough& sim, TurnOutcome o)
+        {
+            const GridState& g = sim.grid();
+            const LevelData& L = *g.getLevel();
+            sf::Vector2i player = sim.player().gridPos;
+
+            if (g.isBlocked(player))
+                return report("player inside a blocked cell (%d,%d)", player.x, player.y);
+
+            // a death restores the level, the only time chests come back
+            int left = chestsLeft(g);
+            bool restored = (o == TurnOutcome::Died || o == TurnOutcome::Failed)
+                         && player == sf::Vector2i{L.originX, L.height - 1} && left == (int)L.items.size();
+            if (left > chests && !restored)
+                return report("chest count went up %d -> %d", chests, left);
+            if (sim.turnsRemaining() > turns)
+                return report("turn counter went up %d -> %d", turns, sim.turnsRemaining());
+
+            // every beam cell must be reachable from a laser without crossing an obstacle. The
+            // obstacles come from the raw tiles, chests and blocks rather than the grid's own
+            // shot test, so a bug there can't hide itself.
+            auto index = [&](sf::Vector2i c) { return (size_t)c.y * L.width + (c.x - L.originX); };
+            solid.assign((size_t)L.width * L.height, 0);
+            for (int y = 0; y < L.height; ++y)
+                for (int x = L.originX; x < L.originX + L.width; ++x) {
+                    char t = L.tile(x, y);
+                    solid[index({x, y})] = t == 'T' || t == '~';
+                }
+            for (const Item& it : g.getItems())
+                if (!it.collected) solid[index(it.gridPos)] = 1;
+            for (sf::Vector2i b : g.getBlocks()) solid[index(b)] = 1;
+
+            reach.assign(solid.size(), 0);
+            for (const Hazard& h : L.hazards) {
+                if (!h.info().laser) continue;
+                for (sf::Vector2i c = h.pos + h.info().dir; L.inBounds(c) && !solid[index(c)]; c += h.info().dir)
+                    reach[index(c)] = 1;
+            }
+            for (int y = 0; y < L.height; ++y)
+                for (int x = L.originX; x < L.originX + L.width; ++x)
+                    if (g.cellHasBeam({x, y}) && !reach[index({x, y})])
+                        return report("beam crosses an obstacle at (%d,%d)", x, y);
+
+            chests = left;
+            turns = sim.turnsRemaining();
+            return true;
+        }
+
+        bool report(const char* fmt, int a, int b)
+        {
+            std::snprintf(fail->what, sizeof(fail->what), fmt, a, b);
+            return false;
+        }
+    };
+
+    // replays a recorded run from the level start; true if it breaks an invariant
+    bool reproduces(const GridState& level, const Run& run, Failure& fail)
+    {
+        Playthrough sim;
+        sim.start(level, rulesFor(Difficulties[run.difficulty]));
+        Checker check;
+        check.start(sim, &fail);
+
+        for (int t = 0; t < run.turns; ++t) {
+            if (!isLegal(sim, run.plans[t])) return false;
+            TurnOutcome o = sim.runTurn(run.plans[t], check);
+            if (fail.what[0]) { fail.turn = t; return true; }
+            if (o == TurnOutcome::Completed || o == TurnOutcome::Failed) return false;
+        }
+        return false;
+    }
+
+    // greedy shrink: drop whole turns, then single blocks, then move pairs / single moves, while it still fails
+    void shrink(const GridState& level, Run& run, Failure& fail)
+    {
+        auto tryRun = [&](const Run& candidate) {
+            Failure f;
+            if (!reproduces(level, candidate, f)) return false;
+            run = candidate;
+            fail = f;
+            return true;
+        };
+
+        run.turns = fail.turn + 1;
+        bool progress = true;
+        while (progress) {
+            progress = false;
+
+            for (int t = 0; t < run.turns; ++t) {
+                Run c = run;
+                for (int k = t; k + 1 < c.turns; ++k) c.plans[k] = c.plans[k + 1];
+                --c.turns;
+                if (c.turns > 0 && tryRun(c)) { progress = true; --t; }
+            }
+
+            for (int t = 0; t < run.turns; ++t) {
+                for (int b = 0; b < (int)run.plans[t].blocks.size(); ++b) {
+                    Run c = run;
+                    std::vector<sf::Vector2i>& blocks = c.plans[t].blocks;
+                    blocks.erase(blocks.begin() + b);
+                    if (tryRun(c)) { progress = true; --b; }
+                }
+
+                // pairs first so a step and its way back can go together
+                for (int len = 2; len >= 1; --len) {
+                    for (int m = 0; m + len <= run.plans[t].moves.size(); ++m) {
+                        Run c = run;
+                        const MovePlan& from = run.plans[t].moves;
+                        MovePlan& to = c.plans[t].moves;
+                        to.clear();
+                        for (int k = 0; k < from.size(); ++k)
+                            if (k < m || k >= m + len) to.push(from[k]);
+                        if (tryRun(c)) { progress = true; --m; }
+                    }
+                }
+            }
+        }
+    }
+
+    void writeRepro(int levelNumber, const Run& run, const Failure& fail, std::ostream& out)
+    {
+        static const char* dirNames[] = { "Up", "Down", "Left", "Right" };
+
+        out << "violation: " << fail.what << "\n";
+        out << "level " << levelNumber << ", " << difficultyName(run.difficulty)
+            << ", fails in turn " << (fail.turn + 1) << "\n";
+        for (int t = 0; t < run.turns; ++t) {
+            const TurnPlan& p = run.plans[t];
+            out << "turn " << (t + 1) << ":";
+            for (sf::Vector2i b : p.blocks) out << " block(" << b.x << "," << b.y << ")";
+            for (Direction d : p.moves) out << " " << dirNames[(int)d];
+            out << "\n";
+        }
+    }
+}
+
+namespace {
+    // the ghost path cache across a turn that ends where it started (Up, Down): the next turn's
+    // plan of the same length must not be drawn from the old one. Plans are kept in sync the way
+    // Game::planMove does it. True if the cached path matches a fresh one.
+    bool ghostPathFollowsNewPlan(const GridState& g)
+    {
+        sf::IntRect b = g.getBounds();
+        auto free = [&](sf::Vector2i p) { return b.contains(p) && !g.isBlocked(p); };
+        sf::Vector2i start{-1, -1};
+        for (int y = b.position.y; y < b.position.y + b.size.y && start.x < 0; ++y)
+            for (int x = b.position.x; x < b.position.x + b.size.x; ++x)
+                if (free({x, y}) && free({x, y - 1}) && free({x + 1, y}) && free({x + 2, y})) { start = {x, y}; break; }
+        if (start.x < 0) return true;   // no room for the sequence on this level
+
+        MovePlan plan;
+        GhostPath path;
+        auto planMove = [&](Direction d) {
+            bool cached = path.isValidFor(g, start, plan);
+            plan.push(d);
+            if (cached) path.append(g, plan);
+        };
+
+        path.rebuild(g, start, plan);
+        planMove(Direction::Up);
+        planMove(Direction::Down);
+        while (!plan.empty()) plan.popFront();   // executed, back on the start cell
+
+        planMove(Direction::Right);
+        planMove(Direction::Right);
+        if (!path.isValidFor(g, start, plan)) path.rebuild(g, start, plan);
+
+        GhostPath fresh;
+        fresh.rebuild(g, start, plan);
+        if (path.cellCount() != fresh.cellCount()) return false;
+        for (int i = 0; i < fresh.cellCount(); ++i)
+            if (path.cell(i) != fresh.cell(i)) return false;
+        return true;
+    }
+}
+
+int runStress(const StressOptions& opts)
+{
+    // every campaign level loaded once; the workers only ever copy these (sharing their parts)
+    const auto layouts = loadCampaignLevels();
+    std::vector<GridState> levels(layouts.size());
+    for (size_t i = 0; i < layouts.size(); ++i) levels[i].loadLevel(GridState::parseLevel(layouts[i]));
+    if (levels.empty()) return 2;
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (!ghostPathFollowsNewPlan(levels[i])) {
+            std::cerr << "[stress] level " << (i + 1) << ": ghost path still shows the previous turn's plan\n";
+            return 1;
+        }
+    }
+
+    JobSystem& jobs = JobSystem::instance();
+    int lanes = jobs.workerCount() + 1;   // every worker plus this thread (wait() helps)
+    std::cout << "[stress] " << levels.size() << " levels, " << lanes << " threads, "
+              << opts.seconds << " s, seed " << opts.seed << "\n";
+
+    using Clock = std::chrono::steady_clock;
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opts.seconds));
+
+    std::atomic<bool> stop{false};
+    std::atomic<std::uint64_t> totalPlans{0}, totalRuns{0};
+    std::mutex firstMtx;
+    bool found = false;
+    Run firstRun;
+    Failure firstFail;
+
+    AllocTracker::Snapshot before;
+    AllocTracker::snapshot(before);
+    auto t0 = Clock::now();
+
+    auto group = jobs.makeGroup();
+    for (int lane = 0; lane < lanes; ++lane) {
+        jobs.submit([&, lane] {
+            // all state lives here and is reused from run to run: once the first runs have sized
+            // the buffers (and the grid's copy-on-write pools), nothing below allocates
+            Rng rng(((std::uint64_t)opts.seed << 16) ^ (std::uint64_t)lane);
+            Run run;
+            Failure fail;
+            Checker check;
+            Playthrough sim;
+            std::uint64_t plans = 0, runs = 0;
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int r = 0; r < CheckEvery && !stop.load(std::memory_order_relaxed); ++r) {
+                    run.level = rng.below((int)levels.size());
+                    run.difficulty = rng.below(3);
+                    run.turns = 0;
+
+                    sim.start(levels[run.level], rulesFor(Difficulties[run.difficulty]));
+                    fail.what[0] = 0;
+                    check.start(sim, &fail);
+
+                    for (int t = 0; t < MaxTurns; ++t) {
+                        randomPlan(sim, rng, run.plans[t]);
+                        run.turns = t + 1;
+                        TurnOutcome o = sim.runTurn(run.plans[t], check);
+                        ++plans;
+
+                        if (fail.what[0]) {
+                            fail.turn = t;
+                            std::lock_guard<std::mutex> lock(firstMtx);
+                            if (!found) { found = true; firstRun = run; firstFail = fail; }
+                            stop.store(true, std::memory_order_relaxed);
+                            break;
+                        }
+                        if (o == TurnOutcome::Completed || o == TurnOutcome::Failed) break;
+                    }
+                    ++runs;
+                }
+                if (Clock::now() >= deadline) stop.store(true, std::memory_order_relaxed);
+            }
+
+            totalPlans.fetch_add(plans, std::memory_order_relaxed);
+            totalRuns.fetch_add(runs, std::memory_order_relaxed);
+        }, group);
+    }
+    jobs.wait(*group);
+
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    std::uint64_t plans = totalPlans.load();
+    std::cout << "[stress] " << plans << " plans in " << totalRuns.load() << " runs, "
+              << (std::uint64_t)(plans / (secs > 0.0 ? secs : 1.0) * 60.0) << " plans/min\n";
+
+    if (AllocTracker::Enabled) {
+        AllocTracker::Snapshot after;
+        AllocTracker::snapshot(after);
+        std::uint64_t allocs = 0;
+        for (int i = 0; i < AllocTracker::MaxSubsystems; ++i)
+            allocs += after.perSubsystem[i].allocs - before.perSubsystem[i].allocs;
+        std::cout << "[stress] allocations during the run: " << allocs << "\n";
+    }
+
+    if (!found) {
+        std::cout << "[stress] no invariant violations\n";
+        return 0;
+    }
+
+    shrink(levels[firstRun.level], firstRun, firstFail);
+
+    std::ofstream file("stress_repro.txt");
+    writeRepro(firstRun.level + 1, firstRun, firstFail, file);
+    std::cerr << "[stress] INVARIANT VIOLATION (minimal plan in stress_repro.txt)\n";
+    writeRepro(firstRun.level + 1, firstRun, firstFail, std::cerr);
+    return 1;
+}
+
+namespace {
+    // copy-on-write: after a snapshot, a run of writes clones each part (items, blocks, beams)
+    // once and then writes in place. Returns the clones past that.
+    unsigned extraCowCopies(const GridState& level)
+    {
+        const int Writes = 300;
+        GridState g = level;
+        sf::IntRect b = g.getBounds();
+        sf::Vector2i free{-1, -1};
+        for (int y = 0; y < b.size.y && free.x < 0; ++y)
+            for (int x = b.position.x; x < b.position.x + b.size.x; ++x)
+                if (!g.isBlocked({x, y}) && !g.hasBlockAt({x, y})) { free = {x, y}; break; }
+
+        unsigned extra = 0;
+        GridState::Snapshot held;
+        for (int round = 0; round < 3; ++round) {
+            held = g.snapshot();   // the previous one goes back to the pool
+            unsigned before = g.cowCopies();
+            for (int i = 0; i < Writes; ++i) {
+                if (i % 3 == 0 && free.x >= 0) g.placeBlock(free);
+                else if (i % 3 == 1 && free.x >= 0) g.removeBlock(free);
+                else g.stepHazards();
+                if (i < (int)g.getItems().size()) g.checkItemAt(g.getItems()[i].gridPos);
+            }
+            unsigned made = g.cowCopies() - before;
+            if (made > 3) extra += made - 3;
+        }
+        return extra;
+    }
+}
+
+int runAllocCheck(const AllocCheckOptions& opts)
+{
+    const auto layouts = loadCampaignLevels();
+    std::vector<GridState> levels(layouts.size());
+    for (size_t i = 0; i < layouts.size(); ++i) levels[i].loadLevel(GridState::parseLevel(layouts[i]));
+    if (levels.empty()) return 2;
+
+    unsigned extraCopies = 0;
+    for (const GridState& level : levels) extraCopies += extraCowCopies(level);
+    std::cout << "[alloc-check] copy-on-write: " << extraCopies << " clones past the first write after a snapshot\n";
+    if (extraCopies > 0) {
+        std::cerr << "[alloc-check] FAILED: writes after a snapshot keep cloning whole parts\n";
+        return 1;
+    }
+
+    if (!AllocTracker::Enabled) {
+        std::cerr << "[alloc-check] this build doesn't count allocations (build with -DTRACK_ALLOCS)\n";
+        return 2;
+    }
+
+    Playthrough sim;
+    Run run;
+    auto always = [](const Playthrough&, TurnOutcome) { return true; };
+    std::uint64_t ticks = 0;
+    auto count = [&ticks](const Playthrough&, TurnOutcome) { ++ticks; return true; };
+
+    // every level and difficulty in turn, random plans from the same seed each pass
+    auto pass = [&](auto&& onTick) {
+        Rng rng(opts.seed);
+        for (int r = 0; r < opts.runs; ++r) {
+            run.level = r % (int)levels.size();
+            run.difficulty = (r / (int)levels.size()) % 3;
+            sim.start(levels[run.level], rulesFor(Difficulties[run.difficulty]));
+            for (int t = 0; t < MaxTurns; ++t) {
+                randomPlan(sim, rng, run.plans[t]);
+                TurnOutcome o = sim.runTurn(run.plans[t], onTick);
+                if (o == TurnOutcome::Completed || o == TurnOutcome::Failed) break;
+            }
+        }
+    };
+
+    pass(always);
+
+    AllocTracker::Snapshot before, after;
+    AllocTracker::snapshot(before);
+    pass(count);
+    AllocTracker::snapshot(after);
+
+    std::uint64_t allocs = 0, bytes = 0;
+    for (int i = 0; i < AllocTracker::MaxSubsystems; ++i) {
+        allocs += after.perSubsystem[i].allocs - before.perSubsystem[i].allocs;
+        bytes += after.perSubsystem[i].bytes - before.perSubsystem[i].bytes;
+    }
+    std::cout << "[alloc-check] " << opts.runs << " runs, " << ticks << " ticks after warm-up: "
+              << allocs << " allocations (" << bytes << " bytes)\n";
+    if (allocs == 0) return 0;
+    std::cerr << "[alloc-check] FAILED: the rules allocate in steady state\n";
+    return 1;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+
+// Headless stress mode (`10_Seconds_Ahead --stress [seconds] [--seed N]`): plays random legal
+// plans against every campaign level on all cores and checks the rule invariants after every
+// tick. The first violation is shrunk to a minimal plan and written to stress_repro.txt. Before
+// that, each level checks that the ghost path cache follows a new plan of the same length.
+struct StressOptions {
+    double seconds = 60.0;
+    std::uint32_t seed = 1;
+};
+
+// returns the process exit code: 0 = no violation, 1 = violation found, 2 = setup error
+int runStress(const StressOptions& opts);
+
+// Allocation check (`10_Seconds_Ahead --alloc-check [runs] [--seed N]`, needs a -DTRACK_ALLOCS
+// build): plays the same seeded runs on every campaign level twice on this thread. The first pass
+// sizes every buffer the rules use; the second plays exactly the same ticks and must not allocate.
+// Before that, each level checks that writes after a snapshot clone a copy-on-write part once.
+struct AllocCheckOptions {
+    int runs = 90;
+    std::uint32_t seed = 1;
+};
+
+// returns the process exit code: 0 = no steady-state allocations / extra clones, 1 = some, 2 = setup error
+int runAllocCheck(const AllocCheckOptions& opts);
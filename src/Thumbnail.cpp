@@ -0,0 +1,313 @@
+#include "Thumbnail.h"
+#include "Levels.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+// ---------------- Renderer ----------------
+
+bool ThumbnailRenderer::load(sf::Vector2u maxSize, const std::string& assetDir)
+{
+    TRACE_SCOPE("ThumbnailRenderer::load");
+    // the same art Grid::load uses for these tiles
+    const char* files[TileCount] = {"Grass.png", "Tree.png", "Water.png", "Chest.png"};
+    for (int t = 0; t < (int)HazardType::Count; ++t) files[FirstHazard + t] = hazardInfo((HazardType)t).texture;
+
+    // a cell is at most the whole thumbnail (a 1x1 level)
+    unsigned maxCellPx = std::max(1u, std::max(maxSize.x, maxSize.y));
+
+    // decode + mip build in parallel (the grass image alone is 4k x 4k)
+    JobSystem& jobs = JobSystem::instance();
+    auto group = jobs.makeGroup();
+    for (int t = 0; t < TileCount; ++t)
+        jobs.submit([this, t, &files, &assetDir, maxCellPx]{
+            sf::Image img;
+            if (img.loadFromFile(assetDir + "/" + files[t])) tiles[t] = buildMips(img, maxCellPx);
+        }, group);
+    jobs.wait(*group);
+
+    bool ok = true;
+    for (int t = 0; t < TileCount; ++t)
+        if (tiles[t].empty()) {
+            std::cerr << "Error loading " << files[t] << " (thumbnails)\n";
+            ok = false;
+        }
+    return ok;
+}
+
+std::vector<ThumbnailRenderer::Mip> ThumbnailRenderer::buildMips(const sf::Image& img, unsigned maxCellPx)
+{
+    std::vector<Mip> mips;
+    sf::Vector2u s = img.getSize();
+    const std::uint8_t* src = img.getPixelsPtr();
+    if (!src || s.x == 0 || s.y == 0) return mips;
+
+    Mip top;
+    top.w = s.x;
+    top.h = s.y;
+    top.rgba.assign(src, src + (size_t)s.x * s.y * 4);
+    for (size_t i = 0; i < top.rgba.size(); i += 4) {
+        unsigned a = top.rgba[i + 3];
+        for (int c = 0; c < 3; ++c) top.rgba[i + c] = (std::uint8_t)((top.rgba[i + c] * a + 127) / 255);
+    }
+
+    // levels whose next one still covers the biggest cell are never sampled (see mipFor):
+    // only the current one is alive while halving past them
+    while (top.w / 2 >= maxCellPx && top.h / 2 >= maxCellPx) top = halve(top);
+    mips.push_back(std::move(top));
+
+    while (mips.back().w > 1 || mips.back().h > 1) {
+        Mip small = halve(mips.back());
+        mips.push_back(std::move(small));
+    }
+    return mips;
+}
+
+ThumbnailRenderer::Mip ThumbnailRenderer::halve(const Mip& big)
+{
+    // 2x2 box filter (an odd last row / column is dropped)
+    Mip small;
+    small.w = std::max(1u, big.w / 2);
+    small.h = std::max(1u, big.h / 2);
+    small.rgba.resize((size_t)small.w * small.h * 4);
+
+    for (unsigned y = 0; y < small.h; ++y)
+        for (unsigned x = 0; x < small.w; ++x) {
+            unsigned x0 = std::min(2 * x, big.w - 1), x1 = std::min(2 * x + 1, big.w - 1);
+            unsigned y0 = std::min(2 * y, big.h - 1), y1 = std::min(2 * y + 1, big.h - 1);
+            const std::uint8_t* a = &big.rgba[((size_t)y0 * big.w + x0) * 4];
+            const std::uint8_t* b = &big.rgba[((size_t)y0 * big.w + x1) * 4];
+            const std::uint8_t* c = &big.rgba[((size_t)y1 * big.w + x0) * 4];
+            const std::uint8_t* d = &big.rgba[((size_t)y1 * big.w + x1) * 4];
+            std::uint8_t* out = &small.rgba[((size_t)y * small.w + x) * 4];
+            for (int k = 0; k < 4; ++k) out[k] = (std::uint8_t)((a[k] + b[k] + c[k] + d[k] + 2) / 4);
+        }
+    return small;
+}
+
+const ThumbnailRenderer::Mip* ThumbnailRenderer::mipFor(Tile t, float cellPx) const
+{
+    const std::vector<Mip>& chain = tiles[t];
+    if (chain.empty()) return nullptr;
+
+    // smallest level still at least a cell across: sampling it shrinks by less than 2x
+    const Mip* best = &chain.front();
+    for (const Mip& m : chain) {
+        if (m.w < cellPx || m.h < cellPx) break;
+        best = &m;
+    }
+    return best;
+}
+
+sf::Image ThumbnailRenderer::render(const LevelData& L, sf::Vector2u size) const
+{
+    TRACE_SCOPE("ThumbnailRenderer::render");
+    // letterbox in the window's clear colour
+    std::vector<std::uint8_t> px((size_t)size.x * size.y * 4);
+    for (size_t i = 0; i < px.size(); i += 4) {
+        px[i] = 167; px[i + 1] = 216; px[i + 2] = 255; px[i + 3] = 255;
+    }
+    if (L.width <= 0 || L.height <= 0 || size.x == 0 || size.y == 0) return sf::Image(size, px.data());
+
+    // what goes over the grass in each cell
+    std::vector<std::uint8_t> overlay((size_t)L.width * L.height, TileCount);
+    for (int y = 0; y < L.height; ++y)
+        for (int x = 0; x < L.width; ++x) {
+            char c = L.tile(L.originX + x, y);
+            std::uint8_t& o = overlay[(size_t)y * L.width + x];
+            if (c == 'T') o = Tree;
+            else if (c == '~') o = Water;
+            else if (c == 'I') o = Chest;
+        }
+    for (const Hazard& h : L.hazards)
+        overlay[(size_t)h.pos.y * L.width + (h.pos.x - L.originX)] = (std::uint8_t)(FirstHazard + (int)h.type);
+
+    float cell = std::min((float)size.x / L.width, (float)size.y / L.height);
+    float ox = (size.x - cell * L.width) / 2.f;
+    float oy = (size.y - cell * L.height) / 2.f;
+
+    std::array<const Mip*, TileCount> mips;
+    for (int t = 0; t < TileCount; ++t) mips[t] = mipFor((Tile)t, cell);
+
+    auto texel = [](const Mip& m, float u, float v) {
+        unsigned tx = std::min((unsigned)(u * m.w), m.w - 1);
+        unsigned ty = std::min((unsigned)(v * m.h), m.h - 1);
+        return &m.rgba[((size_t)ty * m.w + tx) * 4];
+    };
+
+    // per output pixel: the cell under its centre, grass then that cell's overlay ("over",
+    // premultiplied; the result stays opaque). Works the same when a cell is under a pixel.
+    unsigned px0 = (unsigned)std::floor(ox), px1 = std::min(size.x, (unsigned)std::ceil(ox + cell * L.width));
+    unsigned py0 = (unsigned)std::floor(oy), py1 = std::min(size.y, (unsigned)std::ceil(oy + cell * L.height));
+    for (unsigned y = py0; y < py1; ++y) {
+        float fy = (y + 0.5f - oy) / cell;
+        if (fy < 0.f || fy >= (float)L.height) continue;
+        int cy = std::min((int)fy, L.height - 1);
+        float v = fy - cy;
+
+        for (unsigned x = px0; x < px1; ++x) {
+            float fx = (x + 0.5f - ox) / cell;
+            if (fx < 0.f || fx >= (float)L.width) continue;
+            int cx = std::min((int)fx, L.width - 1);
+            float u = fx - cx;
+
+            std::uint8_t* out = &px[((size_t)y * size.x + x) * 4];
+            if (mips[Grass]) {
+                const std::uint8_t* g = texel(*mips[Grass], u, v);
+                out[0] = g[0]; out[1] = g[1]; out[2] = g[2];
+            }
+            std::uint8_t o = overlay[(size_t)cy * L.width + cx];
+            if (o == TileCount || !mips[o]) continue;
+            const std::uint8_t* s = texel(*mips[o], u, v);
+            unsigned inv = 255 - s[3];
+            for (int c = 0; c < 3; ++c) out[c] = (std::uint8_t)(s[c] + (out[c] * inv + 127) / 255);
+        }
+    }
+    return sf::Image(size, px.data());
+}
+
+// ---------------- Cache (level select) ----------------
+
+ThumbnailCache::ThumbnailCache(sf::Vector2u size, std::size_t capacity)
+: size(size), capacity(capacity), jobs(JobSystem::instance().makeGroup())
+{
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    // the jobs use the renderer and write into `finished`
+    jobs->cancel();
+    JobSystem::instance().wait(*jobs);
+}
+
+const sf::Texture* ThumbnailCache::get(const std::shared_ptr<const LevelData>& level)
+{
+    if (!level) return nullptr;
+    auto [it, added] = entries.try_emplace(level.get());
+    Entry& e = it->second;
+    e.lastUsed = ++useCounter;
+    if (!added) return e.ready ? &e.texture : nullptr;
+
+    e.level = level;
+    JobSystem::instance().submit([this, level]{
+        TRACE_SCOPE("ThumbnailCache::render");
+        std::call_once(loadOnce, [this]{ renderer.load(size); });
+        sf::Image img = renderer.render(*level, size);
+        std::lock_guard<std::mutex> lock(mtx);
+        finished.emplace_back(level.get(), std::move(img));
+    }, jobs);
+    return nullptr;
+}
+
+void ThumbnailCache::poll()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (finished.empty()) return;
+        uploads.swap(finished);
+    }
+
+    for (auto& [key, img] : uploads) {
+        auto it = entries.find(key);
+        if (it == entries.end()) continue;
+        if (it->second.texture.loadFromImage(img)) {
+            it->second.texture.setSmooth(true);
+            it->second.ready = true;
+        }
+        else std::cerr << "Error: level thumbnail upload failed\n";
+    }
+    uploads.clear();
+    evict();
+}
+
+void ThumbnailCache::evict()
+{
+    // least recently shown first; ones still rendering stay (their job reports back by key)
+    while (entries.size() > capacity) {
+        auto oldest = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.ready && (oldest == entries.end() || it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+        if (oldest == entries.end()) return;
+        entries.erase(oldest);
+    }
+}
+
+// ---------------- Headless batch ----------------
+
+int runThumbnails(const ThumbnailOptions& opts)
+{
+    namespace fs = std::filesystem;
+    if (opts.size == 0 || opts.size > 8192) {
+        std::cerr << "[thumbnails] size must be 1..8192\n";
+        return 2;
+    }
+
+    // name -> layout to render (files are read on the workers, so a big pack streams through)
+    struct Work {
+        std::string name;
+        std::string path;
+        std::vector<std::string> layout;
+    };
+    std::vector<Work> work;
+    if (opts.inputs.empty()) {
+        std::vector<std::vector<std::string>> levels = loadCampaignLevels();
+        for (size_t i = 0; i < levels.size(); ++i)
+            work.push_back({"level" + std::to_string(i + 1), "", std::move(levels[i])});
+    }
+    for (const std::string& in : opts.inputs) {
+        std::error_code ec;
+        if (fs::is_directory(in, ec)) {
+            std::vector<fs::path> files;
+            for (const fs::directory_entry& e : fs::directory_iterator(in, ec))
+                if (e.is_regular_file(ec) && e.path().extension() == ".txt") files.push_back(e.path());
+            std::sort(files.begin(), files.end());
+            for (const fs::path& f : files) work.push_back({f.stem().string(), f.string(), {}});
+        }
+        else work.push_back({fs::path(in).stem().string(), in, {}});
+    }
+    if (work.empty()) {
+        std::cerr << "[thumbnails] no levels to render\n";
+        return 2;
+    }
+
+    std::error_code ec;
+    fs::create_directories(opts.outDir, ec);
+    if (ec) {
+        std::cerr << "[thumbnails] can't create " << opts.outDir << ": " << ec.message() << "\n";
+        return 2;
+    }
+
+    ThumbnailRenderer renderer;
+    if (!renderer.load({opts.size, opts.size})) return 2;
+
+    JobSystem& jobs = JobSystem::instance();
+    auto group = jobs.makeGroup();
+    std::atomic<int> failed{0};
+    std::mutex logMtx;
+    auto fail = [&](const Work& w, const char* what) {
+        failed.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(logMtx);
+        std::cerr << "[thumbnails] " << (w.path.empty() ? w.name : w.path) << ": " << what << "\n";
+    };
+
+    for (Work& w : work)
+        jobs.submit([&, wp = &w]{
+            TRACE_SCOPE("runThumbnails::job");
+            Work& job = *wp;
+            if (job.layout.empty() && !readLevelFile(job.path, job.layout)) { fail(job, "can't read level"); return; }
+            auto level = Grid::parseLevel(job.layout);
+            job.layout = {};
+            sf::Image img = renderer.render(*level, {opts.size, opts.size});
+            if (!img.saveToFile(fs::path(opts.outDir) / (job.name + ".png"))) fail(job, "can't write png");
+        }, group);
+    jobs.wait(*group);
+
+    int bad = failed.load();
+    std::cout << "[thumbnails] " << (work.size() - bad) << " / " << work.size() << " levels written to "
+              << opts.outDir << "\n";
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Grid.h"
+#include "JobSystem.h"
+
+// ThumbnailRenderer: level previews composited on the CPU straight from the assets/ tile
+// images (sf::Image only: no window, no GL context), so it runs on JobSystem workers and on
+// headless build boxes. Tiles stack like Grid::draw at level start: grass, then trees / water /
+// chests, then hazard bases (lasers start at zero length, so no beams).
+//
+// Each tile is kept as a box-filtered mip chain (premultiplied alpha), and a cell samples the
+// smallest level that still covers it, so tiny thumbnails of 1024 px art don't shimmer. Levels
+// bigger than any cell can be (the largest thumbnail asked for) are never kept: a 4k tile costs
+// a few hundred KB instead of ~90 MB.
+class ThumbnailRenderer {
+public:
+    // decode the tile PNGs and build their mips for thumbnails up to maxSize; false (reported on
+    // std::cerr) if any failed
+    bool load(sf::Vector2u maxSize, const std::string& assetDir = "assets");
+
+    // `level` at its start, letterboxed into a size.x * size.y image (cells stay square). Sizes
+    // past load's maxSize work but are upscaled. Only reads the renderer, so any number of
+    // threads can call it at once.
+    sf::Image render(const LevelData& level, sf::Vector2u size) const;
+
+private:
+    // then one per HazardType, in its order
+    enum Tile { Grass, Tree, Water, Chest, FirstHazard, TileCount = FirstHazard + (int)HazardType::Count };
+
+    struct Mip {
+        unsigned w = 0;
+        unsigned h = 0;
+        std::vector<std::uint8_t> rgba;   // premultiplied
+    };
+
+    static std::vector<Mip> buildMips(const sf::Image& img, unsigned maxCellPx);
+    static Mip halve(const Mip& big);
+    const Mip* mipFor(Tile t, float cellPx) const;
+
+    std::array<std::vector<Mip>, TileCount> tiles;   // largest kept level first, halving down to 1x1
+};
+
+// ThumbnailCache: level select thumbnails. A level is rendered on a worker the first time it
+// is asked for, then kept as a texture; past `capacity` the least recently shown ones go.
+// Keyed by the parsed level, so an edited level file gets a fresh thumbnail. Window thread
+// only (the textures need its GL context); the tile images are loaded by the first job.
+class ThumbnailCache {
+public:
+    explicit ThumbnailCache(sf::Vector2u size, std::size_t capacity = 64);
+    ~ThumbnailCache();
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    // the thumbnail if it's ready, otherwise queue it (once) and return nullptr
+    const sf::Texture* get(const std::shared_ptr<const LevelData>& level);
+
+    // turn finished renders into textures (once per frame)
+    void poll();
+
+    sf::Vector2u getSize() const { return size; }
+
+private:
+    struct Entry {
+        std::shared_ptr<const LevelData> level;   // keeps the key alive
+        sf::Texture texture;
+        bool ready = false;
+        std::uint64_t lastUsed = 0;
+    };
+
+    void evict();
+
+    sf::Vector2u size;
+    std::size_t capacity;
+
+    ThumbnailRenderer renderer;
+    std::once_flag loadOnce;
+
+    std::unordered_map<const LevelData*, Entry> entries;
+    std::uint64_t useCounter = 0;
+
+    std::shared_ptr<TaskGroup> jobs;
+    std::mutex mtx;
+    std::vector<std::pair<const LevelData*, sf::Image>> finished;   // written by the jobs
+    std::vector<std::pair<const LevelData*, sf::Image>> uploads;    // poll() scratch
+};
+
+// Headless batch mode (`10_Seconds_Ahead --thumbnails <outDir> [--size N] [files / dirs...]`):
+// writes <outDir>/<level name>.png for every level file given (directories: every .txt in
+// them), or for the campaign levels if none are, rendering them in parallel.
+struct ThumbnailOptions {
+    std::string outDir = "thumbnails";
+    unsigned size = 256;
+    std::vector<std::string> inputs;
+};
+
+// returns the process exit code: 0 = all written, 1 = some levels failed, 2 = setup error
+int runThumbnails(const ThumbnailOptions& opts);
@@ -0,0 +1,337 @@
+#include "TickHistory.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    sf::Vector2i delta(Direction d)
+    {
+        switch (d) {
+            case Direction::Up:    return {0, -1};
+            case Direction::Down:  return {0, 1};
+            case Direction::Left:  return {-1, 0};
+            default:               return {1, 0};
+        }
+    }
+
+    Direction directionOf(sf::Vector2i v)
+    {
+        if (v.y < 0) return Direction::Up;
+        if (v.y > 0) return Direction::Down;
+        if (v.x < 0) return Direction::Left;
+        return Direction::Right;
+    }
+
+    void put16(std::vector<std::uint8_t>& out, std::uint16_t v)
+    {
+        out.push_back((std::uint8_t)(v & 0xFF));
+        out.push_back((std::uint8_t)(v >> 8));
+    }
+
+    void putBall(std::vector<std::uint8_t>& out, const Projectile& b)
+    {
+        put16(out, (std::uint16_t)(std::int16_t)b.pos.x);
+        put16(out, (std::uint16_t)(std::int16_t)b.pos.y);
+        out.push_back((std::uint8_t)directionOf(b.dir));
+    }
+}
+
+// ---------------- Recording ----------------
+
+void TickHistory::begin(const GridState& grid, const PlayerState& player)
+{
+    head = 0;
+    used = 0;
+    ticks = 0;
+    dropped = 0;
+    base = grid;   // shares the grid's parts until either side writes
+    basePlayer = player;
+    pending.reset();
+    pendingMs = 0.f;
+    committedMs = 0.f;
+    active = true;
+}
+
+void TickHistory::end()
+{
+    if (!active) return;
+    commit();
+    active = false;
+
+    // review starts from the base
+    view = base;
+    viewPlayer = basePlayer;
+    cursor = 0;
+    cursorAt = head;
+    cursorMs = 0.f;
+    playMs = 0.f;
+}
+
+void TickHistory::beginTick(float atMs)
+{
+    if (!active) return;
+    commit();
+    pendingMs = atMs;
+}
+
+void TickHistory::recordMove(Direction d, bool executed, bool moved, Direction prevFacing)
+{
+    if (!active) return;
+    pending.flags |= Move;
+    pending.move = (std::uint8_t)((int)d | (executed ? 4 : 0) | (moved ? 8 : 0) | (int)prevFacing << 4);
+}
+
+void TickHistory::recordPickup(int item)
+{
+    if (!active || item < 0) return;
+    pending.flags |= Pickup;
+    pending.item = (std::uint16_t)item;
+}
+
+void TickHistory::beforeHazards(const GridState& grid)
+{
+    if (!active) return;
+    ballsBefore.assign(grid.projectiles.begin(), grid.projectiles.end());
+    progressBefore.assign(grid.beams->progress.begin(), grid.beams->progress.end());
+}
+
+void TickHistory::afterHazards(const GridState& grid)
+{
+    if (!active) return;
+    pending.flags |= Hazards;
+
+    const std::vector<int>& progress = grid.beams->progress;
+    for (std::size_t i = 0; i < progress.size() && i < progressBefore.size(); ++i)
+        if (progress[i] != progressBefore[i])
+            pending.beams.push_back({(std::uint16_t)i, (std::int16_t)(progress[i] - progressBefore[i])});
+
+    // balls keep their order through a step: the survivors (moved one cell) come first, then the
+    // spawns. Matching in order is exact even for two identical balls, since either choice
+    // rebuilds the same list.
+    const std::vector<Projectile>& after = grid.projectiles;
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < ballsBefore.size(); ++i) {
+        const Projectile& b = ballsBefore[i];
+        if (j < after.size() && after[j].pos == b.pos + b.dir && after[j].dir == b.dir) ++j;
+        else pending.dead.push_back({(std::uint16_t)i, b});
+    }
+    for (; j < after.size(); ++j) pending.spawned.push_back(after[j]);
+}
+
+void TickHistory::commit()
+{
+    if (pending.flags == 0) return;
+    TRACE_SCOPE("TickHistory::commit");
+
+    float dt = std::max(0.f, std::min(pendingMs - committedMs, 65535.f));
+    pending.dtMs = (std::uint16_t)std::lround(dt);
+    committedMs += pending.dtMs;
+    encode(pending, encoded);
+    pending.reset();
+
+    // a single tick bigger than the whole ring (thousands of cannonballs): give up on this turn
+    if (encoded.size() > Capacity || encoded.size() > 0xFFFF) {
+        ticks = 0;
+        used = 0;
+        active = false;
+        return;
+    }
+
+    // full: fold the oldest ticks into the base
+    while (used + encoded.size() > Capacity) {
+        decode(head, scratch);
+        forward(base, basePlayer, scratch);
+        std::size_t size = get16(head);
+        head = (head + size) & Mask;
+        used -= size;
+        --ticks;
+        ++dropped;
+    }
+
+    std::size_t at = head + used;
+    for (std::uint8_t b : encoded) ring[at++ & Mask] = b;
+    used += encoded.size();
+    ++ticks;
+}
+
+// ---------------- Encoding ----------------
+
+void TickHistory::encode(const Delta& d, std::vector<std::uint8_t>& out) const
+{
+    out.clear();
+    put16(out, 0);   // size, patched below
+    put16(out, d.dtMs);
+    out.push_back(d.flags);
+    if (d.flags & Move) out.push_back(d.move);
+    if (d.flags & Pickup) put16(out, d.item);
+    if (d.flags & Hazards) {
+        put16(out, (std::uint16_t)d.beams.size());
+        for (auto& b : d.beams) {
+            put16(out, b.first);
+            put16(out, (std::uint16_t)b.second);
+        }
+        put16(out, (std::uint16_t)d.dead.size());
+        for (const DeadBall& b : d.dead) {
+            put16(out, b.index);
+            putBall(out, b.ball);
+        }
+        put16(out, (std::uint16_t)d.spawned.size());
+        for (const Projectile& b : d.spawned) putBall(out, b);
+    }
+
+    std::uint16_t size = (std::uint16_t)(out.size() + 2);
+    out[0] = (std::uint8_t)(size & 0xFF);
+    out[1] = (std::uint8_t)(size >> 8);
+    put16(out, size);
+}
+
+void TickHistory::decode(std::size_t at, Delta& d) const
+{
+    std::size_t p = at + 2;
+    auto u8 = [&]() { return ring[p++ & Mask]; };
+    auto u16 = [&]() { std::uint16_t v = get16(p); p += 2; return v; };
+    auto ball = [&]() {
+        Projectile b;
+        b.pos.x = (std::int16_t)u16();
+        b.pos.y = (std::int16_t)u16();
+        b.dir = delta((Direction)u8());
+        return b;
+    };
+
+    d.reset();
+    d.dtMs = u16();
+    d.flags = u8();
+    if (d.flags & Move) d.move = u8();
+    if (d.flags & Pickup) d.item = u16();
+    if (d.flags & Hazards) {
+        for (int n = u16(); n > 0; --n) {
+            std::uint16_t h = u16();
+            d.beams.push_back({h, (std::int16_t)u16()});
+        }
+        for (int n = u16(); n > 0; --n) {
+            std::uint16_t index = u16();
+            d.dead.push_back({index, ball()});
+        }
+        for (int n = u16(); n > 0; --n) d.spawned.push_back(ball());
+    }
+}
+
+// ---------------- Applying ticks ----------------
+
+void TickHistory::forward(GridState& g, PlayerState& p, const Delta& d)
+{
+    if (d.flags & Hazards) {
+        if (!d.beams.empty()) {
+            std::vector<int>& progress = g.beamsPool.writable(g.beams).progress;
+            for (auto& b : d.beams) progress[b.first] += b.second;
+        }
+        ++g.hazardStep;
+
+        ballScratch.clear();
+        std::size_t k = 0;
+        for (std::size_t i = 0; i < g.projectiles.size(); ++i) {
+            if (k < d.dead.size() && d.dead[k].index == i) { ++k; continue; }
+            Projectile b = g.projectiles[i];
+            b.pos += b.dir;
+            ballScratch.push_back(b);
+        }
+        ballScratch.insert(ballScratch.end(), d.spawned.begin(), d.spawned.end());
+        g.projectiles.swap(ballScratch);
+    }
+
+    if (d.flags & Pickup) g.itemsPool.writable(g.items)[d.item].collected = true;
+
+    if (d.flags & Move) {
+        Direction dir = (Direction)(d.move & 3);
+        if (d.move & 4) p.facing = dir;
+        if (d.move & 8) p.gridPos += delta(dir);
+    }
+
+    refreshBeams(g, d);
+}
+
+void TickHistory::backward(GridState& g, PlayerState& p, const Delta& d)
+{
+    if (d.flags & Move) {
+        Direction dir = (Direction)(d.move & 3);
+        if (d.move & 8) p.gridPos -= delta(dir);
+        p.facing = (Direction)((d.move >> 4) & 3);
+    }
+
+    if (d.flags & Pickup) g.itemsPool.writable(g.items)[d.item].collected = false;
+
+    if (d.flags & Hazards) {
+        --g.hazardStep;
+
+        // drop the spawns, step the survivors back and put the dead ones back where they were
+        std::size_t survivors = g.projectiles.size() - std::min(d.spawned.size(), g.projectiles.size());
+        ballScratch.clear();
+        std::size_t k = 0, s = 0;
+        for (std::size_t i = 0; i < survivors + d.dead.size(); ++i) {
+            if (k < d.dead.size() && d.dead[k].index == i) {
+                ballScratch.push_back(d.dead[k++].ball);
+                continue;
+            }
+            Projectile b = g.projectiles[s++];
+            b.pos -= b.dir;
+            ballScratch.push_back(b);
+        }
+        g.projectiles.swap(ballScratch);
+
+        if (!d.beams.empty()) {
+            std::vector<int>& progress = g.beamsPool.writable(g.beams).progress;
+            for (auto& b : d.beams) progress[b.first] -= b.second;
+        }
+    }
+
+    refreshBeams(g, d);
+}
+
+void TickHistory::refreshBeams(GridState& g, const Delta& d)
+{
+    // only the lasers this tick grew / shrank, and those reaching a chest it took or gave back
+    if (d.flags & Hazards)
+        for (auto& b : d.beams) g.refreshBeam(b.first);
+    if (d.flags & Pickup) g.refreshBeamsThrough(g.level->items[d.item].gridPos);
+}
+
+// ---------------- Review ----------------
+
+void TickHistory::seek(int tick)
+{
+    TRACE_SCOPE("TickHistory::seek");
+    if (active) return;
+    tick = std::max(0, std::min(tick, ticks));
+
+    while (cursor < tick) {
+        decode(cursorAt, scratch);
+        forward(view, viewPlayer, scratch);
+        cursorMs += scratch.dtMs;
+        cursorAt = (cursorAt + get16(cursorAt)) & Mask;
+        ++cursor;
+    }
+    while (cursor > tick) {
+        std::size_t start = recordBefore(cursorAt);
+        decode(start, scratch);
+        backward(view, viewPlayer, scratch);
+        cursorMs -= scratch.dtMs;
+        cursorAt = start;
+        --cursor;
+    }
+    playMs = cursorMs;
+}
+
+bool TickHistory::play(float ms)
+{
+    if (active || ticks == 0) return false;
+    float target = playMs + ms;
+
+    // the cursor shows the last tick that has happened by `target`
+    while (cursor < ticks && cursorMs + get16(cursorAt + 2) <= target) seek(cursor + 1);
+    while (cursor > 0 && cursorMs > target) seek(cursor - 1);
+    playMs = target;
+
+    if (ms > 0.f && cursor == ticks) { playMs = cursorMs; return false; }
+    if (ms < 0.f && target <= 0.f) { playMs = 0.f; return false; }
+    return true;
+}
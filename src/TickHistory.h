@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Grid.h"
+#include "Player.h"
+
+// TickHistory: the execution phase of the last turn, recorded tick by tick so it can be scrubbed
+// back and forth afterwards (R while planning). A tick only stores what it changed: the player's
+// step, a chest pickup, laser lengths that moved and which cannonballs died / spawned (every other
+// ball just moved one cell). Each record can be applied forwards and backwards.
+//
+// Records go into a fixed byte ring. When it's full the oldest ticks are folded into the base
+// state, so a long turn loses its start instead of growing memory; a normal turn takes 1-3 KB.
+class TickHistory {
+public:
+    static constexpr std::size_t Capacity = 8 * 1024;   // bytes, power of two
+
+    // ---- recording (execution phase) ----
+
+    // tick 0 = `grid` / `player` as they are now; drops the previous turn
+    void begin(const GridState& grid, const PlayerState& player);
+    void end();                          // commits the tick in progress and stops recording
+    bool recording() const { return active; }
+
+    // a new tick at `atMs` execution time (the recorded pace replays at); commits the previous one
+    void beginTick(float atMs);
+
+    // one planned move consumed: `executed` = taken (not blocked), `moved` = the cell changed
+    void recordMove(Direction d, bool executed, bool moved, Direction prevFacing);
+    void recordPickup(int item);
+    void beforeHazards(const GridState& grid);   // around stepHazards()
+    void afterHazards(const GridState& grid);
+
+    // ---- review ----
+
+    int tickCount() const { return ticks; }
+    int droppedTicks() const { return dropped; }   // folded into the base when the ring filled up
+    std::size_t bytesUsed() const { return used; }
+
+    // move the review state to just after tick `tick` (0 = execution start), clamped
+    void seek(int tick);
+    int position() const { return cursor; }
+
+    // playback: move the review time by `ms` (negative = backwards) and follow it tick by tick,
+    // at the pace the ticks were recorded. False once it hit either end.
+    bool play(float ms);
+
+    const GridState& grid() const { return view; }
+    const PlayerState& player() const { return viewPlayer; }
+
+private:
+    enum Flags : std::uint8_t { Move = 1, Pickup = 2, Hazards = 4 };
+
+    struct DeadBall {
+        std::uint16_t index;   // in the list before the step
+        Projectile ball;
+    };
+
+    // one tick, decoded
+    struct Delta {
+        std::uint16_t dtMs = 0;          // since the previous tick
+        std::uint8_t flags = 0;
+        std::uint8_t move = 0;           // dir | executed << 2 | moved << 3 | prevFacing << 4
+        std::uint16_t item = 0;
+        std::vector<std::pair<std::uint16_t, std::int16_t>> beams;   // hazard, progress change
+        std::vector<DeadBall> dead;      // ascending index
+        std::vector<Projectile> spawned; // appended after the survivors
+        void reset() { flags = 0; beams.clear(); dead.clear(); spawned.clear(); }
+    };
+
+    // record layout: u16 size, payload, u16 size (so the ring can be walked both ways)
+    void encode(const Delta& d, std::vector<std::uint8_t>& out) const;
+    void decode(std::size_t at, Delta& d) const;
+    std::size_t recordBefore(std::size_t end) const { return (end - get16(end - 2)) & Mask; }
+
+    std::uint16_t get16(std::size_t at) const
+    {
+        return (std::uint16_t)(ring[at & Mask] | ring[(at + 1) & Mask] << 8);
+    }
+
+    void forward(GridState& g, PlayerState& p, const Delta& d);
+    void backward(GridState& g, PlayerState& p, const Delta& d);
+    void refreshBeams(GridState& g, const Delta& d);   // the beam spans a tick touched
+
+    static constexpr std::size_t Mask = Capacity - 1;
+    std::array<std::uint8_t, Capacity> ring{};
+    std::size_t head = 0;   // oldest record
+    std::size_t used = 0;
+    int ticks = 0;
+    int dropped = 0;
+
+    // state at the oldest record / at the review cursor
+    GridState base;
+    PlayerState basePlayer;
+    GridState view;
+    PlayerState viewPlayer;
+    int cursor = 0;
+    std::size_t cursorAt = 0;   // ring offset of the record after the cursor
+    float cursorMs = 0.f;       // recorded time of the cursor tick
+    float playMs = 0.f;
+
+    // recording
+    void commit();   // the tick in progress (no-op if nothing happened in it)
+
+    bool active = false;
+    float pendingMs = 0.f;
+    float committedMs = 0.f;
+    Delta pending;
+    Delta scratch;                           // decode target while seeking
+    std::vector<std::uint8_t> encoded;
+    std::vector<Projectile> ballsBefore;
+    std::vector<int> progressBefore;
+    std::vector<Projectile> ballScratch;
+};
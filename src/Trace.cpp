@@ -0,0 +1,92 @@
+#include "Trace.h"
+
+#ifdef ENABLE_TRACING
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct TraceEvent {
+        const char* name;
+        std::int64_t startUs;
+        std::int64_t durUs;
+    };
+
+    // one buffer per thread; only the owning thread appends, so no locking on the hot path
+    struct ThreadBuffer {
+        static constexpr std::size_t Capacity = 1 << 18; // events kept per thread (~6 MB)
+        std::vector<TraceEvent> events;
+        std::uint32_t tid = 0;
+        bool overflowed = false;
+    };
+
+    std::mutex registryMutex;                              // guards buffer list (not the buffers)
+    std::vector<std::unique_ptr<ThreadBuffer>> registry;   // owned here so buffers outlive threads
+    const auto epoch = std::chrono::steady_clock::now();
+
+    ThreadBuffer& localBuffer()
+    {
+        thread_local ThreadBuffer* buf = nullptr;
+        if (!buf) {
+            auto fresh = std::make_unique<ThreadBuffer>();
+            fresh->events.reserve(ThreadBuffer::Capacity);
+            std::lock_guard<std::mutex> lock(registryMutex);
+            fresh->tid = (std::uint32_t)registry.size() + 1;
+            buf = fresh.get();
+            registry.push_back(std::move(fresh));
+        }
+        return *buf;
+    }
+}
+
+namespace Trace {
+
+std::int64_t nowMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record(const char* name, std::int64_t startUs, std::int64_t endUs)
+{
+    ThreadBuffer& b = localBuffer();
+    if (b.events.size() >= ThreadBuffer::Capacity) { b.overflowed = true; return; }
+    b.events.push_back({name, startUs, endUs - startUs});
+}
+
+bool writeJson(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    // NOTE: call when worker threads are idle; buffers are read without their owners' cooperation
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto& b : registry) {
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+            << ",\"args\":{\"name\":\"" << (b->tid == 1 ? "main" : "worker") << "\"}}";
+
+        for (auto& e : b->events) {
+            out << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"ts\":" << e.startUs << ",\"dur\":" << e.durUs << "}";
+        }
+        if (b->overflowed) {
+            out << ",\n{\"name\":\"trace buffer full\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << b->tid
+                << ",\"ts\":" << (b->events.empty() ? 0 : b->events.back().startUs) << "}";
+        }
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
+
+}
+
+#endif
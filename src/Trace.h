@@ -0,0 +1,44 @@
+#pragma once
+// Scoped trace events written as Chrome / Perfetto JSON ("traceEvents" format).
+//
+// Build with -DENABLE_TRACING to turn it on. Without it every macro below
+// expands to nothing, so instrumented code pays zero cost.
+//
+//   TRACE_SCOPE("Grid::computeBeams");   // times the enclosing scope
+//   TRACE_WRITE("trace.json");           // flush all thread buffers to disk
+//
+// Names must be string literals (only the pointer is stored).
+
+#ifdef ENABLE_TRACING
+
+#include <cstdint>
+#include <string>
+
+namespace Trace {
+    std::int64_t nowMicros();
+    void record(const char* name, std::int64_t startUs, std::int64_t endUs);
+    bool writeJson(const std::string& path);
+
+    class Scope {
+    public:
+        explicit Scope(const char* n) : name(n), start(nowMicros()) {}
+        ~Scope() { record(name, start, nowMicros()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name;
+        std::int64_t start;
+    };
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) ::Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_WRITE(path) ::Trace::writeJson(path)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_WRITE(path) ((void)0)
+
+#endif
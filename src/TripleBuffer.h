@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// TripleBuffer: hands whole values from one writer thread to one reader thread without either
+// ever waiting. The writer fills back(), then publish() swaps it with the shared middle slot;
+// the reader's fetch() swaps the middle slot with its front() if something new was published.
+// Both swaps are one atomic exchange, so the writer can publish as often as it likes and the
+// reader always sees the latest complete value (frames in between are simply skipped).
+//
+// Slots are reused, never reallocated: whatever a T keeps (vector capacity, ...) stays warm.
+template <class T>
+class TripleBuffer {
+public:
+    // writer thread
+    T& back() { return slots[backIndex]; }
+    void publish()
+    {
+        std::uint8_t old = middle.exchange(backIndex | Fresh, std::memory_order_acq_rel);
+        backIndex = old & IndexMask;
+    }
+
+    // reader thread: true if front() changed
+    bool fetch()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & Fresh)) return false;
+        std::uint8_t old = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = old & IndexMask;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static constexpr std::uint8_t IndexMask = 3;
+    static constexpr std::uint8_t Fresh = 4;   // the middle slot holds a value the reader hasn't taken
+
+    std::array<T, 3> slots{};
+    alignas(64) std::uint8_t backIndex = 0;        // writer only
+    alignas(64) std::atomic<std::uint8_t> middle{1};
+    alignas(64) std::uint8_t frontIndex = 2;       // reader only
+};
@@ -97,12 +97,12 @@ void ElevatedButton::update(sf::Time dt) {
     }
 }
 
-void ElevatedButton::draw(sf::RenderWindow& window) {
+void ElevatedButton::draw(sf::RenderTarget& window) {
     // compute pressed offset (visual only)
     float pressedOffset = pressed ? 1.5f : 0.f;
 
-    // draw shadow (copy of card)
-    sf::RectangleShape shadow = card;
+    // draw shadow (same geometry as card)
+    shadow.setSize(card.getSize());
     shadow.setFillColor(sf::Color(0,0,0,90));
     shadow.setOutlineThickness(0.f);
 
@@ -11,6 +11,7 @@ public:
                    const sf::Vector2f& size = {220.f, 48.f});
 
     void setPosition(const sf::Vector2f& pos);
+    sf::Vector2f getPosition() const { return card.getPosition(); }
     void setLabel(const std::string& s);
     void setCallback(std::function<void()> cb);
 
@@ -24,13 +25,14 @@ public:
     void update(sf::Time dt);
 
     // draw
-    void draw(sf::RenderWindow& window);
+    void draw(sf::RenderTarget& window);
 
     // check if point inside bounds
     bool contains(const sf::Vector2f& p) const;
 
 private:
     sf::RectangleShape card;
+    sf::RectangleShape shadow;              // kept as a member: copying a shape every draw allocates
     sf::Text labelText;
     const sf::Font* fontRef;                // pointer to font (non-owning)
 
@@ -1,7 +1,65 @@
 #include "Game.h"
+#include "Stress.h"
+#include "Thumbnail.h"
+#include "Trace.h"
+#include <cstdlib>
+#include <string>
 
-int main() {
-    Game game;
+int main(int argc, char** argv) {
+    // headless rule stress test: 10_Seconds_Ahead --stress [seconds] [--seed N]
+    if (argc > 1 && std::string(argv[1]) == "--stress") {
+        StressOptions opts;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--seed" && i + 1 < argc) opts.seed = (std::uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            else opts.seconds = std::atof(arg.c_str());
+        }
+        return runStress(opts);
+    }
+
+    // steady-state allocation check (TRACK_ALLOCS builds): 10_Seconds_Ahead --alloc-check [runs] [--seed N]
+    if (argc > 1 && std::string(argv[1]) == "--alloc-check") {
+        AllocCheckOptions opts;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--seed" && i + 1 < argc) opts.seed = (std::uint32_t)std::strtoul(argv[++i], nullptr, 10);
+            else opts.runs = std::atoi(arg.c_str());
+        }
+        return runAllocCheck(opts);
+    }
+
+    // headless per-frame allocation check (TRACK_ALLOCS builds): 10_Seconds_Ahead --frame-check [seconds]
+    if (argc > 1 && std::string(argv[1]) == "--frame-check") {
+        FrameCheckOptions opts;
+        if (argc > 2) opts.seconds = std::atof(argv[2]);
+        Game game(ExecSpeed::Normal, true);
+        return game.runFrameCheck(opts);
+    }
+
+    // headless level previews: 10_Seconds_Ahead --thumbnails <outDir> [--size N] [level files / dirs...]
+    if (argc > 2 && std::string(argv[1]) == "--thumbnails") {
+        ThumbnailOptions opts;
+        opts.outDir = argv[2];
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--size" && i + 1 < argc) opts.size = (unsigned)std::strtoul(argv[++i], nullptr, 10);
+            else opts.inputs.push_back(arg);
+        }
+        return runThumbnails(opts);
+    }
+
+    // execution speed: 10_Seconds_Ahead --speed 1|2|4|instant
+    ExecSpeed speed = ExecSpeed::Normal;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "--speed") continue;
+        std::string v = argv[i + 1];
+        if (v == "2") speed = ExecSpeed::Double;
+        else if (v == "4") speed = ExecSpeed::Quad;
+        else if (v == "instant") speed = ExecSpeed::Instant;
+    }
+
+    Game game(speed);
     game.run();
+    TRACE_WRITE("trace.json");
     return 0;
 }